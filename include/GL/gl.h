@@ -44,6 +44,8 @@ extern "C" {
 #include <windows.h>
 #endif
 
+#include <stddef.h>
+
 #ifndef APIENTRY
 #define APIENTRY
 #endif
@@ -64,6 +66,8 @@ typedef unsigned int GLuint;
 typedef float GLfloat;
 typedef float GLclampf;
 typedef void GLvoid;
+typedef ptrdiff_t GLintptrARB;
+typedef ptrdiff_t GLsizeiptrARB;
 /* Internal convenience typedefs */
 typedef void (*_GLfuncptr)();
 
@@ -73,6 +77,11 @@ typedef void (*_GLfuncptr)();
 #define GL_OES_SC_VERSION_1_0             1
 #define GL_OES_single_precision           1
 #define GL_EXT_paletted_texture           1
+#define GL_OES_vertex_half_float          1
+#define GL_ARB_vertex_buffer_object       1
+#define GL_EXT_compiled_vertex_array      1
+#define GL_EXT_multi_draw_arrays          1
+#define GL_VPMT_instanced_modelview       1
 
 /* ClearBufferMask */
 #define GL_DEPTH_BUFFER_BIT               0x00000100
@@ -338,6 +347,7 @@ typedef void (*_GLfuncptr)();
 #define GL_UNSIGNED_SHORT                 0x1403
 #define GL_INT                            0x1404
 #define GL_UNSIGNED_INT                   0x1405
+#define GL_FIXED                          0x140C
 
 /* LogicOp */
 
@@ -501,14 +511,33 @@ typedef void (*_GLfuncptr)();
 #define GL_COLOR_TABLE_LUMINANCE_SIZE_EXT 0x80DE
 #define GL_COLOR_TABLE_INTENSITY_SIZE_EXT 0x80DF
 
+/* Vertex Half Float Extension */
+#define GL_HALF_FLOAT_OES                 0x8D61
+
+/* Vertex Buffer Object Extension */
+#define GL_ARRAY_BUFFER_ARB               0x8892
+#define GL_ELEMENT_ARRAY_BUFFER_ARB       0x8893
+#define GL_ARRAY_BUFFER_BINDING_ARB       0x8894
+#define GL_ELEMENT_ARRAY_BUFFER_BINDING_ARB 0x8895
+#define GL_STREAM_DRAW_ARB                0x88E0
+#define GL_STATIC_DRAW_ARB                0x88E4
+#define GL_DYNAMIC_DRAW_ARB               0x88E8
+
+/* Compiled Vertex Array Extension */
+#define GL_ARRAY_ELEMENT_LOCK_FIRST_EXT   0x81A8
+#define GL_ARRAY_ELEMENT_LOCK_COUNT_EXT   0x81A9
+
 /*************************************************************/
 
 GLAPI void APIENTRY glActiveTexture (GLenum texture);
 GLAPI void APIENTRY glAlphaFunc (GLenum func, GLclampf ref);
 GLAPI void APIENTRY glBegin(GLenum mode);
+GLAPI void APIENTRY glBindBufferARB (GLenum target, GLuint buffer);
 GLAPI void APIENTRY glBindTexture (GLenum target, GLuint texture);
 GLAPI void APIENTRY glBitmap (GLsizei width, GLsizei height, GLfloat xorig, GLfloat yorig, GLfloat xmove, GLfloat ymove, const GLubyte *bitmap);
 GLAPI void APIENTRY glBlendFunc (GLenum sfactor, GLenum dfactor);
+GLAPI void APIENTRY glBufferDataARB (GLenum target, GLsizeiptrARB size, const GLvoid *data, GLenum usage);
+GLAPI void APIENTRY glBufferSubDataARB (GLenum target, GLintptrARB offset, GLsizeiptrARB size, const GLvoid *data);
 GLAPI void APIENTRY glCallLists (GLsizei n, GLenum type, const GLvoid *lists);
 GLAPI void APIENTRY glClear (GLbitfield mask);
 GLAPI void APIENTRY glClearColor (GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha);
@@ -524,13 +553,16 @@ GLAPI void APIENTRY glColorSubTableEXT (GLenum target, GLsizei start, GLsizei co
 GLAPI void APIENTRY glColorTableEXT (GLenum target, GLenum internalformat, GLsizei width, GLenum format, GLenum type, const GLvoid *table);
 GLAPI void APIENTRY glCopyPixels (GLint x, GLint y, GLsizei width, GLsizei height, GLenum type);
 GLAPI void APIENTRY glCullFace (GLenum mode);
+GLAPI void APIENTRY glDeleteBuffersARB (GLsizei n, const GLuint *buffers);
 GLAPI void APIENTRY glDepthFunc (GLenum func);
 GLAPI void APIENTRY glDepthMask (GLboolean flag);
 GLAPI void APIENTRY glDepthRangef (GLclampf zNear, GLclampf zFar);
 GLAPI void APIENTRY glDisable (GLenum cap);
 GLAPI void APIENTRY glDisableClientState (GLenum array);
 GLAPI void APIENTRY glDrawArrays (GLenum mode, GLint first, GLsizei count);
+GLAPI void APIENTRY glDrawArraysInstancedVPMT (GLenum mode, GLint first, GLsizei count, GLsizei primcount, const GLfloat *modelviews);
 GLAPI void APIENTRY glDrawElements (GLenum mode, GLsizei count, GLenum type, const GLvoid *indices);
+GLAPI void APIENTRY glDrawElementsInstancedVPMT (GLenum mode, GLsizei count, GLenum type, const GLvoid *indices, GLsizei primcount, const GLfloat *modelviews);
 GLAPI void APIENTRY glDrawPixels (GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid *pixels);
 GLAPI void APIENTRY glEnable (GLenum cap);
 GLAPI void APIENTRY glEnableClientState (GLenum array);
@@ -540,6 +572,7 @@ GLAPI void APIENTRY glFinish (void);
 GLAPI void APIENTRY glFlush (void);
 GLAPI void APIENTRY glFrontFace (GLenum mode);
 GLAPI void APIENTRY glFrustumf (GLfloat left, GLfloat right, GLfloat bottom, GLfloat top, GLfloat zNear, GLfloat zFar);
+GLAPI void APIENTRY glGenBuffersARB (GLsizei n, GLuint *buffers);
 GLAPI GLuint APIENTRY glGenLists (GLsizei range);
 GLAPI void APIENTRY glGenTextures (GLsizei n, GLuint *textures);
 GLAPI GLenum APIENTRY glGetError (void);
@@ -565,11 +598,14 @@ GLAPI void APIENTRY glLineStipple (GLint factor, GLushort pattern);
 GLAPI void APIENTRY glLineWidth (GLfloat width);
 GLAPI void APIENTRY glListBase (GLuint base);
 GLAPI void APIENTRY glLoadIdentity (void);
+GLAPI void APIENTRY glLockArraysEXT (GLint first, GLsizei count);
 GLAPI void APIENTRY glLoadMatrixf (const GLfloat *m);
 GLAPI void APIENTRY glMaterialf (GLenum face, GLenum pname, GLfloat param);
 GLAPI void APIENTRY glMaterialfv (GLenum face, GLenum pname, const GLfloat *params);
 GLAPI void APIENTRY glMatrixMode (GLenum mode);
 GLAPI void APIENTRY glMultMatrixf (const GLfloat *m);
+GLAPI void APIENTRY glMultiDrawArraysEXT (GLenum mode, const GLint *first, const GLsizei *count, GLsizei primcount);
+GLAPI void APIENTRY glMultiDrawElementsEXT (GLenum mode, const GLsizei *count, GLenum type, const GLvoid* *indices, GLsizei primcount);
 GLAPI void APIENTRY glMultiTexCoord2f (GLenum target, GLfloat s, GLfloat t);
 GLAPI void APIENTRY glNewList (GLuint list, GLenum mode);
 GLAPI void APIENTRY glNormal3f (GLfloat nx, GLfloat ny, GLfloat nz);
@@ -598,6 +634,7 @@ GLAPI void APIENTRY glTexImage2D (GLenum target, GLint level, GLint internalform
 GLAPI void APIENTRY glTexParameteri (GLenum target, GLenum pname, GLint param);
 GLAPI void APIENTRY glTexSubImage2D (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid *pixels);
 GLAPI void APIENTRY glTranslatef (GLfloat x, GLfloat y, GLfloat z);
+GLAPI void APIENTRY glUnlockArraysEXT (void);
 GLAPI void APIENTRY glVertex2f (GLfloat x, GLfloat y);
 GLAPI void APIENTRY glVertex2fv (const GLfloat *v);
 GLAPI void APIENTRY glVertex3f (GLfloat x, GLfloat y, GLfloat z);
@@ -14,6 +14,9 @@
 #include "GL/gl.h"
 #include "context.h"
 #include "dispatch.h"
+#include "exec.h"
+#include "vertex.h"
+#include "buffer.h"
 
 /*
 ** -------------------------------------------------------------------------
@@ -218,69 +221,1123 @@ static void FetchFloat(const VPMT_Array * array, GLsizei index, GLfloat * result
 	}
 }
 
+static GLfloat HalfToFloat(GLushort value)
+{
+	union {
+		GLuint u;
+		GLfloat f;
+	} bits;
+
+	GLuint sign = (value & 0x8000u) << 16;
+	GLuint exponent = (value >> 10) & 0x1f;
+	GLuint mantissa = value & 0x3ff;
+
+	if (exponent == 0x1f) {
+		/* infinity or NaN */
+		bits.u = sign | 0x7f800000u | (mantissa << 13);
+	} else if (exponent) {
+		bits.u = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+	} else {
+		/* zero or denormal */
+		bits.f = mantissa * (1.0f / 16777216.0f);
+		bits.u |= sign;
+	}
+
+	return bits.f;
+}
+
+static void FetchHalfFloat(const VPMT_Array * array, GLsizei index, GLfloat * result)
+{
+	const void *address = (const GLbyte *) array->pointer + index * array->effectiveStride;
+	const GLushort *values = (const GLushort *) address;
+
+	switch (array->size) {
+	default:
+	case 4:
+		result[3] = HalfToFloat(values[3]);
+
+	case 3:
+		result[2] = HalfToFloat(values[2]);
+
+	case 2:
+		result[1] = HalfToFloat(values[1]);
+
+	case 1:
+		result[0] = HalfToFloat(values[0]);
+	}
+}
+
 static void FetchError(const VPMT_Array * array, GLsizei index, GLfloat * result)
 {
 	/* nop */
 }
 
+#if GL_ARB_vertex_buffer_object
+
+/*
+** Elements of arrays sourced from buffer objects have been converted when
+** the buffer contents were specified; elements beyond the buffer read as 0.
+*/
+static void FetchStream(const VPMT_Array * array, GLsizei index, GLfloat * result)
+{
+	const VPMT_BufferStream *stream = array->stream;
+	GLsizei k;
+
+	if (index >= 0 && index < stream->count) {
+		for (k = 0; k < array->size; ++k) {
+			result[k] = stream->values[k * stream->rowStride + index];
+		}
+	} else {
+		for (k = 0; k < array->size; ++k) {
+			result[k] = 0.0f;
+		}
+	}
+}
+
+#endif
+
 static VPMT_INLINE void FetchArray(const VPMT_Array * array, GLsizei index, GLfloat * result)
 {
 	array->fetch(array, index, result);
 }
 
+/*
+** Apply the scale and bias of compact array formats to fetched values. The
+** batched vertex paths fold them into the transformation instead.
+*/
+static VPMT_INLINE void Dequantize(const VPMT_Array * array, GLfloat * values, GLsizei size)
+{
+	GLsizei index;
+
+	if (array->scale != 1.0f || array->bias != 0.0f) {
+		for (index = 0; index < size; ++index) {
+			values[index] = values[index] * array->scale + array->bias;
+		}
+	}
+}
+
+/*
+** --------------------------------------------------------------------------
+** Bulk conversion of consecutive array elements into vertex batches
+** --------------------------------------------------------------------------
+*/
+
+/*
+** Generic conversion, fetching one element at a time.
+*/
+static void ConvertElements(const VPMT_Array * array, GLint first, GLsizei count, GLsizei size,
+							GLfloat (*result)[VPMT_VERTEX_BATCH])
+{
+	GLsizei n, k;
+
+	size = VPMT_MIN(size, array->size);
+
+	for (n = 0; n < count; ++n) {
+		VPMT_Vec4 values;
+
+		FetchArray(array, first + n, values);
+
+		for (k = 0; k < size; ++k) {
+			result[k][n] = values[k];
+		}
+	}
+}
+
+#if GL_ARB_vertex_buffer_object
+
+/*
+** The component rows of a buffer stream are copied into the batch as is.
+*/
+static void ConvertStream(const VPMT_Array * array, GLint first, GLsizei count, GLsizei size,
+						  GLfloat (*result)[VPMT_VERTEX_BATCH])
+{
+	const VPMT_BufferStream *stream = array->stream;
+	GLsizei valid = 0, n, k;
+
+	if (first >= 0 && first < stream->count) {
+		valid = VPMT_MIN(count, stream->count - first);
+	}
+
+	size = VPMT_MIN(size, array->size);
+
+	for (k = 0; k < size; ++k) {
+		if (valid) {
+			memcpy(result[k], stream->values + k * stream->rowStride + first,
+				   valid * sizeof(GLfloat));
+		}
+
+		for (n = valid; n < count; ++n) {
+			result[k][n] = 0.0f;
+		}
+	}
+}
+
+#endif
+
+#if defined(VPMT_SSE2)
+#	include <emmintrin.h>
+
+/*
+** Elements are converted four at a time. Each element is loaded as four
+** components, and the four elements are transposed into the components of
+** the batch. Loading four components may read past the end of an element
+** with fewer components; this is safe as long as enough elements follow,
+** i.e. for all but the last 3 / size elements, which are fetched instead.
+*/
+
+static VPMT_INLINE __m128 LoadFetch(const VPMT_Array * array, GLint index)
+{
+	VPMT_Vec4 values;
+
+	FetchArray(array, index, values);
+	return _mm_loadu_ps(values);
+}
+
+static VPMT_INLINE __m128i LoadBytes(const GLubyte * address)
+{
+	int bytes;
+
+	memcpy(&bytes, address, sizeof(bytes));
+	return _mm_cvtsi32_si128(bytes);
+}
+
+static VPMT_INLINE __m128i LoadUnsignedByteLanes(const GLubyte * address)
+{
+	__m128i zero = _mm_setzero_si128();
+
+	return _mm_unpacklo_epi16(_mm_unpacklo_epi8(LoadBytes(address), zero), zero);
+}
+
+static VPMT_INLINE __m128 LoadByteNormalize(const GLubyte * address)
+{
+	/* same as VPMT_BYTE_TO_FLOAT */
+	__m128i values = LoadUnsignedByteLanes(address);
+
+	values = _mm_add_epi32(_mm_add_epi32(values, values), _mm_set1_epi32(1));
+	return _mm_mul_ps(_mm_cvtepi32_ps(values), _mm_set1_ps(1.0f / 255.0f));
+}
+
+static VPMT_INLINE __m128 LoadUnsignedByteNormalize(const GLubyte * address)
+{
+	return _mm_mul_ps(_mm_cvtepi32_ps(LoadUnsignedByteLanes(address)),
+					  _mm_set1_ps(1.0f / 255.0f));
+}
+
+static VPMT_INLINE __m128 LoadShort(const GLubyte * address)
+{
+	__m128i values = _mm_loadl_epi64((const __m128i *) address);
+
+	return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(values, values), 16));
+}
+
+static VPMT_INLINE __m128 LoadUnsignedShort(const GLubyte * address)
+{
+	__m128i values = _mm_loadl_epi64((const __m128i *) address);
+
+	return _mm_cvtepi32_ps(_mm_unpacklo_epi16(values, _mm_setzero_si128()));
+}
+
+static VPMT_INLINE __m128 LoadInt(const GLubyte * address)
+{
+	return _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *) address));
+}
+
+static VPMT_INLINE __m128 LoadUnsignedInt(const GLubyte * address)
+{
+	/* both halves convert exactly, so the sum is rounded only once */
+	__m128i values = _mm_loadu_si128((const __m128i *) address);
+	__m128 high = _mm_cvtepi32_ps(_mm_srli_epi32(values, 16));
+	__m128 low = _mm_cvtepi32_ps(_mm_and_si128(values, _mm_set1_epi32(0xffff)));
+
+	return _mm_add_ps(_mm_mul_ps(high, _mm_set1_ps(65536.0f)), low);
+}
+
+static VPMT_INLINE __m128 LoadHalfFloat(const GLubyte * address)
+{
+	/*
+	** Shifted into place, exponent and mantissa form a float that is too
+	** small by 2^112, the difference in exponent bias; this also holds for
+	** denormals. Infinity and NaN keep their maximum exponent.
+	*/
+	__m128i values = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *) address),
+										_mm_setzero_si128());
+	__m128i sign = _mm_slli_epi32(_mm_and_si128(values, _mm_set1_epi32(0x8000)), 16);
+	__m128i bits = _mm_and_si128(values, _mm_set1_epi32(0x7fff));
+	__m128i special = _mm_and_si128(_mm_cmpgt_epi32(bits, _mm_set1_epi32(0x7bff)),
+									_mm_set1_epi32(0x7f800000));
+	__m128 result = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(bits, 13)),
+							   _mm_castsi128_ps(_mm_set1_epi32(0x77800000)));
+
+	return _mm_or_ps(result, _mm_castsi128_ps(_mm_or_si128(special, sign)));
+}
+
+static VPMT_INLINE __m128 LoadFloat(const GLubyte * address)
+{
+	return _mm_loadu_ps((const GLfloat *) address);
+}
+
+/*
+** Store the first size components of four elements at n in the batch.
+*/
+static VPMT_INLINE void StoreLanes(GLfloat (*result)[VPMT_VERTEX_BATCH], GLsizei n,
+								   GLsizei size, __m128 * lanes)
+{
+	_MM_TRANSPOSE4_PS(lanes[0], lanes[1], lanes[2], lanes[3]);
+
+	switch (size) {
+	default:
+	case 4:
+		_mm_storeu_ps(result[3] + n, lanes[3]);
+
+	case 3:
+		_mm_storeu_ps(result[2] + n, lanes[2]);
+
+	case 2:
+		_mm_storeu_ps(result[1] + n, lanes[1]);
+
+	case 1:
+		_mm_storeu_ps(result[0] + n, lanes[0]);
+	}
+}
+
+/*
+** The batch holds a multiple of four vertices, so that the last group of
+** elements can be stored in full even if fewer elements are converted.
+*/
+#define CONVERT_FUNCTION(name, load) \
+	static void name(const VPMT_Array * array, GLint first, GLsizei count, GLsizei size,	\
+					 GLfloat (*result)[VPMT_VERTEX_BATCH])									\
+	{																						\
+		const GLubyte *address =															\
+			(const GLubyte *) array->pointer + first * array->effectiveStride;				\
+		GLsizei safe = count - 3 / array->size, n, lane;									\
+																							\
+		for (n = 0; n < count; n += 4) {													\
+			__m128 lanes[4];																\
+																							\
+			for (lane = 0; lane < 4; ++lane) {												\
+				GLsizei index = VPMT_MIN(n + lane, count - 1);								\
+																							\
+				lanes[lane] = index < safe ?												\
+					load(address + index * array->effectiveStride) :						\
+					LoadFetch(array, first + index);										\
+			}																				\
+																							\
+			StoreLanes(result, n, VPMT_MIN(size, array->size), lanes);						\
+		}																					\
+	}
+
+CONVERT_FUNCTION(ConvertByteNormalize, LoadByteNormalize)
+CONVERT_FUNCTION(ConvertUnsignedByteNormalize, LoadUnsignedByteNormalize)
+CONVERT_FUNCTION(ConvertShort, LoadShort)
+CONVERT_FUNCTION(ConvertUnsignedShort, LoadUnsignedShort)
+CONVERT_FUNCTION(ConvertInt, LoadInt)
+CONVERT_FUNCTION(ConvertUnsignedInt, LoadUnsignedInt)
+CONVERT_FUNCTION(ConvertHalfFloat, LoadHalfFloat)
+CONVERT_FUNCTION(ConvertStridedFloat, LoadFloat)
+
+/*
+** Tightly packed float arrays need no conversion at all; four elements are
+** loaded as whole vectors and only redistributed into components.
+*/
+static void ConvertFloat(const VPMT_Array * array, GLint first, GLsizei count, GLsizei size,
+						 GLfloat (*result)[VPMT_VERTEX_BATCH])
+{
+	const GLfloat *values = (const GLfloat *) array->pointer + first * array->size;
+	GLsizei n = 0;
+
+	if (array->effectiveStride != array->size * (GLsizei) sizeof(GLfloat)) {
+		ConvertStridedFloat(array, first, count, size, result);
+		return;
+	}
+
+	switch (array->size) {
+	case 2:
+		for (; n + 4 <= count; n += 4, values += 8) {
+			__m128 a = _mm_loadu_ps(values), b = _mm_loadu_ps(values + 4);
+
+			_mm_storeu_ps(result[0] + n, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+
+			if (size > 1) {
+				_mm_storeu_ps(result[1] + n, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+			}
+		}
+
+		break;
+
+	case 3:
+		for (; n + 4 <= count; n += 4, values += 12) {
+			__m128 a = _mm_loadu_ps(values), b = _mm_loadu_ps(values + 4);
+			__m128 c = _mm_loadu_ps(values + 8);
+
+			_mm_storeu_ps(result[0] + n,
+						  _mm_shuffle_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 0, 0)),
+										 _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)),
+										 _MM_SHUFFLE(2, 0, 2, 0)));
+
+			if (size > 1) {
+				_mm_storeu_ps(result[1] + n,
+							  _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)),
+											 _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)),
+											 _MM_SHUFFLE(2, 0, 2, 0)));
+			}
+
+			if (size > 2) {
+				_mm_storeu_ps(result[2] + n,
+							  _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)),
+											 _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)),
+											 _MM_SHUFFLE(2, 0, 2, 0)));
+			}
+		}
+
+		break;
+
+	default:
+		ConvertStridedFloat(array, first, count, size, result);
+		return;
+	}
+
+	if (n < count) {
+		/* remaining elements of the last group */
+		__m128 lanes[4];
+		GLsizei lane;
+
+		for (lane = 0; lane < 4; ++lane) {
+			lanes[lane] = LoadFetch(array, first + VPMT_MIN(n + lane, count - 1));
+		}
+
+		StoreLanes(result, n, VPMT_MIN(size, array->size), lanes);
+	}
+}
+
+#else
+
+#	define ConvertByteNormalize			ConvertElements
+#	define ConvertUnsignedByteNormalize	ConvertElements
+#	define ConvertShort					ConvertElements
+#	define ConvertUnsignedShort			ConvertElements
+#	define ConvertInt					ConvertElements
+#	define ConvertUnsignedInt			ConvertElements
+#	define ConvertHalfFloat				ConvertElements
+#	define ConvertFloat					ConvertElements
+
+#endif
+
 static void SetArray(VPMT_Array * array, GLint size, GLenum type, GLsizei stride,
 					 const GLvoid * pointer)
 {
 
 	GLsizei elementSize;
 
+#if GL_ARB_vertex_buffer_object
+	if (array->stream) {
+		VPMT_BufferStreamRelease(array->stream);
+		array->stream = NULL;
+	}
+#endif
+
 	array->pointer = pointer;
 	array->size = size;
 	array->stride = stride;
 	array->type = type;
+	array->scale = 1.0f;
+	array->bias = 0.0f;
+
+	switch (type) {
+	case GL_BYTE:
+		elementSize = sizeof(GLbyte);
+		array->fetch = FetchByteNormalize;
+		array->convert = ConvertByteNormalize;
+		break;
+	case GL_UNSIGNED_BYTE:
+		elementSize = sizeof(GLubyte);
+		array->fetch = FetchUnsignedByteNormalize;
+		array->convert = ConvertUnsignedByteNormalize;
+		break;
+	case GL_SHORT:
+		elementSize = sizeof(GLshort);
+		array->fetch = FetchShort;
+		array->convert = ConvertShort;
+		break;
+	case GL_UNSIGNED_SHORT:
+		elementSize = sizeof(GLushort);
+		array->fetch = FetchUnsignedShort;
+		array->convert = ConvertUnsignedShort;
+		break;
+	case GL_INT:
+		elementSize = sizeof(GLint);
+		array->fetch = FetchInt;
+		array->convert = ConvertInt;
+		break;
+	case GL_UNSIGNED_INT:
+		elementSize = sizeof(GLuint);
+		array->fetch = FetchUnsignedInt;
+		array->convert = ConvertUnsignedInt;
+		break;
+	case GL_FIXED:
+		/* 16.16 fixed point values are converted as integers and scaled later */
+		elementSize = sizeof(GLint);
+		array->fetch = FetchInt;
+		array->convert = ConvertInt;
+		array->scale = 1.0f / 65536.0f;
+		break;
+	case GL_HALF_FLOAT_OES:
+		elementSize = sizeof(GLushort);
+		array->fetch = FetchHalfFloat;
+		array->convert = ConvertHalfFloat;
+		break;
+	case GL_FLOAT:
+		elementSize = sizeof(GLfloat);
+		array->fetch = FetchFloat;
+		array->convert = ConvertFloat;
+		break;
+	default:
+		assert(GL_FALSE);
+		elementSize = 0;
+		array->fetch = FetchError;
+		array->convert = ConvertElements;
+	}
+
+	if (stride) {
+		array->effectiveStride = stride;
+	} else {
+		array->effectiveStride = size * elementSize;
+	}
+}
+
+#if GL_ARB_vertex_buffer_object
+
+/*
+** Source a newly specified array from the buffer bound to the array buffer
+** target, if any, in which case the pointer of the array is an offset into
+** the buffer. The array then reads the stream converted from the buffer.
+*/
+static void SourceBuffer(VPMT_Context * context, VPMT_Array * array)
+{
+	if (!context->arrayBuffer) {
+		return;
+	}
+
+	array->stream = VPMT_BufferStreamAcquire(context->arrayBuffer, array,
+											 (GLintptrARB) array->pointer);
+
+	if (!array->stream) {
+		VPMT_OUT_OF_MEMORY(context);
+		VPMT_ArrayDetachBuffer(array);
+		return;
+	}
+
+	/* the stream holds dequantized values */
+	array->fetch = FetchStream;
+	array->convert = ConvertStream;
+	array->scale = 1.0f;
+	array->bias = 0.0f;
+}
+
+#endif
+
+/*
+** --------------------------------------------------------------------------
+** Reuse of transformed vertices across the indices of DrawElements
+** --------------------------------------------------------------------------
+*/
+
+static VPMT_INLINE GLuint ElementIndex(GLenum type, const GLvoid * indices, GLsizei n)
+{
+	switch (type) {
+	case GL_UNSIGNED_BYTE:
+		return ((const GLubyte *) indices)[n];
+
+	case GL_UNSIGNED_SHORT:
+		return ((const GLushort *) indices)[n];
+
+	default:
+		return ((const GLuint *) indices)[n];
+	}
+}
+
+/*
+** An attribute loaded into the vertex batch, either from its array, or from
+** the current value if the array is disabled.
+*/
+typedef struct Attribute {
+	const VPMT_Array *array;								   /* source array */
+	const GLfloat *current;									   /* value if array disabled */
+	GLfloat (*result)[VPMT_VERTEX_BATCH];					   /* batch components */
+	GLsizei size;											   /* number of components */
+} Attribute;
+
+/* components not provided by an array */
+static const GLfloat Defaults[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+static VPMT_INLINE GLint Element(GLint first, const GLuint * elements, GLsizei n)
+{
+	return elements ? (GLint) elements[n] : first + n;
+}
+
+static void LoadAttribute(const Attribute * attribute, GLint first, const GLuint * elements,
+						  GLsizei count)
+{
+	GLsizei n, k;
+
+	if (!attribute->array->enabled) {
+		for (k = 0; k < attribute->size; ++k) {
+			for (n = 0; n < count; ++n) {
+				attribute->result[k][n] = attribute->current[k];
+			}
+		}
+	} else if (!elements) {
+		attribute->array->convert(attribute->array, first, count, attribute->size,
+								  attribute->result);
+
+		for (k = attribute->array->size; k < attribute->size; ++k) {
+			for (n = 0; n < count; ++n) {
+				attribute->result[k][n] = Defaults[k];
+			}
+		}
+	} else {
+		for (n = 0; n < count; ++n) {
+			VPMT_Vec4 values;
+
+			VPMT_Vec4Copy(values, Defaults);
+			FetchArray(attribute->array, Element(first, elements, n), values);
+
+			for (k = 0; k < attribute->size; ++k) {
+				attribute->result[k][n] = values[k];
+			}
+		}
+	}
+}
+
+/*
+** Float arrays sharing their stride and pointing into the same records are
+** interleaved, and are loaded in a single pass over the records. Returns
+** GL_FALSE if the enabled arrays are not interleaved.
+*/
+static GLboolean LoadInterleaved(const Attribute * attributes, GLsizei numAttributes,
+								 GLint first, const GLuint * elements, GLsizei count)
+{
+	const GLubyte *base = attributes[0].array->pointer;
+	GLsizei stride = attributes[0].array->effectiveStride;
+	GLsizei offsets[3 + VPMT_MAX_TEX_UNITS];
+	GLsizei enabled[3 + VPMT_MAX_TEX_UNITS];
+	GLsizei numEnabled = 0, index, n, k;
+
+	for (index = 0; index < numAttributes; ++index) {
+		const VPMT_Array *array = attributes[index].array;
+
+		if (array->enabled) {
+			GLsizei offset = (const GLubyte *) array->pointer - base;
+
+			if (array->type != GL_FLOAT || array->stream || array->effectiveStride != stride ||
+				offset <= -stride || offset >= stride) {
+				return GL_FALSE;
+			}
+
+			offsets[numEnabled] = offset;
+			enabled[numEnabled++] = index;
+		}
+	}
+
+	if (numEnabled < 2) {
+		return GL_FALSE;
+	}
+
+	for (n = 0; n < count; ++n) {
+		const GLubyte *record = base + Element(first, elements, n) * stride;
+
+		for (index = 0; index < numEnabled; ++index) {
+			const Attribute *attribute = attributes + enabled[index];
+			const GLfloat *values = (const GLfloat *) (record + offsets[index]);
+
+			for (k = 0; k < attribute->size; ++k) {
+				attribute->result[k][n] = k < attribute->array->size ? values[k] : Defaults[k];
+			}
+		}
+	}
+
+	for (index = 0; index < numAttributes; ++index) {
+		if (!attributes[index].array->enabled) {
+			LoadAttribute(attributes + index, first, elements, count);
+		}
+	}
+
+	return GL_TRUE;
+}
+
+/*
+** Load the attributes of count array elements into the vertex batch, as they
+** would be specified by VPMT_ExecArrayElement. The elements are first,
+** first + 1, ..., or the given indices if elements is not NULL. Consecutive
+** elements are converted in bulk one attribute at a time, while scattered
+** elements of interleaved arrays are read one record at a time.
+*/
+static void LoadElements(VPMT_Context * context, VPMT_VertexBatch * batch, GLint first,
+						 const GLuint * elements, GLsizei count)
+{
+	Attribute attributes[3 + VPMT_MAX_TEX_UNITS];
+	GLsizei numAttributes = 0, unit, index;
+
+	attributes[numAttributes].array = &context->vertexArray;
+	attributes[numAttributes].current = Defaults;
+	attributes[numAttributes].result = batch->coords;
+	attributes[numAttributes++].size = 3;
+
+	attributes[numAttributes].array = &context->colorArray;
+	attributes[numAttributes].current = context->color;
+	attributes[numAttributes].result = batch->colors;
+	attributes[numAttributes++].size = 4;
+
+	if (context->lightingEnabled) {
+		attributes[numAttributes].array = &context->normalArray;
+		attributes[numAttributes].current = context->normal;
+		attributes[numAttributes].result = batch->normals;
+		attributes[numAttributes++].size = 3;
+	}
+
+	for (unit = 0; unit < VPMT_MAX_TEX_UNITS; ++unit) {
+		attributes[numAttributes].array = &context->texCoordArray[unit];
+		attributes[numAttributes].current = context->texCoords[unit];
+		attributes[numAttributes].result = batch->texCoords[unit];
+		attributes[numAttributes++].size = 2;
+	}
+
+	/* the dequantization of compact formats is folded into the transformation */
+	batch->coordScale = context->vertexArray.scale;
+	batch->normalScale = context->normalArray.enabled ? context->normalArray.scale : 1.0f;
+
+	for (unit = 0; unit < VPMT_MAX_TEX_UNITS; ++unit) {
+		const VPMT_Array *array = &context->texCoordArray[unit];
+
+		batch->texCoordScale[unit] = array->enabled ? array->scale : 1.0f;
+		batch->texCoordBias[unit] = array->enabled ? array->bias : 0.0f;
+	}
+
+	if (!elements || !LoadInterleaved(attributes, numAttributes, first, elements, count)) {
+		for (index = 0; index < numAttributes; ++index) {
+			LoadAttribute(attributes + index, first, elements, count);
+		}
+	}
+}
+
+static GLboolean ReserveRange(VPMT_VertexCache * cache, GLsizei size)
+{
+	if (cache->rangeSize < size) {
+		VPMT_FREE(cache->range);
+		cache->range = VPMT_MALLOC(size * sizeof(VPMT_Vertex));
+		cache->rangeSize = cache->range ? size : 0;
+	}
+
+	return cache->range != NULL;
+}
+
+/*
+** Fetch and transform count array elements starting at first into range.
+*/
+static void TransformRange(VPMT_Context * context, GLint first, GLsizei count,
+						   VPMT_Vertex * range)
+{
+	VPMT_VertexBatch *batch = &context->vertexBatch;
+	GLsizei offset;
+
+	for (offset = 0; offset < count; offset += batch->count) {
+		batch->count = VPMT_MIN(VPMT_VERTEX_BATCH, count - offset);
+		LoadElements(context, batch, first + offset, NULL, batch->count);
+		VPMT_VertexBatchTransform(context, batch, range + offset);
+	}
+
+	batch->count = 0;
+}
+
+/*
+** Assemble primitives using a direct mapped cache of transformed vertices.
+** The indices are processed in chunks: the cache misses of a chunk are
+** transformed as one batch, after which all vertices of the chunk are
+** available in the cache. A chunk ends when the batch is full, or when a
+** miss would evict a vertex the chunk still refers to. As later chunks may
+** evict vertices still needed by a strip or fan, the vertices are passed on
+** through the vertex queue of primitive assembly.
+*/
+static void DrawCached(VPMT_Context * context, GLsizei count, GLenum type,
+					   const GLvoid * indices)
+{
+	VPMT_VertexBatch *batch = &context->vertexBatch;
+	VPMT_VertexCache *cache = &context->vertexCache;
+	GLsizei slots[VPMT_VERTEX_BATCH];
+	GLuint misses[VPMT_VERTEX_BATCH];
+	GLsizei start, end, n;
+	GLuint chunk, slot;
+
+	for (slot = 0; slot < VPMT_VERTEX_CACHE_SIZE; ++slot) {
+		/* an index never maps to the entry following its own */
+		cache->tags[slot] = slot + 1;
+		cache->uses[slot] = 0;
+	}
+
+	for (start = 0, chunk = 1; start < count; start = end, ++chunk) {
+		batch->count = 0;
+
+		for (end = start; end < count; ++end) {
+			GLuint index = ElementIndex(type, indices, end);
+
+			slot = index & (VPMT_VERTEX_CACHE_SIZE - 1);
+
+			if (cache->tags[slot] != index) {
+				if (cache->uses[slot] == chunk || batch->count == VPMT_VERTEX_BATCH) {
+					break;
+				}
+
+				cache->tags[slot] = index;
+				slots[batch->count] = slot;
+				misses[batch->count++] = index;
+			}
+
+			cache->uses[slot] = chunk;
+		}
+
+		LoadElements(context, batch, 0, misses, batch->count);
+		VPMT_VertexBatchTransform(context, batch, batch->vertices);
+
+		for (n = 0; n < batch->count; ++n) {
+			cache->vertices[slots[n]] = batch->vertices[n];
+		}
+
+		for (n = start; n < end; ++n) {
+			slot = ElementIndex(type, indices, n) & (VPMT_VERTEX_CACHE_SIZE - 1);
+			VPMT_VertexAssemble(context, cache->vertices + slot);
+		}
+	}
+
+	batch->count = 0;
+}
+
+#if GL_EXT_compiled_vertex_array
+
+static void CaptureLockedState(VPMT_Context * context, VPMT_LockedState * state)
+{
+	GLsizei index;
+
+	/* the state is compared bytewise, including any padding */
+	memset(state, 0, sizeof(VPMT_LockedState));
+
+	VPMT_MatrixCopy(state->modelview,
+					context->modelviewMatrixStack.base[context->modelviewMatrixStack.current - 1]);
+	VPMT_MatrixCopy(state->projection,
+					context->projectionMatrixStack.base[context->projectionMatrixStack.current - 1]);
+
+	VPMT_Vec4Copy(state->color, context->color);
+	VPMT_Vec3Copy(state->normal, context->normal);
+
+	VPMT_Vec4Copy(state->materialAmbient, context->materialAmbient);
+	VPMT_Vec4Copy(state->materialDiffuse, context->materialDiffuse);
+	VPMT_Vec4Copy(state->materialEmission, context->materialEmission);
+	VPMT_Vec4Copy(state->materialSpecular, context->materialSpecular);
+	state->materialShininess = context->materialShininess;
+	VPMT_Vec4Copy(state->lightModelAmbient, context->lightModelAmbient);
+
+	for (index = 0; index < VPMT_MAX_LIGHTS; ++index) {
+		VPMT_Vec4Copy(state->lightAmbient[index], context->lightAmbient[index]);
+		VPMT_Vec4Copy(state->lightDiffuse[index], context->lightDiffuse[index]);
+		VPMT_Vec4Copy(state->lightSpecular[index], context->lightSpecular[index]);
+		VPMT_Vec4Copy(state->lightDirection[index], context->lightDirection[index]);
+		VPMT_Vec4Copy(state->lightHighlightDirection[index],
+					  context->lightHighlightDirection[index]);
+		state->lightEnabled[index] = context->lightEnabled[index];
+	}
+
+	memcpy(&state->arrays[0], &context->vertexArray, sizeof(VPMT_Array));
+	memcpy(&state->arrays[1], &context->colorArray, sizeof(VPMT_Array));
+	memcpy(&state->arrays[2], &context->normalArray, sizeof(VPMT_Array));
+
+	for (index = 0; index < VPMT_MAX_TEX_UNITS; ++index) {
+		VPMT_Vec4Copy(state->texCoords[index], context->texCoords[index]);
+		memcpy(&state->arrays[3 + index], &context->texCoordArray[index], sizeof(VPMT_Array));
+	}
+
+	state->lightingEnabled = context->lightingEnabled;
+	state->colorMaterialEnabled = context->colorMaterialEnabled;
+	state->normalizeEnabled = context->normalizeEnabled;
+	state->rescaleNormalEnabled = context->rescaleNormalEnabled;
+}
+
+/*
+** Returns GL_TRUE if the array elements first to last lie within the locked
+** range, making sure its transformed vertices reflect the current state.
+** The locked range is transformed again only if that state has changed.
+*/
+static GLboolean LockedRange(VPMT_Context * context, GLuint first, GLuint last)
+{
+	VPMT_LockedState state;
+
+	if (!context->lockedVertices ||
+		first < (GLuint) context->lockFirst ||
+		last >= (GLuint) context->lockFirst + (GLuint) context->lockCount) {
+		return GL_FALSE;
+	}
+
+	CaptureLockedState(context, &state);
+
+	if (!context->lockedValid || memcmp(&state, &context->lockedState, sizeof(state))) {
+		TransformRange(context, context->lockFirst, context->lockCount, context->lockedVertices);
+		memcpy(&context->lockedState, &state, sizeof(state));
+		context->lockedValid = GL_TRUE;
+	}
+
+	return GL_TRUE;
+}
+
+#endif
+
+static void DrawIndexed(VPMT_Context * context, GLsizei count, GLenum type,
+						const GLvoid * indices)
+{
+	GLuint minIndex = ~0u, maxIndex = 0;
+	GLsizei n;
+
+	for (n = 0; n < count; ++n) {
+		GLuint index = ElementIndex(type, indices, n);
+
+		minIndex = VPMT_MIN(minIndex, index);
+		maxIndex = VPMT_MAX(maxIndex, index);
+	}
+
+#if GL_EXT_compiled_vertex_array
+	if (count && LockedRange(context, minIndex, maxIndex)) {
+		/* reuse the transformed vertices of the locked range */
+		VPMT_RenderVertices(context, context->lockedVertices, count, type, indices,
+							context->lockFirst);
+		return;
+	}
+#endif
+
+	/* a range is used if no more vertices are transformed than indices given */
+	if (count && maxIndex - minIndex < (GLuint) count &&
+		ReserveRange(&context->vertexCache, maxIndex - minIndex + 1)) {
+		TransformRange(context, minIndex, maxIndex - minIndex + 1, context->vertexCache.range);
+		VPMT_RenderVertices(context, context->vertexCache.range, count, type, indices, minIndex);
+	} else {
+		DrawCached(context, count, type, indices);
+	}
+}
+
+#if GL_ARB_vertex_buffer_object
+
+/*
+** Resolve indices given as offset into the element array buffer. Returns
+** NULL if the indices do not lie within the buffer.
+*/
+static const GLvoid *BufferIndices(const VPMT_Buffer * buffer, GLsizei count, GLenum type,
+								   const GLvoid * indices)
+{
+	GLintptrARB offset = (GLintptrARB) indices;
+	GLsizeiptrARB size;
+
+	switch (type) {
+	case GL_UNSIGNED_BYTE:
+		size = count * sizeof(GLubyte);
+		break;
+
+	case GL_UNSIGNED_SHORT:
+		size = count * sizeof(GLushort);
+		break;
+
+	default:
+		size = count * sizeof(GLuint);
+	}
+
+	if (offset < 0 || size < 0 || offset + size > buffer->size) {
+		return NULL;
+	}
+
+	return buffer->data + offset;
+}
+
+#endif
+
+static GLboolean IsDrawMode(GLenum mode)
+{
+	return
+		mode == GL_POINTS ||
+		mode == GL_LINES || mode == GL_LINE_LOOP || mode == GL_LINE_STRIP ||
+		mode == GL_TRIANGLES || mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN;
+}
+
+static GLboolean IsIndexType(GLenum type)
+{
+	return type == GL_UNSIGNED_BYTE || type == GL_UNSIGNED_SHORT || type == GL_UNSIGNED_INT;
+}
+
+/*
+** The indices of DrawElements as client memory address, or NULL if they
+** exceed the bound element array buffer.
+*/
+static const GLvoid *ResolveIndices(VPMT_Context * context, GLsizei count, GLenum type,
+									const GLvoid * indices)
+{
+#if GL_ARB_vertex_buffer_object
+	if (context->elementArrayBuffer) {
+		return BufferIndices(context->elementArrayBuffer, count, type, indices);
+	}
+#endif
+
+	return indices;
+}
+
+/*
+** Draw the array elements first to first + count - 1 within the current
+** begin/end block.
+*/
+static void DrawRange(VPMT_Context * context, GLint first, GLsizei count)
+{
+#if GL_EXT_compiled_vertex_array
+	if (!context->listMode && context->vertexArray.enabled && count && first >= 0 &&
+		LockedRange(context, first, first + count - 1)) {
+		VPMT_RenderVertices(context, context->lockedVertices + (first - context->lockFirst),
+							count, GL_UNSIGNED_INT, NULL, 0);
+		return;
+	}
+#endif
+
+	if (!context->listMode && context->vertexArray.enabled &&
+		ReserveRange(&context->vertexCache, count)) {
+		/* fetch and transform the arrays in batches, and assemble directly */
+		TransformRange(context, first, count, context->vertexCache.range);
+		VPMT_RenderVertices(context, context->vertexCache.range, count, GL_UNSIGNED_INT, NULL, 0);
+	} else {
+		while (count > 0) {
+			VPMT_ExecArrayElement(context, first++);
+			--count;
+		}
+	}
+}
+
+/*
+** Draw the array elements selected by count indices within the current
+** begin/end block.
+*/
+static void DrawIndices(VPMT_Context * context, GLsizei count, GLenum type,
+						const GLvoid * indices)
+{
+	if (!context->listMode && context->vertexArray.enabled) {
+		/* transform each referenced vertex once where possible */
+		DrawIndexed(context, count, type, indices);
+		return;
+	}
 
 	switch (type) {
-	case GL_BYTE:
-		elementSize = sizeof(GLbyte);
-		array->fetch = FetchByteNormalize;
-		break;
 	case GL_UNSIGNED_BYTE:
-		elementSize = sizeof(GLubyte);
-		array->fetch = FetchUnsignedByteNormalize;
-		break;
-	case GL_SHORT:
-		elementSize = sizeof(GLshort);
-		array->fetch = FetchShort;
+		{
+			const GLubyte *ptr = indices;
+
+			while (count > 0) {
+				VPMT_ExecArrayElement(context, *ptr++);
+				--count;
+			}
+		}
+
 		break;
+
 	case GL_UNSIGNED_SHORT:
-		elementSize = sizeof(GLushort);
-		array->fetch = FetchUnsignedShort;
-		break;
-	case GL_INT:
-		elementSize = sizeof(GLint);
-		array->fetch = FetchInt;
+		{
+			const GLushort *ptr = indices;
+
+			while (count > 0) {
+				VPMT_ExecArrayElement(context, *ptr++);
+				--count;
+			}
+		}
+
 		break;
+
 	case GL_UNSIGNED_INT:
-		elementSize = sizeof(GLuint);
-		array->fetch = FetchUnsignedInt;
-		break;
-	case GL_FLOAT:
-		elementSize = sizeof(GLfloat);
-		array->fetch = FetchFloat;
+		{
+			const GLuint *ptr = indices;
+
+			while (count > 0) {
+				VPMT_ExecArrayElement(context, *ptr++);
+				--count;
+			}
+		}
+
 		break;
+
 	default:
 		assert(GL_FALSE);
-		elementSize = 0;
-		array->fetch = FetchError;
 	}
+}
 
-	if (stride) {
-		array->effectiveStride = stride;
-	} else {
-		array->effectiveStride = size * elementSize;
+#if GL_VPMT_instanced_modelview
+
+/*
+** Draw primcount instances of the array elements first to first + count - 1,
+** or of those selected by indices if not NULL. Instance i is drawn with the
+** current modelview matrix multiplied by the i-th 4x4 matrix of modelviews.
+** All instances share a single begin/end block.
+*/
+static void DrawInstanced(VPMT_Context * context, GLenum mode, GLint first, GLsizei count,
+						  GLenum type, const GLvoid * indices, GLsizei primcount,
+						  const GLfloat * modelviews)
+{
+	VPMT_MatrixStack *stack = &context->modelviewMatrixStack;
+	VPMT_Matrix modelview;
+	GLsizei index;
+
+	if (context->listMode) {
+		/* matrix changes within begin/end cannot be compiled into a list */
+		GLenum matrixMode = context->matrixMode;
+
+		context->dispatch->MatrixMode(context, GL_MODELVIEW);
+
+		for (index = 0; index < primcount; ++index) {
+			context->dispatch->PushMatrix(context);
+			context->dispatch->MultMatrixf(context, modelviews + index * 16);
+			context->dispatch->Begin(context, mode);
+
+			if (indices) {
+				DrawIndices(context, count, type, indices);
+			} else {
+				DrawRange(context, first, count);
+			}
+
+			context->dispatch->End(context);
+			context->dispatch->PopMatrix(context);
+		}
+
+		context->dispatch->MatrixMode(context, matrixMode);
+		return;
+	}
+
+	VPMT_MatrixCopy(modelview, stack->base[stack->current - 1]);
+	context->dispatch->Begin(context, mode);
+
+	for (index = 0; index < primcount; ++index) {
+		VPMT_MatrixStackLoadMatrixf(stack, modelview);
+		VPMT_MatrixStackMultMatrixf(stack, modelviews + index * 16);
+
+		if (context->lightingEnabled) {
+			VPMT_MatrixInverse3(context->inverseModelView, stack->base[stack->current - 1]);
+		}
+
+		if (indices) {
+			DrawIndices(context, count, type, indices);
+		} else {
+			DrawRange(context, first, count);
+		}
+
+		VPMT_RenderRestart(context);
+	}
+
+	VPMT_MatrixStackLoadMatrixf(stack, modelview);
+
+	if (context->lightingEnabled) {
+		VPMT_MatrixInverse3(context->inverseModelView, modelview);
 	}
+
+	context->dispatch->End(context);
 }
 
+#endif
+
 /*
 ** -------------------------------------------------------------------------
 ** Exported API entry points
@@ -323,6 +1380,10 @@ void VPMT_ExecColorPointer(VPMT_Context * context, GLint size, GLenum type, GLsi
 
 	VPMT_NOT_RENDERING(context);
 	SetArray(&context->colorArray, size, type, stride, pointer);
+
+#if GL_ARB_vertex_buffer_object
+	SourceBuffer(context, &context->colorArray);
+#endif
 }
 
 void VPMT_ExecDisableClientState(VPMT_Context * context, GLenum array)
@@ -346,6 +1407,7 @@ void VPMT_ExecArrayElement(VPMT_Context * context, GLint i)
 	if (context->normalArray.enabled) {
 		VPMT_Vec3 normal;
 		FetchArray(&context->normalArray, i, normal);
+		Dequantize(&context->normalArray, normal, 3);
 		context->dispatch->Normal3fv(context, normal);
 	}
 
@@ -354,6 +1416,7 @@ void VPMT_ExecArrayElement(VPMT_Context * context, GLint i)
 		if (context->texCoordArray[index].enabled) {
 			VPMT_Vec2 texCoord;
 			FetchArray(&context->texCoordArray[index], i, texCoord);
+			Dequantize(&context->texCoordArray[index], texCoord, 2);
 			context->dispatch->MultiTexCoord2f(context, GL_TEXTURE0 + index, texCoord[0],
 											   texCoord[1]);
 		}
@@ -364,6 +1427,7 @@ void VPMT_ExecArrayElement(VPMT_Context * context, GLint i)
 		VPMT_Vec3 vertex;
 		vertex[2] = 0.0f;
 		FetchArray(&context->vertexArray, i, vertex);
+		Dequantize(&context->vertexArray, vertex, 3);
 		context->dispatch->Vertex3fv(context, vertex);
 	}
 }
@@ -373,9 +1437,7 @@ void VPMT_ExecDrawArrays(VPMT_Context * context, GLenum mode, GLint first, GLsiz
 	if (count < 0) {
 		VPMT_INVALID_VALUE(context);
 		return;
-	} else if (mode != GL_POINTS &&
-			   mode != GL_LINES && mode != GL_LINE_LOOP && mode != GL_LINE_STRIP &&
-			   mode != GL_TRIANGLES && mode != GL_TRIANGLE_STRIP && mode != GL_TRIANGLE_FAN) {
+	} else if (!IsDrawMode(mode)) {
 		VPMT_INVALID_ENUM(context);
 		return;
 	} else if (context->renderMode != GL_INVALID_MODE) {
@@ -385,25 +1447,41 @@ void VPMT_ExecDrawArrays(VPMT_Context * context, GLenum mode, GLint first, GLsiz
 	}
 
 	context->dispatch->Begin(context, mode);
+	DrawRange(context, first, count);
+	context->dispatch->End(context);
+}
 
-	while (count > 0) {
-		VPMT_ExecArrayElement(context, first++);
-		--count;
+#if GL_VPMT_instanced_modelview
+
+void VPMT_ExecDrawArraysInstanced(VPMT_Context * context, GLenum mode, GLint first,
+								  GLsizei count, GLsizei primcount, const GLfloat * modelviews)
+{
+	if (count < 0 || primcount < 0 || (primcount && !modelviews)) {
+		VPMT_INVALID_VALUE(context);
+		return;
+	} else if (!IsDrawMode(mode)) {
+		VPMT_INVALID_ENUM(context);
+		return;
+	} else if (context->renderMode != GL_INVALID_MODE) {
+		/* cannot nest begin/end */
+		VPMT_INVALID_OPERATION(context);
+		return;
 	}
 
-	context->dispatch->End(context);
+	DrawInstanced(context, mode, first, count, GL_UNSIGNED_INT, NULL, primcount, modelviews);
 }
 
+#endif
+
 void VPMT_ExecDrawElements(VPMT_Context * context, GLenum mode, GLsizei count, GLenum type,
 						   const GLvoid * indices)
 {
+	indices = ResolveIndices(context, count, type, indices);
+
 	if (count < 0 || !indices) {
 		VPMT_INVALID_VALUE(context);
 		return;
-	} else if ((mode != GL_POINTS &&
-				mode != GL_LINES && mode != GL_LINE_LOOP && mode != GL_LINE_STRIP &&
-				mode != GL_TRIANGLES && mode != GL_TRIANGLE_STRIP && mode != GL_TRIANGLE_FAN) ||
-			   (type != GL_UNSIGNED_BYTE && type != GL_UNSIGNED_SHORT && type != GL_UNSIGNED_INT)) {
+	} else if (!IsDrawMode(mode) || !IsIndexType(type)) {
 		VPMT_INVALID_ENUM(context);
 		return;
 	} else if (context->renderMode != GL_INVALID_MODE) {
@@ -413,51 +1491,35 @@ void VPMT_ExecDrawElements(VPMT_Context * context, GLenum mode, GLsizei count, G
 	}
 
 	context->dispatch->Begin(context, mode);
+	DrawIndices(context, count, type, indices);
+	context->dispatch->End(context);
+}
 
-	switch (type) {
-	case GL_UNSIGNED_BYTE:
-		{
-			const GLubyte *ptr = indices;
-
-			while (count > 0) {
-				VPMT_ExecArrayElement(context, *ptr++);
-				--count;
-			}
-		}
-
-		break;
-
-	case GL_UNSIGNED_SHORT:
-		{
-			const GLushort *ptr = indices;
-
-			while (count > 0) {
-				VPMT_ExecArrayElement(context, *ptr++);
-				--count;
-			}
-		}
-
-		break;
-
-	case GL_UNSIGNED_INT:
-		{
-			const GLuint *ptr = indices;
-
-			while (count > 0) {
-				VPMT_ExecArrayElement(context, *ptr++);
-				--count;
-			}
-		}
+#if GL_VPMT_instanced_modelview
 
-		break;
+void VPMT_ExecDrawElementsInstanced(VPMT_Context * context, GLenum mode, GLsizei count,
+									GLenum type, const GLvoid * indices, GLsizei primcount,
+									const GLfloat * modelviews)
+{
+	indices = ResolveIndices(context, count, type, indices);
 
-	default:
-		assert(GL_FALSE);
+	if (count < 0 || !indices || primcount < 0 || (primcount && !modelviews)) {
+		VPMT_INVALID_VALUE(context);
+		return;
+	} else if (!IsDrawMode(mode) || !IsIndexType(type)) {
+		VPMT_INVALID_ENUM(context);
+		return;
+	} else if (context->renderMode != GL_INVALID_MODE) {
+		/* cannot nest begin/end */
+		VPMT_INVALID_OPERATION(context);
+		return;
 	}
 
-	context->dispatch->End(context);
+	DrawInstanced(context, mode, 0, count, type, indices, primcount, modelviews);
 }
 
+#endif
+
 void VPMT_ExecEnableClientState(VPMT_Context * context, GLenum array)
 {
 	ToggleClientState(context, array, GL_TRUE);
@@ -495,10 +1557,134 @@ void VPMT_ExecGetPointerv(VPMT_Context * context, GLenum pname, GLvoid ** params
 	}
 }
 
+#if GL_EXT_compiled_vertex_array
+
+void VPMT_ExecLockArrays(VPMT_Context * context, GLint first, GLsizei count)
+{
+	if (first < 0 || count <= 0) {
+		VPMT_INVALID_VALUE(context);
+		return;
+	}
+
+	VPMT_NOT_RENDERING(context);
+
+	if (context->lockCount) {
+		VPMT_INVALID_OPERATION(context);
+		return;
+	}
+
+	context->lockFirst = first;
+	context->lockCount = count;
+	context->lockedValid = GL_FALSE;
+
+	/* without storage for the range, locked arrays are drawn as if unlocked */
+	context->lockedVertices = VPMT_MALLOC(count * sizeof(VPMT_Vertex));
+}
+
+#endif
+
+#if GL_EXT_multi_draw_arrays
+
+void VPMT_ExecMultiDrawArrays(VPMT_Context * context, GLenum mode, const GLint * first,
+							  const GLsizei * count, GLsizei primcount)
+{
+	GLsizei index;
+
+	if (primcount < 0 || (primcount && (!first || !count))) {
+		VPMT_INVALID_VALUE(context);
+		return;
+	} else if (!IsDrawMode(mode)) {
+		VPMT_INVALID_ENUM(context);
+		return;
+	} else if (context->renderMode != GL_INVALID_MODE) {
+		/* cannot nest begin/end */
+		VPMT_INVALID_OPERATION(context);
+		return;
+	}
+
+	for (index = 0; index < primcount; ++index) {
+		if (count[index] < 0) {
+			VPMT_INVALID_VALUE(context);
+			return;
+		}
+	}
+
+	if (context->listMode) {
+		/* restarting primitives cannot be compiled into a list */
+		for (index = 0; index < primcount; ++index) {
+			context->dispatch->Begin(context, mode);
+			DrawRange(context, first[index], count[index]);
+			context->dispatch->End(context);
+		}
+
+		return;
+	}
+
+	/* validation and preparation for rendering are shared by all primitives */
+	context->dispatch->Begin(context, mode);
+
+	for (index = 0; index < primcount; ++index) {
+		DrawRange(context, first[index], count[index]);
+		VPMT_RenderRestart(context);
+	}
+
+	context->dispatch->End(context);
+}
+
+void VPMT_ExecMultiDrawElements(VPMT_Context * context, GLenum mode, const GLsizei * count,
+								GLenum type, const GLvoid ** indices, GLsizei primcount)
+{
+	GLsizei index;
+
+	if (primcount < 0 || (primcount && (!count || !indices))) {
+		VPMT_INVALID_VALUE(context);
+		return;
+	} else if (!IsDrawMode(mode) || !IsIndexType(type)) {
+		VPMT_INVALID_ENUM(context);
+		return;
+	} else if (context->renderMode != GL_INVALID_MODE) {
+		/* cannot nest begin/end */
+		VPMT_INVALID_OPERATION(context);
+		return;
+	}
+
+	for (index = 0; index < primcount; ++index) {
+		if (count[index] < 0 || !ResolveIndices(context, count[index], type, indices[index])) {
+			VPMT_INVALID_VALUE(context);
+			return;
+		}
+	}
+
+	if (context->listMode) {
+		/* restarting primitives cannot be compiled into a list */
+		for (index = 0; index < primcount; ++index) {
+			context->dispatch->Begin(context, mode);
+			DrawIndices(context, count[index], type,
+						ResolveIndices(context, count[index], type, indices[index]));
+			context->dispatch->End(context);
+		}
+
+		return;
+	}
+
+	/* validation and preparation for rendering are shared by all primitives */
+	context->dispatch->Begin(context, mode);
+
+	for (index = 0; index < primcount; ++index) {
+		DrawIndices(context, count[index], type,
+					ResolveIndices(context, count[index], type, indices[index]));
+		VPMT_RenderRestart(context);
+	}
+
+	context->dispatch->End(context);
+}
+
+#endif
+
 void VPMT_ExecNormalPointer(VPMT_Context * context, GLenum type, GLsizei stride,
 							const GLvoid * pointer)
 {
-	if (type != GL_FLOAT) {
+	if (type != GL_FLOAT && type != GL_HALF_FLOAT_OES && type != GL_FIXED) {
 		VPMT_INVALID_ENUM(context);
 		return;
 	}
@@ -506,12 +1692,18 @@ void VPMT_ExecNormalPointer(VPMT_Context * context, GLenum type, GLsizei stride,
 	VPMT_NOT_RENDERING(context);
 
 	SetArray(&context->normalArray, 3, type, stride, pointer);
+
+#if GL_ARB_vertex_buffer_object
+	SourceBuffer(context, &context->normalArray);
+#endif
 }
 
 void VPMT_ExecTexCoordPointer(VPMT_Context * context, GLint size, GLenum type, GLsizei stride,
 							  const GLvoid * pointer)
 {
-	if (type != GL_FLOAT) {
+	VPMT_Array *array = &context->texCoordArray[context->clientActiveTextureIndex];
+
+	if (type != GL_FLOAT && type != GL_HALF_FLOAT_OES && type != GL_FIXED && type != GL_SHORT) {
 		VPMT_INVALID_ENUM(context);
 		return;
 	}
@@ -522,15 +1714,44 @@ void VPMT_ExecTexCoordPointer(VPMT_Context * context, GLint size, GLenum type, G
 	}
 
 	VPMT_NOT_RENDERING(context);
-	SetArray(&context->texCoordArray[context->clientActiveTextureIndex], size, type, stride,
-			 pointer);
+	SetArray(array, size, type, stride, pointer);
+
+	if (type == GL_SHORT) {
+		/* normalized to [-1, 1], mapping c to (2c + 1) / (2^16 - 1) */
+		array->scale = 2.0f / 65535.0f;
+		array->bias = 1.0f / 65535.0f;
+	}
+
+#if GL_ARB_vertex_buffer_object
+	SourceBuffer(context, array);
+#endif
+}
+
+#if GL_EXT_compiled_vertex_array
+
+void VPMT_ExecUnlockArrays(VPMT_Context * context)
+{
+	VPMT_NOT_RENDERING(context);
+
+	if (!context->lockCount) {
+		VPMT_INVALID_OPERATION(context);
+		return;
+	}
+
+	VPMT_FREE(context->lockedVertices);
+	context->lockedVertices = NULL;
+	context->lockedValid = GL_FALSE;
+	context->lockFirst = 0;
+	context->lockCount = 0;
 }
 
+#endif
+
 void VPMT_ExecVertexPointer(VPMT_Context * context, GLint size, GLenum type, GLsizei stride,
 							const GLvoid * pointer)
 {
 
-	if (type != GL_FLOAT) {
+	if (type != GL_FLOAT && type != GL_HALF_FLOAT_OES && type != GL_FIXED) {
 		VPMT_INVALID_ENUM(context);
 		return;
 	}
@@ -542,6 +1763,10 @@ void VPMT_ExecVertexPointer(VPMT_Context * context, GLint size, GLenum type, GLs
 
 	VPMT_NOT_RENDERING(context);
 	SetArray(&context->vertexArray, size, type, stride, pointer);
+
+#if GL_ARB_vertex_buffer_object
+	SourceBuffer(context, &context->vertexArray);
+#endif
 }
 
 /*
@@ -561,8 +1786,28 @@ void VPMT_ArrayInitialize(VPMT_Array * array)
 	array->effectiveStride = sizeof(GLfloat) * 4;
 	array->enabled = GL_FALSE;
 	array->fetch = FetchError;
+	array->convert = ConvertElements;
+	array->scale = 1.0f;
+	array->bias = 0.0f;
+	array->stream = NULL;
 }
 
+#if GL_ARB_vertex_buffer_object
+
+void VPMT_ArrayDetachBuffer(VPMT_Array * array)
+{
+	if (array->stream) {
+		VPMT_BufferStreamRelease(array->stream);
+		array->stream = NULL;
+	}
+
+	/* the array provides no data until it is specified again */
+	array->fetch = FetchError;
+	array->convert = ConvertElements;
+}
+
+#endif
+
 static void ToggleClientState(VPMT_Context * context, GLenum array, GLboolean enable)
 {
 	VPMT_NOT_RENDERING(context);
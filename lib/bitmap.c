@@ -14,6 +14,10 @@
 #include "GL/gl.h"
 #include "context.h"
 #include "frame.h"
+#include "tile.h"
+#include "clear.h"
+#include "hiz.h"
+#include "zplane.h"
 
 /*
 ** -------------------------------------------------------------------------
@@ -45,6 +49,9 @@ void VPMT_ExecBitmap(VPMT_Context * context, GLsizei width, GLsizei height, GLfl
 			const VPMT_RasterVertex *rasterPos = &context->rasterPos;
 			VPMT_FrameBuffer fb;
 			GLuint depth = (GLuint) rasterPos->depth;
+			VPMT_Color4ub colors[VPMT_FRAGMENT_SPAN_SIZE];
+			GLuint depths[VPMT_FRAGMENT_SPAN_SIZE];
+			GLsizei index;
 
 			GLsizei unpackAlignment = context->unpackAlignment;
 			GLsizei rowOffset =
@@ -61,7 +68,17 @@ void VPMT_ExecBitmap(VPMT_Context * context, GLsizei width, GLsizei height, GLfl
 				 (1 << (VPMT_SUBPIXEL_BITS - 1))) >> VPMT_SUBPIXEL_BITS;
 
 			if (context->writeSurface) {
+				VPMT_Rect rect;
+
 				context->writeSurface->vtbl->lock(context, context->writeSurface);
+
+				rect.origin[0] = x;
+				rect.origin[1] = y;
+				rect.size.width = width;
+				rect.size.height = height;
+				VPMT_ClearResolve(context->writeSurface, &rect);
+				VPMT_ZPlaneResolve(context->writeSurface, &rect);
+				VPMT_HiZPrepare(context);
 			} else {
 				VPMT_UpdateActiveSurfaceRect(context, NULL);
 			}
@@ -72,6 +89,11 @@ void VPMT_ExecBitmap(VPMT_Context * context, GLsizei width, GLsizei height, GLfl
 										  VPMT_ConvertVec4ToColor4us(rasterPos->rgba),
 										  rasterPos->texCoords, NULL);
 
+			for (index = 0; index < VPMT_FRAGMENT_SPAN_SIZE; ++index) {
+				colors[index] = rgba;
+				depths[index] = depth;
+			}
+
 			VPMT_FrameBufferInit(&fb, context->writeSurface);
 			VPMT_FrameBufferMove(&fb, x, y);
 
@@ -88,25 +110,24 @@ void VPMT_ExecBitmap(VPMT_Context * context, GLsizei width, GLsizei height, GLfl
 					VPMT_FrameBufferSave(&fb);
 
 					while (rowCount > 0) {
-						GLubyte pattern = *bitmapRow++;
-						GLsizei groupCount = rowCount < 8 ? rowCount : 8;
+						GLsizei count = VPMT_MIN(rowCount, VPMT_FRAGMENT_SPAN_SIZE);
+						GLuint mask = 0;
 
-						while (groupCount--) {
-							GLboolean set = pattern & 0x80;
+						for (index = 0; index < count; ++index, ++xrow) {
+							GLboolean set = (bitmapRow[index >> 3] & (0x80 >> (index & 7))) != 0;
 
 							if (set &&
-								(x - context->activeSurfaceRect.origin[0]) >= 0 &&
-								(GLuint) (x - context->activeSurfaceRect.origin[0]) <
+								(xrow - context->activeSurfaceRect.origin[0]) >= 0 &&
+								(GLuint) (xrow - context->activeSurfaceRect.origin[0]) <
 								(GLuint) context->activeSurfaceRect.size.width) {
-								VPMT_Fragment(context, &fb, rgba, depth);
+								mask |= 1u << index;
 							}
-
-							pattern <<= 1;
-							++xrow;
-							VPMT_FrameBufferStepX(&fb);
 						}
 
-						rowCount -= 8;
+						VPMT_FragmentSpan(context, &fb, count, colors, depths, mask);
+						VPMT_FrameBufferMove(&fb, count, 0);
+						bitmapRow += count >> 3;
+						rowCount -= count;
 					}
 
 					VPMT_FrameBufferRestore(&fb);
@@ -132,11 +153,14 @@ void VPMT_ExecCopyPixels(VPMT_Context * context, GLint x, GLint y, GLsizei width
 						 GLenum type)
 {
 	const VPMT_RasterVertex *rasterPos = &context->rasterPos;
-	GLsizei i, j;
+	GLsizei i, j, count, index;
 	GLint xbase, ybase;
 	GLuint depth;
-	VPMT_Color4ub rgba, fragColor;
+	VPMT_Color4ub rgba;
+	VPMT_Color4ub colors[VPMT_FRAGMENT_SPAN_SIZE];
+	GLuint depths[VPMT_FRAGMENT_SPAN_SIZE];
 	VPMT_FrameBuffer fb;
+	VPMT_Rect rect;
 
 	if (type != GL_COLOR) {
 		VPMT_INVALID_ENUM(context);
@@ -168,6 +192,8 @@ void VPMT_ExecCopyPixels(VPMT_Context * context, GLint x, GLint y, GLsizei width
 		return;
 	}
 
+	VPMT_TileFlush(context);
+
 	/* lock the surfaces */
 	context->writeSurface->vtbl->lock(context, context->writeSurface);
 	context->readSurface->vtbl->lock(context, context->readSurface);
@@ -190,35 +216,61 @@ void VPMT_ExecCopyPixels(VPMT_Context * context, GLint x, GLint y, GLsizei width
 		 (1 << (VPMT_SUBPIXEL_BITS - 1))) >> VPMT_SUBPIXEL_BITS;
 	depth = (GLuint) context->rasterPos.depth;
 
+	/* materialize pending clears of source and destination area */
+	rect.origin[0] = x;
+	rect.origin[1] = y;
+	rect.size.width = width;
+	rect.size.height = height;
+	VPMT_ClearResolve(context->readSurface, &rect);
+	VPMT_FrameUpdateImage(context->readSurface, &rect);
+
+	rect.origin[0] = xbase;
+	rect.origin[1] = ybase;
+	VPMT_ClearResolve(context->writeSurface, &rect);
+	VPMT_ZPlaneResolve(context->writeSurface, &rect);
+	VPMT_HiZPrepare(context);
+
 	VPMT_FrameBufferInit(&fb, context->writeSurface);
 	VPMT_FrameBufferMove(&fb, xbase, ybase);
 
+	for (i = 0; i < VPMT_FRAGMENT_SPAN_SIZE; ++i) {
+		depths[i] = depth;
+	}
+
 	/* perform the actual copy loop */
 	for (j = 0; j < height; ++j) {
 		/* pixel ownership test based on intersection of scissor and surface rect */
-		if ((y - context->activeSurfaceRect.origin[1]) >= 0
-			&& (GLuint) (y - context->activeSurfaceRect.origin[1]) <
+		if ((ybase + j - context->activeSurfaceRect.origin[1]) >= 0
+			&& (GLuint) (ybase + j - context->activeSurfaceRect.origin[1]) <
 			(GLuint) context->activeSurfaceRect.size.height) {
 			VPMT_FrameBufferSave(&fb);
 
-			for (i = 0; i < width; ++i) {
+			for (i = 0; i < width; i += count) {
+				GLuint mask = 0;
+
+				count = VPMT_MIN(width - i, VPMT_FRAGMENT_SPAN_SIZE);
+
+				for (index = 0; index < count; ++index) {
+					if ((xbase + i + index - context->activeSurfaceRect.origin[0]) < 0 ||
+						(GLuint) (xbase + i + index - context->activeSurfaceRect.origin[0]) >=
+						(GLuint) context->activeSurfaceRect.size.width) {
+						continue;
+					}
 #if GL_EXT_paletted_texture
-				rgba = VPMT_Image2DRead(&context->readSurface->image, NULL, x + i, y + j);
+					rgba = VPMT_Image2DRead(&context->readSurface->image, NULL, x + i + index,
+											y + j);
 #else
-				rgba = VPMT_Image2DRead(&context->readSurface->image, x + i, y + j);
+					rgba = VPMT_Image2DRead(&context->readSurface->image, x + i + index, y + j);
 #endif
-				/* determine fragment color based on raster pos attributes */
-				fragColor = VPMT_TexImageUnitsExecute(context->texUnits,
-													  VPMT_ConvertColor4ubToColor4us(rgba),
-													  rasterPos->texCoords, NULL);
-
-				if ((x - context->activeSurfaceRect.origin[0]) >= 0 &&
-					(GLuint) (x - context->activeSurfaceRect.origin[0]) <
-					(GLuint) context->activeSurfaceRect.size.width) {
-					VPMT_Fragment(context, &fb, fragColor, depth);
+					/* determine fragment color based on raster pos attributes */
+					colors[index] = VPMT_TexImageUnitsExecute(context->texUnits,
+															  VPMT_ConvertColor4ubToColor4us(rgba),
+															  rasterPos->texCoords, NULL);
+					mask |= 1u << index;
 				}
 
-				VPMT_FrameBufferStepX(&fb);
+				VPMT_FragmentSpan(context, &fb, count, colors, depths, mask);
+				VPMT_FrameBufferMove(&fb, count, 0);
 			}
 
 			VPMT_FrameBufferRestore(&fb);
@@ -302,6 +354,7 @@ void VPMT_ExecReadPixels(VPMT_Context * context, GLint x, GLint y, GLsizei width
 	}
 
 	VPMT_NOT_RENDERING(context);
+	VPMT_TileFlush(context);
 
 	if (context->readSurface) {
 		VPMT_Vec2i srcPos;
@@ -344,6 +397,16 @@ void VPMT_ExecReadPixels(VPMT_Context * context, GLint x, GLint y, GLsizei width
 		}
 
 		/* perform block-copy (bitblt) */
+		if (dstRect.size.width > 0 && dstRect.size.height > 0) {
+			VPMT_Rect srcRect;
+
+			srcRect.origin[0] = srcPos[0];
+			srcRect.origin[1] = srcPos[1];
+			srcRect.size = dstRect.size;
+			VPMT_ClearResolve(context->readSurface, &srcRect);
+			VPMT_FrameUpdateImage(context->readSurface, &srcRect);
+		}
+
 		VPMT_Bitblt(&dst, &dstRect, &context->readSurface->image, srcPos);
 
 		/* unlock surfaces */
@@ -364,6 +427,9 @@ void VPMT_ExecDrawPixelsImage(VPMT_Context * context, const VPMT_Image2D * image
 	GLsizei width = image->size.width;
 	GLsizei height = image->size.height;
 	VPMT_FrameBuffer fb;
+	VPMT_Color4ub colors[VPMT_FRAGMENT_SPAN_SIZE];
+	GLuint depths[VPMT_FRAGMENT_SPAN_SIZE];
+	GLsizei count, index;
 
 	/* ancor dst rectangle relative to raster position offset by x/yorig */
 	GLint xbase =
@@ -378,7 +444,17 @@ void VPMT_ExecDrawPixelsImage(VPMT_Context * context, const VPMT_Image2D * image
 	VPMT_NOT_RENDERING(context);
 
 	if (context->writeSurface) {
+		VPMT_Rect rect;
+
 		context->writeSurface->vtbl->lock(context, context->writeSurface);
+
+		rect.origin[0] = xbase;
+		rect.origin[1] = ybase;
+		rect.size.width = width;
+		rect.size.height = height;
+		VPMT_ClearResolve(context->writeSurface, &rect);
+		VPMT_ZPlaneResolve(context->writeSurface, &rect);
+		VPMT_HiZPrepare(context);
 	} else {
 		VPMT_UpdateActiveSurfaceRect(context, NULL);
 	}
@@ -386,35 +462,47 @@ void VPMT_ExecDrawPixelsImage(VPMT_Context * context, const VPMT_Image2D * image
 	VPMT_FrameBufferInit(&fb, context->writeSurface);
 	VPMT_FrameBufferMove(&fb, xbase, ybase);
 
+	for (x = 0; x < VPMT_FRAGMENT_SPAN_SIZE; ++x) {
+		depths[x] = depth;
+	}
+
 	/* for each pixel in rectangle that is set, submit a fragment */
 	for (y = 0; y < height; ++y) {
 		/* pixel ownership test based on intersection of scissor and surface rect */
-		if ((y - context->activeSurfaceRect.origin[1]) >= 0
-			&& (GLuint) (y - context->activeSurfaceRect.origin[1]) <
+		if ((ybase + y - context->activeSurfaceRect.origin[1]) >= 0
+			&& (GLuint) (ybase + y - context->activeSurfaceRect.origin[1]) <
 			(GLuint) context->activeSurfaceRect.size.height) {
 			VPMT_FrameBufferSave(&fb);
 
-			for (x = 0; x < width; ++x) {
-				VPMT_Color4ub rgba, fragColor;
+			for (x = 0; x < width; x += count) {
+				GLuint mask = 0;
+
+				count = VPMT_MIN(width - x, VPMT_FRAGMENT_SPAN_SIZE);
+
+				for (index = 0; index < count; ++index) {
+					VPMT_Color4ub rgba;
+
+					if ((xbase + x + index - context->activeSurfaceRect.origin[0]) < 0 ||
+						(GLuint) (xbase + x + index - context->activeSurfaceRect.origin[0]) >=
+						(GLuint) context->activeSurfaceRect.size.width) {
+						continue;
+					}
 
-				/* look up the bitmap color */
+					/* look up the bitmap color */
 #if GL_EXT_paletted_texture
-				rgba = VPMT_Image2DRead(image, NULL, x, y);
+					rgba = VPMT_Image2DRead(image, NULL, x + index, y);
 #else
-				rgba = VPMT_Image2DRead(image, x, y);
+					rgba = VPMT_Image2DRead(image, x + index, y);
 #endif
-				/* determine fragment color based on raster pos attributes */
-				fragColor = VPMT_TexImageUnitsExecute(context->texUnits,
-													  VPMT_ConvertColor4ubToColor4us(rgba),
-													  rasterPos->texCoords, NULL);
-
-				if ((x - context->activeSurfaceRect.origin[0]) >= 0 &&
-					(GLuint) (x - context->activeSurfaceRect.origin[0]) <
-					(GLuint) context->activeSurfaceRect.size.width) {
-					VPMT_Fragment(context, &fb, fragColor, depth);
+					/* determine fragment color based on raster pos attributes */
+					colors[index] = VPMT_TexImageUnitsExecute(context->texUnits,
+															  VPMT_ConvertColor4ubToColor4us(rgba),
+															  rasterPos->texCoords, NULL);
+					mask |= 1u << index;
 				}
 
-				VPMT_FrameBufferStepX(&fb);
+				VPMT_FragmentSpan(context, &fb, count, colors, depths, mask);
+				VPMT_FrameBufferMove(&fb, count, 0);
 			}
 
 			VPMT_FrameBufferRestore(&fb);
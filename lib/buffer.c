@@ -0,0 +1,469 @@
+/*
+** -------------------------------------------------------------------------
+** Vincent SC 1.0 Rendering Library
+**
+** Buffer Object Functions
+**
+** Copyright (C) 2008 Vincent Pervasive Media Technologies, LLC. 
+**
+** Licensed under the Artistic License 2.0.
+** -------------------------------------------------------------------------
+*/
+
+#include "common.h"
+#include "GL/gl.h"
+#include "context.h"
+#include "exec.h"
+#include "buffer.h"
+
+#if GL_ARB_vertex_buffer_object
+
+/*
+** -------------------------------------------------------------------------
+** Module Local Declarations
+** -------------------------------------------------------------------------
+*/
+
+static VPMT_Buffer **BufferTarget(VPMT_Context * context, GLenum target, GLint ** binding)
+{
+	switch (target) {
+	case GL_ARRAY_BUFFER_ARB:
+		*binding = &context->arrayBufferBinding;
+		return &context->arrayBuffer;
+
+	case GL_ELEMENT_ARRAY_BUFFER_ARB:
+		*binding = &context->elementArrayBufferBinding;
+		return &context->elementArrayBuffer;
+
+	default:
+		return NULL;
+	}
+}
+
+static GLsizei ElementSize(GLenum type, GLsizei size)
+{
+	switch (type) {
+	case GL_BYTE:
+	case GL_UNSIGNED_BYTE:
+		return size * sizeof(GLubyte);
+
+	case GL_SHORT:
+	case GL_UNSIGNED_SHORT:
+	case GL_HALF_FLOAT_OES:
+		return size * sizeof(GLushort);
+
+	default:
+		return size * sizeof(GLfloat);
+	}
+}
+
+/*
+** Size the component rows of the stream to the elements fitting into the
+** current contents of the buffer.
+*/
+static GLboolean StreamAllocate(VPMT_BufferStream * stream)
+{
+	GLsizeiptrARB available = stream->buffer->size - stream->offset - stream->elementSize;
+
+	stream->count = available >= 0 && stream->offset >= 0 ?
+		(GLsizei) (available / stream->layout.effectiveStride) + 1 : 0;
+	stream->rowStride = (stream->count + 3) & ~3;
+
+	VPMT_FREE(stream->values);
+	stream->values = NULL;
+
+	if (stream->count) {
+		stream->values = VPMT_MALLOC(stream->rowStride * stream->layout.size * sizeof(GLfloat));
+
+		if (!stream->values) {
+			stream->count = stream->rowStride = 0;
+			return GL_FALSE;
+		}
+	}
+
+	return GL_TRUE;
+}
+
+/*
+** Convert count elements starting at first from the buffer data into the
+** component rows of the stream, applying the dequantization of the array.
+*/
+static void StreamConvert(VPMT_BufferStream * stream, GLsizei first, GLsizei count)
+{
+	VPMT_Array *layout = &stream->layout;
+	GLfloat rows[4][VPMT_VERTEX_BATCH];
+	GLsizei offset, chunk, n, k;
+
+	layout->pointer = stream->buffer->data + stream->offset;
+
+	for (offset = first; offset < first + count; offset += chunk) {
+		chunk = VPMT_MIN(VPMT_VERTEX_BATCH, first + count - offset);
+		layout->convert(layout, offset, chunk, layout->size, rows);
+
+		for (k = 0; k < layout->size; ++k) {
+			GLfloat *values = stream->values + k * stream->rowStride + offset;
+
+			for (n = 0; n < chunk; ++n) {
+				values[n] = rows[k][n] * layout->scale + layout->bias;
+			}
+		}
+	}
+}
+
+static void StreamDeallocate(VPMT_BufferStream * stream)
+{
+	VPMT_FREE(stream->values);
+	VPMT_FREE(stream);
+}
+
+static void DetachArrays(VPMT_Context * context, const VPMT_Buffer * buffer)
+{
+	GLsizei index;
+
+	if (context->vertexArray.stream && context->vertexArray.stream->buffer == buffer) {
+		VPMT_ArrayDetachBuffer(&context->vertexArray);
+	}
+
+	if (context->colorArray.stream && context->colorArray.stream->buffer == buffer) {
+		VPMT_ArrayDetachBuffer(&context->colorArray);
+	}
+
+	if (context->normalArray.stream && context->normalArray.stream->buffer == buffer) {
+		VPMT_ArrayDetachBuffer(&context->normalArray);
+	}
+
+	for (index = 0; index < VPMT_MAX_TEX_UNITS; ++index) {
+		VPMT_Array *array = context->texCoordArray + index;
+
+		if (array->stream && array->stream->buffer == buffer) {
+			VPMT_ArrayDetachBuffer(array);
+		}
+	}
+}
+
+/*
+** -------------------------------------------------------------------------
+** Exported API entry points
+** -------------------------------------------------------------------------
+*/
+
+void VPMT_ExecBindBuffer(VPMT_Context * context, GLenum target, GLuint name)
+{
+	VPMT_Buffer **binding;
+	VPMT_Buffer *buffer = NULL;
+	GLint *bindingName;
+
+	VPMT_NOT_RENDERING(context);
+
+	binding = BufferTarget(context, target, &bindingName);
+
+	if (!binding) {
+		VPMT_INVALID_ENUM(context);
+		return;
+	}
+
+	if (name) {
+		buffer = VPMT_HashTableFind(&context->buffers, name);
+
+		if (!buffer) {
+			/* buffer objects are created when first bound */
+			buffer = VPMT_BufferAllocate(name);
+
+			if (!buffer) {
+				VPMT_OUT_OF_MEMORY(context);
+				return;
+			}
+
+			if (!VPMT_HashTableInsert(&context->buffers, name, buffer)) {
+				VPMT_BufferDeallocate(buffer);
+				VPMT_OUT_OF_MEMORY(context);
+				return;
+			}
+		}
+	}
+
+	*binding = buffer;
+	*bindingName = name;
+}
+
+void VPMT_ExecBufferData(VPMT_Context * context, GLenum target, GLsizeiptrARB size,
+						 const GLvoid * data, GLenum usage)
+{
+	VPMT_Buffer **binding;
+	VPMT_Buffer *buffer;
+	VPMT_BufferStream *stream;
+	GLubyte *newData = NULL;
+	GLint *bindingName;
+
+	VPMT_NOT_RENDERING(context);
+
+	binding = BufferTarget(context, target, &bindingName);
+
+	if (!binding ||
+		(usage != GL_STREAM_DRAW_ARB && usage != GL_STATIC_DRAW_ARB &&
+		 usage != GL_DYNAMIC_DRAW_ARB)) {
+		VPMT_INVALID_ENUM(context);
+		return;
+	}
+
+	if (size < 0) {
+		VPMT_INVALID_VALUE(context);
+		return;
+	}
+
+	buffer = *binding;
+
+	if (!buffer) {
+		VPMT_INVALID_OPERATION(context);
+		return;
+	}
+
+	if (size) {
+		newData = VPMT_MALLOC(size);
+
+		if (!newData) {
+			VPMT_OUT_OF_MEMORY(context);
+			return;
+		}
+
+		if (data) {
+			memcpy(newData, data, size);
+		}
+	}
+
+	VPMT_FREE(buffer->data);
+	buffer->data = newData;
+	buffer->size = size;
+	buffer->usage = usage;
+
+	/* arrays sourcing the buffer are converted once, here, rather than per draw */
+	for (stream = buffer->streams; stream; stream = stream->next) {
+		if (!StreamAllocate(stream)) {
+			VPMT_OUT_OF_MEMORY(context);
+		} else if (data) {
+			StreamConvert(stream, 0, stream->count);
+		} else if (stream->values) {
+			memset(stream->values, 0,
+				   stream->rowStride * stream->layout.size * sizeof(GLfloat));
+		}
+	}
+}
+
+void VPMT_ExecBufferSubData(VPMT_Context * context, GLenum target, GLintptrARB offset,
+							GLsizeiptrARB size, const GLvoid * data)
+{
+	VPMT_Buffer **binding;
+	VPMT_Buffer *buffer;
+	VPMT_BufferStream *stream;
+	GLint *bindingName;
+
+	VPMT_NOT_RENDERING(context);
+
+	binding = BufferTarget(context, target, &bindingName);
+
+	if (!binding) {
+		VPMT_INVALID_ENUM(context);
+		return;
+	}
+
+	buffer = *binding;
+
+	if (!buffer) {
+		VPMT_INVALID_OPERATION(context);
+		return;
+	}
+
+	if (offset < 0 || size < 0 || offset + size > buffer->size || (size && !data)) {
+		VPMT_INVALID_VALUE(context);
+		return;
+	}
+
+	memcpy(buffer->data + offset, data, size);
+
+	/* only the elements overlapping the modified range are converted again */
+	for (stream = buffer->streams; stream; stream = stream->next) {
+		GLintptrARB begin = offset - stream->offset, end = begin + size;
+		GLsizei stride = stream->layout.effectiveStride;
+		GLsizei first, last;
+
+		first = begin < stream->elementSize ? 0 :
+			(GLsizei) ((begin - stream->elementSize) / stride) + 1;
+		last = end <= 0 ? 0 : (GLsizei) VPMT_MIN((end + stride - 1) / stride, stream->count);
+
+		if (first < last) {
+			StreamConvert(stream, first, last - first);
+		}
+	}
+}
+
+void VPMT_ExecDeleteBuffers(VPMT_Context * context, GLsizei n, const GLuint * buffers)
+{
+	VPMT_NOT_RENDERING(context);
+
+	if (n < 0 || !buffers) {
+		VPMT_INVALID_VALUE(context);
+		return;
+	}
+
+	while (n--) {
+		GLuint name = *buffers++;
+		VPMT_Buffer *buffer;
+
+		if (!name) {
+			continue;
+		}
+
+		buffer = VPMT_HashTableFind(&context->buffers, name);
+
+		if (!buffer) {
+			continue;
+		}
+
+		/* reset bindings and arrays referring to the buffer to be deleted */
+		if (context->arrayBuffer == buffer) {
+			VPMT_ExecBindBuffer(context, GL_ARRAY_BUFFER_ARB, 0);
+		}
+
+		if (context->elementArrayBuffer == buffer) {
+			VPMT_ExecBindBuffer(context, GL_ELEMENT_ARRAY_BUFFER_ARB, 0);
+		}
+
+		DetachArrays(context, buffer);
+
+		VPMT_HashTableRemove(&context->buffers, name);
+		VPMT_BufferDeallocate(buffer);
+	}
+}
+
+void VPMT_ExecGenBuffers(VPMT_Context * context, GLsizei n, GLuint * buffers)
+{
+	GLuint base;
+
+	VPMT_NOT_RENDERING(context);
+
+	if (n <= 0 || !buffers) {
+		VPMT_INVALID_VALUE(context);
+		return;
+	}
+
+	base = VPMT_HashTableFreeKeyBlock(&context->buffers, n);
+
+	if (!base) {
+		VPMT_OUT_OF_MEMORY(context);
+		return;
+	}
+
+	while (n--) {
+		VPMT_Buffer *buffer = VPMT_BufferAllocate(base);
+
+		if (!buffer) {
+			VPMT_OUT_OF_MEMORY(context);
+			return;
+		}
+
+		if (!VPMT_HashTableInsert(&context->buffers, base, buffer)) {
+			VPMT_BufferDeallocate(buffer);
+			VPMT_OUT_OF_MEMORY(context);
+			return;
+		}
+
+		*buffers++ = base++;
+	}
+}
+
+/*
+** -------------------------------------------------------------------------
+** Internal functions
+** -------------------------------------------------------------------------
+*/
+
+VPMT_Buffer *VPMT_BufferAllocate(GLuint name)
+{
+	VPMT_Buffer *buffer = VPMT_MALLOC(sizeof(VPMT_Buffer));
+
+	if (buffer) {
+		memset(buffer, 0, sizeof(VPMT_Buffer));
+
+		buffer->name = name;
+		buffer->usage = GL_STATIC_DRAW_ARB;
+	}
+
+	return buffer;
+}
+
+void VPMT_BufferDeallocate(VPMT_Buffer * buffer)
+{
+	while (buffer->streams) {
+		VPMT_BufferStream *stream = buffer->streams;
+
+		buffer->streams = stream->next;
+		StreamDeallocate(stream);
+	}
+
+	VPMT_FREE(buffer->data);
+	VPMT_FREE(buffer);
+}
+
+VPMT_BufferStream *VPMT_BufferStreamAcquire(VPMT_Buffer * buffer, const VPMT_Array * layout,
+											GLintptrARB offset)
+{
+	VPMT_BufferStream *stream;
+
+	for (stream = buffer->streams; stream; stream = stream->next) {
+		if (stream->offset == offset &&
+			stream->layout.type == layout->type &&
+			stream->layout.size == layout->size &&
+			stream->layout.effectiveStride == layout->effectiveStride &&
+			stream->layout.scale == layout->scale && stream->layout.bias == layout->bias) {
+			++stream->refcount;
+			return stream;
+		}
+	}
+
+	stream = VPMT_MALLOC(sizeof(VPMT_BufferStream));
+
+	if (!stream) {
+		return NULL;
+	}
+
+	memset(stream, 0, sizeof(VPMT_BufferStream));
+
+	stream->buffer = buffer;
+	stream->layout = *layout;
+	stream->layout.stream = NULL;
+	stream->offset = offset;
+	stream->elementSize = ElementSize(layout->type, layout->size);
+	stream->refcount = 1;
+
+	if (!StreamAllocate(stream)) {
+		StreamDeallocate(stream);
+		return NULL;
+	}
+
+	StreamConvert(stream, 0, stream->count);
+
+	stream->next = buffer->streams;
+	buffer->streams = stream;
+
+	return stream;
+}
+
+void VPMT_BufferStreamRelease(VPMT_BufferStream * stream)
+{
+	VPMT_BufferStream **link;
+
+	if (--stream->refcount) {
+		return;
+	}
+
+	for (link = &stream->buffer->streams; *link != stream; link = &(*link)->next) {
+		/* find the stream within the list of the buffer */
+	}
+
+	*link = stream->next;
+	StreamDeallocate(stream);
+}
+
+#endif
+
+/* $Id: buffer.c 74 2008-11-23 07:25:12Z hmwill $ */
@@ -0,0 +1,63 @@
+/*
+** -------------------------------------------------------------------------
+** Vincent SC 1.0 Rendering Library
+**
+** Buffer Object Functions
+**
+** Copyright (C) 2008 Vincent Pervasive Media Technologies, LLC. 
+**
+** Licensed under the Artistic License 2.0.
+** -------------------------------------------------------------------------
+*/
+
+#ifndef VPMT_BUFFER_H
+#define VPMT_BUFFER_H
+
+#include "context.h"
+
+#if GL_ARB_vertex_buffer_object
+
+/*
+** An array sourced from a buffer object. The array elements are converted
+** to floating point values once, when the array is specified or the buffer
+** contents change, and are stored as one aligned row per component, which
+** is the layout of the vertex batch. Arrays specified with identical layout
+** share their stream.
+*/
+typedef struct VPMT_BufferStream {
+	struct VPMT_BufferStream *next;							   /* next stream of buffer */
+	struct VPMT_Buffer *buffer;								   /* the buffer sourced */
+	VPMT_Array layout;										   /* array over buffer data */
+	GLintptrARB offset;										   /* offset of first element */
+	GLsizei elementSize;									   /* bytes read per element */
+	GLsizei count;											   /* elements within buffer */
+	GLsizei rowStride;										   /* values per component row */
+	GLfloat *values;										   /* converted components */
+	GLsizei refcount;										   /* number of arrays using it */
+} VPMT_BufferStream;
+
+typedef struct VPMT_Buffer {
+	GLuint name;
+	GLsizeiptrARB size;
+	GLenum usage;
+	GLubyte *data;
+	VPMT_BufferStream *streams;								   /* arrays sourced from buffer */
+} VPMT_Buffer;
+
+VPMT_Buffer *VPMT_BufferAllocate(GLuint name);
+void VPMT_BufferDeallocate(VPMT_Buffer * buffer);
+
+/*
+** Obtain the stream of layout, which sources the buffer starting at offset,
+** converting the buffer contents if no such stream exists yet. Returns NULL
+** if memory is exhausted.
+*/
+VPMT_BufferStream *VPMT_BufferStreamAcquire(VPMT_Buffer * buffer, const VPMT_Array * layout,
+											GLintptrARB offset);
+void VPMT_BufferStreamRelease(VPMT_BufferStream * stream);
+
+#endif
+
+#endif
+
+/* $Id: buffer.h 74 2008-11-23 07:25:12Z hmwill $ */
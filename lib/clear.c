@@ -0,0 +1,364 @@
+/*
+** -------------------------------------------------------------------------
+** Vincent SC 1.0 Rendering Library
+**
+** Tile-level lazy buffer clear
+**
+** Copyright (C) 2008 Vincent Pervasive Media Technologies, LLC. 
+**
+** Licensed under the Artistic License 2.0.
+** -------------------------------------------------------------------------
+*/
+
+#include "common.h"
+#include "GL/gl.h"
+#include "context.h"
+#include "raster.h"
+#include "frame.h"
+#include "clear.h"
+#include "hiz.h"
+#include "zplane.h"
+
+/*
+** -------------------------------------------------------------------------
+** Each buffer of a surface is divided into tiles of VPMT_TILE_SIZE pixels
+** square. Clearing a tile completely only marks it in the clear state of
+** the buffer. The clear value is written into the tile before the first
+** primitive touching the tile is rasterized, or before the pixels of the
+** tile are read or presented. All marked tiles of a buffer share a single
+** clear value.
+** -------------------------------------------------------------------------
+*/
+
+static VPMT_INLINE GLuint TileIndex(GLint tileX, GLint tileY)
+{
+	return tileY * VPMT_CLEAR_TILES_X + tileX;
+}
+
+static VPMT_INLINE GLboolean IsMarked(const VPMT_ClearState * state, GLuint tile)
+{
+	return (state->tiles[tile >> 5] & (1u << (tile & 31))) != 0;
+}
+
+/*
+** Can the surface be covered by the fixed size tile grid?
+*/
+static GLboolean HasTileGrid(const VPMT_Surface * surface)
+{
+	return surface->image.size.width <= VPMT_CLEAR_TILES_X * VPMT_TILE_SIZE &&
+		surface->image.size.height <= VPMT_CLEAR_TILES_Y * VPMT_TILE_SIZE;
+}
+
+/*
+** Intersection of a tile and the surface area
+*/
+static void TileRect(const VPMT_Surface * surface, GLint tileX, GLint tileY, VPMT_Rect * rect)
+{
+	rect->origin[0] = tileX * VPMT_TILE_SIZE;
+	rect->origin[1] = tileY * VPMT_TILE_SIZE;
+	rect->size.width = VPMT_MIN(VPMT_TILE_SIZE, surface->image.size.width - rect->origin[0]);
+	rect->size.height = VPMT_MIN(VPMT_TILE_SIZE, surface->image.size.height - rect->origin[1]);
+}
+
+/*
+** Intersection of rect and the surface area. Returns GL_FALSE if empty.
+*/
+static GLboolean ClipRect(const VPMT_Surface * surface, const VPMT_Rect * rect,
+						  VPMT_Rect * result)
+{
+	VPMT_Rect surfaceRect;
+
+	surfaceRect.origin[0] = 0;
+	surfaceRect.origin[1] = 0;
+	surfaceRect.size = surface->image.size;
+
+	if (rect) {
+		VPMT_IntersectRect(result, rect, &surfaceRect);
+	} else {
+		*result = surfaceRect;
+	}
+
+	return result->size.width > 0 && result->size.height > 0;
+}
+
+static GLboolean ContainsRect(const VPMT_Rect * outer, const VPMT_Rect * inner)
+{
+	return
+		inner->origin[0] >= outer->origin[0] &&
+		inner->origin[1] >= outer->origin[1] &&
+		inner->origin[0] + inner->size.width <= outer->origin[0] + outer->size.width &&
+		inner->origin[1] + inner->size.height <= outer->origin[1] + outer->size.height;
+}
+
+/*
+** Fill the pixels within rect of a buffer with value. The framebuffer
+** is positioned at the origin of the surface.
+*/
+static void FillRect(VPMT_FrameBuffer * fb, GLsizei buffer, const VPMT_Rect * rect, GLuint value,
+					 GLuint mask)
+{
+	VPMT_FrameBufferMove(fb, rect->origin[0], rect->origin[1]);
+	VPMT_FrameFillRect(fb, buffer, rect->size.width, rect->size.height, value, mask);
+	VPMT_FrameBufferMove(fb, -rect->origin[0], -rect->origin[1]);
+}
+
+/*
+** Write the clear value into a marked tile and remove the mark.
+*/
+static void ResolveTile(VPMT_Surface * surface, VPMT_FrameBuffer * fb, GLsizei buffer,
+						GLint tileX, GLint tileY)
+{
+	VPMT_ClearState *state = surface->clearState + buffer;
+	GLuint tile = TileIndex(tileX, tileY);
+	VPMT_Rect rect;
+
+	TileRect(surface, tileX, tileY, &rect);
+	FillRect(fb, buffer, &rect, state->value, ~0u);
+
+	state->tiles[tile >> 5] &= ~(1u << (tile & 31));
+	--state->count;
+}
+
+/*
+** Resolve the marked tiles of a buffer intersecting rect. If outside is set,
+** the tiles contained in rect are skipped instead.
+*/
+static void ResolveTiles(VPMT_Surface * surface, VPMT_FrameBuffer * fb, GLsizei buffer,
+						 const VPMT_Rect * rect, GLboolean outside)
+{
+	VPMT_ClearState *state = surface->clearState + buffer;
+	GLint tileX, tileY, tileMinX, tileMinY, tileMaxX, tileMaxY;
+	VPMT_Rect tileRect;
+
+	if (outside) {
+		tileMinX = tileMinY = 0;
+		tileMaxX = (surface->image.size.width - 1) / VPMT_TILE_SIZE;
+		tileMaxY = (surface->image.size.height - 1) / VPMT_TILE_SIZE;
+	} else {
+		tileMinX = rect->origin[0] / VPMT_TILE_SIZE;
+		tileMinY = rect->origin[1] / VPMT_TILE_SIZE;
+		tileMaxX = (rect->origin[0] + rect->size.width - 1) / VPMT_TILE_SIZE;
+		tileMaxY = (rect->origin[1] + rect->size.height - 1) / VPMT_TILE_SIZE;
+	}
+
+	for (tileY = tileMinY; tileY <= tileMaxY && state->count; ++tileY) {
+		for (tileX = tileMinX; tileX <= tileMaxX; ++tileX) {
+			if (!IsMarked(state, TileIndex(tileX, tileY))) {
+				continue;
+			}
+
+			if (outside) {
+				TileRect(surface, tileX, tileY, &tileRect);
+
+				if (ContainsRect(rect, &tileRect)) {
+					continue;
+				}
+			}
+
+			ResolveTile(surface, fb, buffer, tileX, tileY);
+		}
+	}
+}
+
+/*
+** Clear the pixels within rect of a buffer to value under the write mask
+** mask. Completely covered tiles are marked if all bits are written.
+*/
+static void ClearBuffer(VPMT_Surface * surface, VPMT_FrameBuffer * fb, GLsizei buffer,
+						const VPMT_Rect * rect, GLuint value, GLuint mask)
+{
+	VPMT_ClearState *state = surface->clearState + buffer;
+	GLuint allBits = VPMT_FrameAllBits(fb, buffer);
+	GLint tileX, tileY, tileMinX, tileMinY, tileMaxX, tileMaxY;
+	VPMT_Rect tileRect, fillRect;
+
+	if (!(mask & allBits)) {
+		return;
+	}
+
+	if (!VPMT_LAZY_CLEAR || (mask & allBits) != allBits || !HasTileGrid(surface)) {
+		/* partial updates need the previous contents */
+		if (state->count) {
+			ResolveTiles(surface, fb, buffer, rect, GL_FALSE);
+		}
+
+		FillRect(fb, buffer, rect, value, mask);
+		return;
+	}
+
+	value &= allBits;
+
+	if (state->count && state->value != value) {
+		/* marked tiles that are not overwritten completely keep the old value */
+		ResolveTiles(surface, fb, buffer, rect, GL_TRUE);
+	}
+
+	state->value = value;
+
+	tileMinX = rect->origin[0] / VPMT_TILE_SIZE;
+	tileMinY = rect->origin[1] / VPMT_TILE_SIZE;
+	tileMaxX = (rect->origin[0] + rect->size.width - 1) / VPMT_TILE_SIZE;
+	tileMaxY = (rect->origin[1] + rect->size.height - 1) / VPMT_TILE_SIZE;
+
+	for (tileY = tileMinY; tileY <= tileMaxY; ++tileY) {
+		for (tileX = tileMinX; tileX <= tileMaxX; ++tileX) {
+			GLuint tile = TileIndex(tileX, tileY);
+
+			if (IsMarked(state, tile)) {
+				/* already cleared to the same value */
+				continue;
+			}
+
+			TileRect(surface, tileX, tileY, &tileRect);
+
+			if (ContainsRect(rect, &tileRect)) {
+				state->tiles[tile >> 5] |= 1u << (tile & 31);
+				++state->count;
+			} else {
+				VPMT_IntersectRect(&fillRect, rect, &tileRect);
+				FillRect(fb, buffer, &fillRect, value, ~0u);
+			}
+		}
+	}
+}
+
+/*
+** -------------------------------------------------------------------------
+** Rasterizer functions resolving the tiles touched by a primitive
+** -------------------------------------------------------------------------
+*/
+
+static void ResolveBounds(VPMT_Context * context, const VPMT_Rect * bounds)
+{
+	VPMT_Rect rect;
+
+	if (VPMT_ClearPending(context->writeSurface)) {
+		VPMT_IntersectRect(&rect, bounds, &context->activeSurfaceRect);
+
+		if (rect.size.width > 0 && rect.size.height > 0) {
+			VPMT_ClearResolve(context->writeSurface, &rect);
+		}
+	}
+}
+
+static void ClearRasterPoint(VPMT_Context * context, const VPMT_RasterVertex * a)
+{
+	VPMT_Rect bounds;
+
+	VPMT_RasterPointBounds(context, a, &bounds);
+	ResolveBounds(context, &bounds);
+	context->clearRasterPoint(context, a);
+}
+
+static void ClearRasterLine(VPMT_Context * context, const VPMT_RasterVertex * a,
+							const VPMT_RasterVertex * b)
+{
+	VPMT_Rect bounds;
+
+	VPMT_RasterLineBounds(context, a, b, &bounds);
+	ResolveBounds(context, &bounds);
+	context->clearRasterLine(context, a, b);
+}
+
+static void ClearRasterTriangle(VPMT_Context * context, const VPMT_RasterVertex * a,
+								const VPMT_RasterVertex * b, const VPMT_RasterVertex * c)
+{
+	VPMT_Rect bounds;
+
+	VPMT_RasterTriangleBounds(context, a, b, c, &bounds);
+	ResolveBounds(context, &bounds);
+	context->clearRasterTriangle(context, a, b, c);
+}
+
+/*
+** -------------------------------------------------------------------------
+** Exported functions
+** -------------------------------------------------------------------------
+*/
+
+void VPMT_ClearInit(VPMT_Surface * surface)
+{
+	memset(surface->clearState, 0, sizeof(surface->clearState));
+}
+
+void VPMT_ClearBuffers(VPMT_Context * context, GLbitfield mask)
+{
+	VPMT_Surface *surface = context->writeSurface;
+	VPMT_FrameBuffer fb;
+	VPMT_Rect rect;
+
+	if (!ClipRect(surface, &context->activeSurfaceRect, &rect)) {
+		return;
+	}
+
+	VPMT_FrameBufferInit(&fb, surface);
+
+	if (mask & GL_COLOR_BUFFER_BIT) {
+		ClearBuffer(surface, &fb, VPMT_FRAME_COLOR_BUFFER, &rect,
+					VPMT_FrameColorValue(&fb, VPMT_ConvertVec4ToColor4ub(context->clearColor)),
+					VPMT_FrameColorMask(&fb, context->colorWriteMask));
+	}
+
+	if (mask & (GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT)) {
+		GLuint clearDepth = (GLuint) (context->depthFixedPointScale * context->clearDepth);
+
+		if (mask & GL_DEPTH_BUFFER_BIT) {
+			VPMT_ZPlaneClear(surface, &rect, clearDepth);
+		}
+
+		ClearBuffer(surface, &fb, VPMT_FRAME_DEPTH_STENCIL_BUFFER, &rect,
+					VPMT_FrameDepthStencilValue(&fb, clearDepth, context->clearStencil),
+					VPMT_FrameDepthStencilMask(&fb, (mask & GL_DEPTH_BUFFER_BIT) != 0,
+											   (mask & GL_STENCIL_BUFFER_BIT) ?
+											   context->stencilWriteMask : 0));
+
+		if (mask & GL_DEPTH_BUFFER_BIT) {
+			VPMT_HiZClear(surface, &rect, clearDepth);
+		}
+	}
+}
+
+void VPMT_ClearResolve(VPMT_Surface * surface, const VPMT_Rect * rect)
+{
+	VPMT_FrameBuffer fb;
+	VPMT_Rect clipped;
+	GLsizei buffer;
+
+	if (!VPMT_ClearPending(surface) || !ClipRect(surface, rect, &clipped)) {
+		return;
+	}
+
+	VPMT_FrameBufferInit(&fb, surface);
+
+	for (buffer = 0; buffer < VPMT_MAX_RENDER_BUFFERS; ++buffer) {
+		if (surface->clearState[buffer].count) {
+			ResolveTiles(surface, &fb, buffer, &clipped, GL_FALSE);
+		}
+	}
+}
+
+void VPMT_ClearPrepare(VPMT_Context * context)
+{
+	if (!context->writeSurface || !VPMT_ClearPending(context->writeSurface)) {
+		return;
+	}
+
+	switch (context->primitiveType) {
+	case GL_POINTS:
+		context->clearRasterPoint = context->rasterPoint;
+		context->rasterPoint = ClearRasterPoint;
+		break;
+
+	case GL_LINES:
+		context->clearRasterLine = context->rasterLine;
+		context->rasterLine = ClearRasterLine;
+		break;
+
+	case GL_TRIANGLES:
+		context->clearRasterTriangle = context->rasterTriangle;
+		context->rasterTriangle = ClearRasterTriangle;
+		break;
+	}
+}
+
+/* $Id: clear.c 74 2008-11-23 07:25:12Z hmwill $ */
@@ -0,0 +1,51 @@
+/*
+** -------------------------------------------------------------------------
+** Vincent SC 1.0 Rendering Library
+**
+** Tile-level lazy buffer clear
+**
+** Copyright (C) 2008 Vincent Pervasive Media Technologies, LLC. 
+**
+** Licensed under the Artistic License 2.0.
+** -------------------------------------------------------------------------
+*/
+
+#ifndef VPMT_CLEAR_H
+#define VPMT_CLEAR_H
+
+#include "context.h"
+
+/*
+** Reset the lazy clear state of a newly created surface.
+*/
+void VPMT_ClearInit(VPMT_Surface * surface);
+
+/*
+** Clear the buffers selected by mask within the active surface rect of the
+** locked write surface. Tiles that are covered completely are only marked
+** as cleared; their clear value is written by VPMT_ClearResolve.
+*/
+void VPMT_ClearBuffers(VPMT_Context * context, GLbitfield mask);
+
+/*
+** Write the clear value into all marked tiles of the locked surface that
+** intersect rect, or into all marked tiles if rect is NULL. Needs to be
+** called before the pixels within rect are accessed.
+*/
+void VPMT_ClearResolve(VPMT_Surface * surface, const VPMT_Rect * rect);
+
+/*
+** Install rasterizer functions that resolve the tiles touched by each
+** primitive in front of the rasterizer selected for the current primitive
+** type. Needs to be called after VPMT_TilePrepare.
+*/
+void VPMT_ClearPrepare(VPMT_Context * context);
+
+static VPMT_INLINE GLboolean VPMT_ClearPending(const VPMT_Surface * surface)
+{
+	return surface->clearState[0].count || surface->clearState[1].count;
+}
+
+#endif
+
+/* $Id: clear.h 74 2008-11-23 07:25:12Z hmwill $ */
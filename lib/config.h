@@ -68,12 +68,27 @@
 #define VPMT_PACK_ALIGNMENT					4				   /* internal alignment       */
 #define VPMT_COMMAND_BUFFER_SIZE			512				   /* Display list increment   */
 #define VPMT_MAX_RENDER_BUFFERS				2				   /* maximum number of buffers attached to framebuffer */
+#define VPMT_FRAGMENT_SPAN_SIZE				32				   /* max. fragments per span, multiple of 4, <= 32 */
+#define VPMT_PERSPECTIVE_SPAN				8				   /* pixels per perspective division, power of 2 */
+#define VPMT_PERSPECTIVE_SPAN_FASTEST		16				   /* same, for GL_FASTEST */
+#define VPMT_VERTEX_BATCH					16				   /* vertices transformed at once, multiple of 8 */
+#define VPMT_VERTEX_CACHE_SIZE				32				   /* post-transform cache entries, power of 2 */
 
 #define VPMT_FUNCTION_CACHE_ENRIES			128				   /* number of cached functions */
 #define VPMT_FUNCTION_CACHE_SIZE			65536			   /* code cache size */
 #define VPMT_FUNCTION_STATE_SIZE_INIT		1024			   /* initial state buffer */
 #define VPMT_FUNCTION_CODE_SIZE_INIT		4096			   /* initial code buffer */
 
+#define VPMT_TILE_SIZE						64				   /* raster tile size, power of 2 */
+#define VPMT_RASTER_THREADS					0				   /* tiled rasterizer threads, 0 = off */
+#define VPMT_TILE_PRIMITIVES_INIT			256				   /* initial primitive buffer */
+#define VPMT_TILE_BIN_SIZE_INIT				64				   /* initial tile bin size */
+#define VPMT_LAZY_CLEAR						1				   /* tile-level lazy clear, 0 = off */
+#define VPMT_HIERARCHICAL_Z					1				   /* block depth rejection, 0 = off */
+#define VPMT_DEPTH_PLANES					0				   /* plane compressed depth blocks, 0 = off */
+#define VPMT_TILED_SURFACE					0				   /* tiled surface memory layout, 0 = linear */
+#define VPMT_SURFACE_TILE_BITS				3				   /* log2 of surface tile size */
+
 /*
 ** -------------------------------------------------------------------------
 ** Platform constants
@@ -16,6 +16,8 @@
 #include "command.h"
 #include "dispatch.h"
 #include "exec.h"
+#include "tile.h"
+#include "buffer.h"
 
 /*
 ** -------------------------------------------------------------------------
@@ -135,6 +137,16 @@ static const StateVariable StateVariables[] = {
 	,
 	{GL_ALPHA_TEST_FUNC, GL_INT, 1, O(alphaFunc)}
 	,
+#if GL_ARB_vertex_buffer_object
+	{GL_ARRAY_BUFFER_BINDING_ARB, GL_INT, 1, O(arrayBufferBinding)}
+	,
+#endif
+#if GL_EXT_compiled_vertex_array
+	{GL_ARRAY_ELEMENT_LOCK_COUNT_EXT, GL_INT, 1, O(lockCount)}
+	,
+	{GL_ARRAY_ELEMENT_LOCK_FIRST_EXT, GL_INT, 1, O(lockFirst)}
+	,
+#endif
 	{GL_BLEND_DST, GL_INT, 1, O(blendDstFactor)}
 	,
 	{GL_BLEND_SRC, GL_INT, 1, O(blendSrcFactor)}
@@ -155,6 +167,10 @@ static const StateVariable StateVariables[] = {
 	,
 	{GL_DEPTH_FUNC, GL_INT, 1, O(depthFunc)}
 	,
+#if GL_ARB_vertex_buffer_object
+	{GL_ELEMENT_ARRAY_BUFFER_BINDING_ARB, GL_INT, 1, O(elementArrayBufferBinding)}
+	,
+#endif
 	{GL_FRONT_FACE, GL_INT, 1, O(frontFace)}
 	,
 	{GL_GREEN_BITS, GL_INT, 1, O(greenBits)}
@@ -569,6 +585,21 @@ const GLubyte *VPMT_ExecGetString(VPMT_Context * context, GLenum name)
 #endif
 #if GL_EXT_paletted_texture
 			" GL_EXT_paletted_texture"
+#endif
+#if GL_OES_vertex_half_float
+			" GL_OES_vertex_half_float"
+#endif
+#if GL_ARB_vertex_buffer_object
+			" GL_ARB_vertex_buffer_object"
+#endif
+#if GL_EXT_compiled_vertex_array
+			" GL_EXT_compiled_vertex_array"
+#endif
+#if GL_EXT_multi_draw_arrays
+			" GL_EXT_multi_draw_arrays"
+#endif
+#if GL_VPMT_instanced_modelview
+			" GL_VPMT_instanced_modelview"
 #endif
 			;
 
@@ -734,6 +765,12 @@ GLboolean VPMT_ContextInitialize(VPMT_Context * context)
 		VPMT_ArrayInitialize(context->texCoordArray + index);
 	}
 
+#if GL_ARB_vertex_buffer_object
+	VPMT_HashTableInitialize(&context->buffers);
+	context->arrayBuffer = context->elementArrayBuffer = NULL;
+	context->arrayBufferBinding = context->elementArrayBufferBinding = 0;
+#endif
+
 	/* initialize hint context */
 	context->perspectiveCorrectionHint = GL_DONT_CARE;
 	context->pointSmoothHint = GL_DONT_CARE;
@@ -890,6 +927,23 @@ GLboolean VPMT_ContextInitialize(VPMT_Context * context)
 	/* surfaces and pixel owner ship test */
 	context->readSurface = context->writeSurface = NULL;
 
+	/* tiled rasterizer; if it cannot be created we rasterize on the calling thread */
+	context->tiler = VPMT_TilerAllocate(VPMT_RASTER_THREADS);
+
+	context->rasterSpan = NULL;
+
+	/* vertex range buffer of DrawElements, allocated on demand */
+	context->vertexCache.range = NULL;
+	context->vertexCache.rangeSize = 0;
+
+#if GL_EXT_compiled_vertex_array
+	/* no array range is locked */
+	context->lockFirst = 0;
+	context->lockCount = 0;
+	context->lockedVertices = NULL;
+	context->lockedValid = GL_FALSE;
+#endif
+
 	return GL_TRUE;
 
   cleanup:
@@ -907,6 +961,13 @@ static void FreeList(GLuint id, void * obj, void * arg)
 	VPMT_CommandBufferDispose((VPMT_CommandBuffer *) obj);
 }
 
+#if GL_ARB_vertex_buffer_object
+static void FreeBuffer(GLuint id, void * obj, void * arg) 
+{
+	VPMT_BufferDeallocate((VPMT_Buffer *) obj);
+}
+#endif
+
 void VPMT_ContextDeinitialize(VPMT_Context * context)
 {
 	/* remove references to surfaces */
@@ -919,6 +980,25 @@ void VPMT_ContextDeinitialize(VPMT_Context * context)
 	/* remove all texture data */
 	VPMT_HashTableIterate(&context->textures, FreeTexture, context);
 	VPMT_HashTableDeinitialize(&context->textures);
+
+#if GL_ARB_vertex_buffer_object
+	/* remove all buffer objects */
+	VPMT_HashTableIterate(&context->buffers, FreeBuffer, context);
+	VPMT_HashTableDeinitialize(&context->buffers);
+#endif
+
+	/* shut down the rasterizer threads */
+	VPMT_TilerDeallocate(context->tiler);
+	context->tiler = NULL;
+
+	VPMT_FREE(context->vertexCache.range);
+	context->vertexCache.range = NULL;
+	context->vertexCache.rangeSize = 0;
+
+#if GL_EXT_compiled_vertex_array
+	VPMT_FREE(context->lockedVertices);
+	context->lockedVertices = NULL;
+#endif
 }
 
 static void Toggle(VPMT_Context * context, GLenum cap, GLboolean enable)
@@ -1064,6 +1144,8 @@ GLAPI GLboolean APIENTRY VPMT_MakeCurrent(VPMT_Surface * writeSurface, VPMT_Surf
 {
 	VPMT_Context *context = VPMT_CONTEXT();
 
+	VPMT_TileFlush(context);
+
 	if (readSurface) {
 		readSurface->vtbl->addref(readSurface);
 	}
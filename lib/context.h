@@ -23,20 +23,32 @@
 typedef struct VPMT_Context VPMT_Context;
 typedef struct VPMT_Array VPMT_Array;
 
+struct VPMT_Buffer;
+struct VPMT_BufferStream;
+
 typedef void (*ArrayFetchFunc) (const VPMT_Array * array, GLsizei index, GLfloat * result);
+typedef void (*ArrayConvertFunc) (const VPMT_Array * array, GLint first, GLsizei count,
+								  GLsizei size, GLfloat (*result)[VPMT_VERTEX_BATCH]);
 
 struct VPMT_Array {
 	ArrayFetchFunc fetch;
+	ArrayConvertFunc convert;								   /* bulk conversion to batch */
 	const void *pointer;
 	GLint size;
 	GLint stride;
 	GLint effectiveStride;
 	GLenum type;
 	GLboolean enabled;
+	GLfloat scale, bias;									   /* dequantization of values */
+	struct VPMT_BufferStream *stream;						   /* converted buffer contents */
 };
 
 void VPMT_ArrayInitialize(VPMT_Array * array);
 
+#if GL_ARB_vertex_buffer_object
+void VPMT_ArrayDetachBuffer(VPMT_Array * array);
+#endif
+
 typedef struct VPMT_Pattern {
 	GLubyte bytes[128];
 } VPMT_Pattern;
@@ -60,6 +72,72 @@ typedef struct VPMT_RasterVertex {
 	GLfloat rho[VPMT_MAX_TEX_UNITS];
 } VPMT_RasterVertex;
 
+/*
+** Vertices collected between begin/end, stored as structure of arrays so that
+** they can be transformed and lit several at a time.
+*/
+typedef struct VPMT_VertexBatch {
+	GLfloat coords[3][VPMT_VERTEX_BATCH];					   /* object coordinates */
+	GLfloat normals[3][VPMT_VERTEX_BATCH];					   /* object normals */
+	GLfloat colors[4][VPMT_VERTEX_BATCH];					   /* current colors */
+	GLfloat texCoords[VPMT_MAX_TEX_UNITS][2][VPMT_VERTEX_BATCH];
+	GLfloat coordScale;										   /* dequantization of coords */
+	GLfloat normalScale;									   /* dequantization of normals */
+	GLfloat texCoordScale[VPMT_MAX_TEX_UNITS];				   /* dequantization of tex. coords */
+	GLfloat texCoordBias[VPMT_MAX_TEX_UNITS];
+	GLsizei count;											   /* number of collected vertices */
+	VPMT_Vertex vertices[VPMT_VERTEX_BATCH];				   /* transformed vertices */
+	const VPMT_Vertex *current;								   /* vertex passed to assembly */
+} VPMT_VertexBatch;
+
+/*
+** Transformed vertices of the current DrawElements call, either kept in a
+** direct mapped cache indexed by array index, or for a complete range of
+** array indices.
+*/
+typedef struct VPMT_VertexCache {
+	GLuint tags[VPMT_VERTEX_CACHE_SIZE];					   /* array index held by entry */
+	GLuint uses[VPMT_VERTEX_CACHE_SIZE];					   /* last chunk referencing entry */
+	VPMT_Vertex vertices[VPMT_VERTEX_CACHE_SIZE];			   /* cached vertices */
+	VPMT_Vertex *range;										   /* vertices of an index range */
+	GLsizei rangeSize;										   /* allocated size of range */
+} VPMT_VertexCache;
+
+#if GL_EXT_compiled_vertex_array
+/*
+** The state that vertex transformation depends on, as captured when the
+** vertices of the locked array range were transformed.
+*/
+typedef struct VPMT_LockedState {
+	VPMT_Matrix modelview;
+	VPMT_Matrix projection;
+
+	VPMT_Vec4 color;										   /* current values */
+	VPMT_Vec3 normal;
+	VPMT_Vec4 texCoords[VPMT_MAX_TEX_UNITS];
+
+	VPMT_Vec4 materialAmbient;
+	VPMT_Vec4 materialDiffuse;
+	VPMT_Vec4 materialEmission;
+	VPMT_Vec4 materialSpecular;
+	GLfloat materialShininess;
+	VPMT_Vec4 lightModelAmbient;
+	VPMT_Vec4 lightAmbient[VPMT_MAX_LIGHTS];
+	VPMT_Vec4 lightDiffuse[VPMT_MAX_LIGHTS];
+	VPMT_Vec4 lightSpecular[VPMT_MAX_LIGHTS];
+	VPMT_Vec4 lightDirection[VPMT_MAX_LIGHTS];
+	VPMT_Vec4 lightHighlightDirection[VPMT_MAX_LIGHTS];
+
+	VPMT_Array arrays[3 + VPMT_MAX_TEX_UNITS];				   /* array specification */
+
+	GLboolean lightEnabled[VPMT_MAX_LIGHTS];
+	GLboolean lightingEnabled;
+	GLboolean colorMaterialEnabled;
+	GLboolean normalizeEnabled;
+	GLboolean rescaleNormalEnabled;
+} VPMT_LockedState;
+#endif
+
 typedef void (*VPMT_VertexFunction) (struct VPMT_Context * context);
 typedef void (*VPMT_EndFunction) (struct VPMT_Context * context);
 typedef void (*VPMT_TransformFunction) (VPMT_Context * context, VPMT_Vertex * vertex);
@@ -72,6 +150,56 @@ typedef void (*VPMT_TransformFunction) (VPMT_Context * context, VPMT_Vertex * ve
 
 struct VPMT_Surface;
 
+#define VPMT_CLEAR_TILES_X		(VPMT_MAX_VIEWPORT_WIDTH / VPMT_TILE_SIZE)
+#define VPMT_CLEAR_TILES_Y		(VPMT_MAX_VIEWPORT_HEIGHT / VPMT_TILE_SIZE)
+#define VPMT_CLEAR_TILE_WORDS	((VPMT_CLEAR_TILES_X * VPMT_CLEAR_TILES_Y + 31) / 32)
+
+/**
+ * Lazy clear state of a surface buffer. Marked tiles have not been written
+ * since they were cleared, and their memory content is undefined.
+ */
+typedef struct VPMT_ClearState {
+	GLuint tiles[VPMT_CLEAR_TILE_WORDS];					   /* bit mask of cleared tiles */
+	GLuint value;											   /* packed clear value */
+	GLsizei count;											   /* number of marked tiles */
+} VPMT_ClearState;
+
+#define VPMT_HIZ_BLOCK_BITS		3							   /* block size of the block rasterizer */
+#define VPMT_HIZ_BLOCK_SIZE		(1 << VPMT_HIZ_BLOCK_BITS)
+
+/**
+ * Hierarchical depth state of a surface. Each block of the depth buffer
+ * stores an upper bound of the depth values within the block.
+ */
+typedef struct VPMT_HiZState {
+	GLuint *blocks;											   /* farthest depth per block */
+	GLsizei width;											   /* blocks per row */
+	GLsizei height;											   /* block rows */
+	GLboolean valid;										   /* bounds are up to date */
+} VPMT_HiZState;
+
+/**
+ * Plane equation of a depth buffer block. The depth values of the block
+ * are those written by a triangle with the given interpolation parameters,
+ * where the interpolation of each row has started start[row] pixels to the
+ * left of the block.
+ */
+typedef struct VPMT_DepthPlane {
+	GLfloat depth;											   /* depth at the center of pixel (0, 0) */
+	GLfloat dx, dy;											   /* depth increments */
+	GLubyte start[VPMT_HIZ_BLOCK_SIZE];						   /* interpolation start per row */
+	GLboolean compressed;									   /* block memory is not up to date */
+} VPMT_DepthPlane;
+
+/**
+ * Compressed depth state of a surface, using the blocks of VPMT_HiZState
+ */
+typedef struct VPMT_DepthPlaneState {
+	VPMT_DepthPlane *blocks;								   /* plane per block */
+	GLsizei width;											   /* blocks per row */
+	GLsizei height;											   /* block rows */
+} VPMT_DepthPlaneState;
+
 /**
  * Virtual function table for render surfaces
  */
@@ -104,15 +232,22 @@ typedef struct VPMT_Surface {
 	GLint refcount;
 	const VPMT_SurfaceVtbl *vtbl;
 	VPMT_Image2D image;
+	GLvoid *colorBuffer;									   /* tiled color buffer, see frame.h */
 	GLvoid *depthStencilBuffer;
 	const VPMT_DepthStencilFormat *depthStencilFormat;
+	VPMT_ClearState clearState[VPMT_MAX_RENDER_BUFFERS];	   /* lazy clear, see clear.h */
+	VPMT_HiZState hiZ;										   /* block depth bounds, see hiz.h */
+	VPMT_DepthPlaneState depthPlanes;						   /* compressed depth, see zplane.h */
 } VPMT_Surface;
 
+struct VPMT_Span;
+
 typedef void (*VPMT_RasterPointFunc) (VPMT_Context * context, const VPMT_RasterVertex * a);
 typedef void (*VPMT_RasterLineFunc) (VPMT_Context * context, const VPMT_RasterVertex * a,
 									 const VPMT_RasterVertex * b);
 typedef void (*VPMT_RasterTriangleFunc) (VPMT_Context * context, const VPMT_RasterVertex * a,
 										 const VPMT_RasterVertex * b, const VPMT_RasterVertex * c);
+typedef void (*VPMT_RasterSpanFunc) (const struct VPMT_Span * span);
 
 struct VPMT_Context {
 
@@ -135,6 +270,16 @@ struct VPMT_Context {
 	VPMT_RasterPointFunc rasterPoint;
 	VPMT_RasterLineFunc rasterLine;
 	VPMT_RasterTriangleFunc rasterTriangle;
+	VPMT_RasterSpanFunc rasterSpan;							   /* precompiled span function or NULL */
+	VPMT_RasterSpanFunc rasterColorSpan;					   /* span function without depth test */
+
+	/* rasterizer functions wrapped by VPMT_ClearPrepare */
+	VPMT_RasterPointFunc clearRasterPoint;
+	VPMT_RasterLineFunc clearRasterLine;
+	VPMT_RasterTriangleFunc clearRasterTriangle;
+
+	GLuint hiZMode;											   /* selected by VPMT_HiZPrepare */
+	GLboolean depthPlaneMode;								   /* selected by VPMT_ZPlanePrepare */
 
 	/* hints */
 	GLenum perspectiveCorrectionHint;
@@ -235,6 +380,15 @@ struct VPMT_Context {
 	VPMT_Array texCoordArray[VPMT_MAX_TEX_UNITS];
 	VPMT_Array vertexArray;
 
+#if GL_ARB_vertex_buffer_object
+	/* buffer objects */
+	VPMT_HashTable buffers;
+	struct VPMT_Buffer *arrayBuffer;
+	struct VPMT_Buffer *elementArrayBuffer;
+	GLint arrayBufferBinding;								   /* shortcut for state queries */
+	GLint elementArrayBufferBinding;						   /* shortcut for state queries */
+#endif
+
 	/* polygon stipple pattern */
 	VPMT_Pattern polygonStipple;
 
@@ -264,6 +418,17 @@ struct VPMT_Context {
 
 	VPMT_Vertex vertexQueue[4];								   /* array of vertices during begin/end */
 	VPMT_Vertex tempVertices[12];							   /* temp. vertices for cipping */
+	VPMT_VertexBatch vertexBatch;							   /* vertices pending transformation */
+	VPMT_VertexCache vertexCache;							   /* transformed array elements */
+
+#if GL_EXT_compiled_vertex_array
+	GLint lockFirst;										   /* locked array range */
+	GLint lockCount;										   /* 0 if not locked */
+	VPMT_Vertex *lockedVertices;							   /* transformed locked range */
+	GLboolean lockedValid;									   /* lockedVertices up to date */
+	VPMT_LockedState lockedState;							   /* state of lockedVertices */
+#endif
+
 	VPMT_VertexFunction vertexFunction;
 	VPMT_EndFunction endFunction;
 	VPMT_TransformFunction transformFunction;				   /* vertex transformation */
@@ -290,7 +455,10 @@ struct VPMT_Context {
 
 	/* rasterizer execution flags */
 	GLuint rasterInterpolants;								   /* which vairables to interpolate */
+	GLboolean rasterDepthOnly;								   /* no shading, depth & stencil only */
 	GLubyte alphaRefub;										   /* alpha reference as unsigned byte */
+
+	struct VPMT_Tiler *tiler;								   /* tiled rasterizer; NULL if serial */
 };
 
 /* exported functions to initialize the library */
@@ -341,9 +509,23 @@ void VPMT_LightVertex(VPMT_Context * context, GLfloat * resultColor,
 
 void VPMT_Fragment(VPMT_Context * context, struct VPMT_FrameBuffer *fb, VPMT_Color4ub newColor,
 				   GLuint depth);
+GLboolean VPMT_FragmentDepthStencil(VPMT_Context * context, struct VPMT_FrameBuffer *fb,
+									GLuint depth);
+void VPMT_FragmentColor(VPMT_Context * context, struct VPMT_FrameBuffer *fb,
+						VPMT_Color4ub newColor);
+void VPMT_FragmentSpan(VPMT_Context * context, struct VPMT_FrameBuffer *fb, GLsizei count,
+					   const VPMT_Color4ub colors[], const GLuint depths[], GLuint mask);
+GLuint VPMT_FragmentSpanDepthStencil(VPMT_Context * context, struct VPMT_FrameBuffer *fb,
+									 GLsizei count, const GLuint depths[], GLuint mask);
+void VPMT_FragmentSpanColor(VPMT_Context * context, struct VPMT_FrameBuffer *fb, GLsizei count,
+							const VPMT_Color4ub colors[], GLuint mask);
 
 void VPMT_UpdateActiveSurfaceRect(VPMT_Context * context, const VPMT_Rect * rect);
 
+void VPMT_RenderVertices(VPMT_Context * context, VPMT_Vertex * vertices, GLsizei count,
+						 GLenum type, const GLvoid * indices, GLuint base);
+void VPMT_RenderRestart(VPMT_Context * context);
+
 
 #endif
 
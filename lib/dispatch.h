@@ -143,6 +143,36 @@ typedef struct VPMT_Dispatch {
 	void (*GetColorTableParameteriv) (VPMT_Context * context, GLenum target, GLenum pname,
 									  GLint * params);
 #endif
+
+#if GL_ARB_vertex_buffer_object
+	void (*BindBuffer) (VPMT_Context * context, GLenum target, GLuint buffer);
+	void (*BufferData) (VPMT_Context * context, GLenum target, GLsizeiptrARB size,
+						const GLvoid * data, GLenum usage);
+	void (*BufferSubData) (VPMT_Context * context, GLenum target, GLintptrARB offset,
+						   GLsizeiptrARB size, const GLvoid * data);
+	void (*DeleteBuffers) (VPMT_Context * context, GLsizei n, const GLuint * buffers);
+	void (*GenBuffers) (VPMT_Context * context, GLsizei n, GLuint * buffers);
+#endif
+
+#if GL_EXT_compiled_vertex_array
+	void (*LockArrays) (VPMT_Context * context, GLint first, GLsizei count);
+	void (*UnlockArrays) (VPMT_Context * context);
+#endif
+
+#if GL_EXT_multi_draw_arrays
+	void (*MultiDrawArrays) (VPMT_Context * context, GLenum mode, const GLint * first,
+							 const GLsizei * count, GLsizei primcount);
+	void (*MultiDrawElements) (VPMT_Context * context, GLenum mode, const GLsizei * count,
+							   GLenum type, const GLvoid ** indices, GLsizei primcount);
+#endif
+
+#if GL_VPMT_instanced_modelview
+	void (*DrawArraysInstanced) (VPMT_Context * context, GLenum mode, GLint first, GLsizei count,
+								 GLsizei primcount, const GLfloat * modelviews);
+	void (*DrawElementsInstanced) (VPMT_Context * context, GLenum mode, GLsizei count,
+								   GLenum type, const GLvoid * indices, GLsizei primcount,
+								   const GLfloat * modelviews);
+#endif
 } VPMT_Dispatch;
 
 extern struct VPMT_Dispatch VPMT_DispatchExecute, VPMT_DispatchRecord;
@@ -15,6 +15,7 @@
 
 void VPMT_ExecActiveTexture(VPMT_Context * context, GLenum texture);
 void VPMT_ExecAlphaFunc(VPMT_Context * context, GLenum func, GLclampf ref);
+void VPMT_ExecArrayElement(VPMT_Context * context, GLint i);
 void VPMT_ExecBegin(VPMT_Context * context, GLenum mode);
 void VPMT_ExecBindTexture(VPMT_Context * context, GLenum target, GLuint name);
 void VPMT_ExecBitmap(VPMT_Context * context, GLsizei width, GLsizei height, GLfloat xorig,
@@ -155,6 +156,36 @@ void VPMT_ExecColorTableImage(VPMT_Context * context, GLenum target, const VPMT_
 
 #endif
 
+#if GL_ARB_vertex_buffer_object
+void VPMT_ExecBindBuffer(VPMT_Context * context, GLenum target, GLuint buffer);
+void VPMT_ExecBufferData(VPMT_Context * context, GLenum target, GLsizeiptrARB size,
+						 const GLvoid * data, GLenum usage);
+void VPMT_ExecBufferSubData(VPMT_Context * context, GLenum target, GLintptrARB offset,
+							GLsizeiptrARB size, const GLvoid * data);
+void VPMT_ExecDeleteBuffers(VPMT_Context * context, GLsizei n, const GLuint * buffers);
+void VPMT_ExecGenBuffers(VPMT_Context * context, GLsizei n, GLuint * buffers);
+#endif
+
+#if GL_EXT_compiled_vertex_array
+void VPMT_ExecLockArrays(VPMT_Context * context, GLint first, GLsizei count);
+void VPMT_ExecUnlockArrays(VPMT_Context * context);
+#endif
+
+#if GL_EXT_multi_draw_arrays
+void VPMT_ExecMultiDrawArrays(VPMT_Context * context, GLenum mode, const GLint * first,
+							  const GLsizei * count, GLsizei primcount);
+void VPMT_ExecMultiDrawElements(VPMT_Context * context, GLenum mode, const GLsizei * count,
+								GLenum type, const GLvoid ** indices, GLsizei primcount);
+#endif
+
+#if GL_VPMT_instanced_modelview
+void VPMT_ExecDrawArraysInstanced(VPMT_Context * context, GLenum mode, GLint first,
+								  GLsizei count, GLsizei primcount, const GLfloat * modelviews);
+void VPMT_ExecDrawElementsInstanced(VPMT_Context * context, GLenum mode, GLsizei count,
+									GLenum type, const GLvoid * indices, GLsizei primcount,
+									const GLfloat * modelviews);
+#endif
+
 void VPMT_ExecDeleteLists (VPMT_Context * context, GLuint list, GLsizei range);
 void VPMT_ExecDeleteTextures (VPMT_Context * context, GLsizei n, const GLuint *textures);
 
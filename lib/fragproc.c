@@ -15,6 +15,12 @@
 #include "context.h"
 #include "exec.h"
 #include "frame.h"
+#include "tile.h"
+#include "clear.h"
+
+#if defined(VPMT_SSE2)
+#	include <emmintrin.h>
+#endif
 
 /*
 ** -------------------------------------------------------------------------
@@ -23,13 +29,6 @@
 */
 void VPMT_ExecClear(VPMT_Context * context, GLbitfield mask)
 {
-	GLuint x, y;
-	GLsizei width, height;
-	VPMT_FrameBuffer fb;
-	GLuint clearDepth, clearStencil;
-	VPMT_Color4ub clearColor;
-	GLboolean colorComponents;
-
 	VPMT_NOT_RENDERING(context);
 
 	if (!context->writeSurface) {
@@ -37,70 +36,10 @@ void VPMT_ExecClear(VPMT_Context * context, GLbitfield mask)
 		return;
 	}
 
-	clearDepth = (GLuint) (context->depthFixedPointScale * context->clearDepth);
-	clearStencil = context->clearStencil;
-	clearColor = VPMT_ConvertVec4ToColor4ub(context->clearColor);
-
-	colorComponents =
-		(context->writeSurface->image.pixelFormat->redBits && !context->colorWriteMask[0]) ||
-		(context->writeSurface->image.pixelFormat->greenBits && !context->colorWriteMask[1]) ||
-		(context->writeSurface->image.pixelFormat->blueBits && !context->colorWriteMask[2]) ||
-		(context->writeSurface->image.pixelFormat->alphaBits && !context->colorWriteMask[3]);
+	VPMT_TileFlush(context);
 
 	context->writeSurface->vtbl->lock(context, context->writeSurface);
-	VPMT_FrameBufferInit(&fb, context->writeSurface);
-	VPMT_FrameBufferMove(&fb, context->activeSurfaceRect.origin[0],
-						 context->activeSurfaceRect.origin[1]);
-
-	for (y = context->activeSurfaceRect.origin[1], height =
-		 context->activeSurfaceRect.size.height; height != 0; --height, ++y) {
-
-		VPMT_FrameBufferSave(&fb);
-
-		for (x = context->activeSurfaceRect.origin[0], width =
-			 context->activeSurfaceRect.size.width; width != 0; --width, ++x) {
-
-			if (mask & GL_COLOR_BUFFER_BIT) {
-				if (colorComponents) {
-					VPMT_Color4ub color = VPMT_FrameReadColor(&fb);
-
-					if (context->colorWriteMask[0]) {
-						color.red = clearColor.red;
-					}
-
-					if (context->colorWriteMask[1]) {
-						color.green = clearColor.green;
-					}
-
-					if (context->colorWriteMask[2]) {
-						color.blue = clearColor.blue;
-					}
-
-					if (context->colorWriteMask[3]) {
-						color.alpha = clearColor.alpha;
-					}
-
-					VPMT_FrameWriteColor(&fb, color);
-				} else {
-					VPMT_FrameWriteColor(&fb, clearColor);
-				}
-			}
-
-			if (mask & GL_DEPTH_BUFFER_BIT) {
-				VPMT_FrameWriteDepth(&fb, clearDepth);
-			}
-
-			if (mask & GL_STENCIL_BUFFER_BIT) {
-				VPMT_FrameWriteStencil(&fb, clearStencil);
-			}
-
-			VPMT_FrameBufferStepX(&fb);
-		}
-
-		VPMT_FrameBufferRestore(&fb);
-		VPMT_FrameBufferStepY(&fb);
-	}
-
+	VPMT_ClearBuffers(context, mask);
 	context->writeSurface->vtbl->unlock(context, context->writeSurface);
 }
 
@@ -110,32 +49,17 @@ void VPMT_ExecClear(VPMT_Context * context, GLbitfield mask)
 ** -------------------------------------------------------------------------
 */
 
-static VPMT_INLINE GLubyte UByteLerp(GLubyte first, GLubyte second, GLuint lerp)
-{
-	GLint diff = (GLint) second - (GLint) first;
-	GLint scaledDiff = (diff * (GLint) lerp) >> 8;
-
-	return (GLubyte) ((GLint) first + scaledDiff);
-}
-
-void VPMT_Fragment(VPMT_Context * context, VPMT_FrameBuffer * fb, VPMT_Color4ub newColor,
-				   GLuint depth)
+/*
+** Perform depth and stencil test and update the depth and stencil buffer.
+** Returns GL_FALSE if the fragment has been discarded.
+*/
+GLboolean VPMT_FragmentDepthStencil(VPMT_Context * context, VPMT_FrameBuffer * fb, GLuint depth)
 {
 	GLuint oldDepth, newDepth;
 	GLuint oldStencil, newStencil;
-	VPMT_Color4ub oldColor;
-	GLboolean hasMaskedColor, hasEnabledColor;
 	GLboolean hasEnabledDepthStencil;
 	GLboolean writeColor = GL_TRUE;
 
-	/* alpha test */
-	if (context->alphaTestEnabled && context->alphaFunc == GL_LEQUAL) {
-		if (newColor.alpha > context->alphaRefub) {
-			return;
-		}
-	}
-
-	/* depth & stencil test */
 	hasEnabledDepthStencil =
 		context->depthWriteMask || context->depthTestEnabled || context->stencilTestEnabled;
 
@@ -240,7 +164,7 @@ void VPMT_Fragment(VPMT_Context * context, VPMT_FrameBuffer * fb, VPMT_Color4ub
 				break;
 			}
 		} else if (!depthTest) {
-			return;
+			return GL_FALSE;
 		} else {
 			newStencil = oldStencil;
 			newDepth = depth;
@@ -255,6 +179,17 @@ void VPMT_Fragment(VPMT_Context * context, VPMT_FrameBuffer * fb, VPMT_Color4ub
 		VPMT_FrameWriteStencil(fb, newStencil);
 	}
 
+	return writeColor;
+}
+
+/*
+** Blend the fragment color and write it to the color buffer.
+*/
+void VPMT_FragmentColor(VPMT_Context * context, VPMT_FrameBuffer * fb, VPMT_Color4ub newColor)
+{
+	VPMT_Color4ub oldColor;
+	GLboolean hasMaskedColor, hasEnabledColor;
+
 	/* is there any color component that needs to be written? */
 	hasEnabledColor =
 		(context->redBits && context->colorWriteMask[0]) ||
@@ -262,7 +197,7 @@ void VPMT_Fragment(VPMT_Context * context, VPMT_FrameBuffer * fb, VPMT_Color4ub
 		(context->blueBits && context->colorWriteMask[2]) ||
 		(context->alphaBits && context->colorWriteMask[3]);
 
-	if (!hasEnabledColor || !writeColor) {
+	if (!hasEnabledColor) {
 		return;
 	}
 
@@ -284,10 +219,10 @@ void VPMT_Fragment(VPMT_Context * context, VPMT_FrameBuffer * fb, VPMT_Color4ub
 				&& context->blendDstFactor == GL_ONE_MINUS_SRC_ALPHA) {
 				GLuint alpha256 = VPMT_Color255To256(newColor.alpha);
 
-				newColor.red = UByteLerp(oldColor.red, newColor.red, alpha256);
-				newColor.green = UByteLerp(oldColor.green, newColor.green, alpha256);
-				newColor.blue = UByteLerp(oldColor.blue, newColor.blue, alpha256);
-				newColor.alpha = UByteLerp(oldColor.alpha, newColor.alpha, alpha256);
+				newColor.red = VPMT_UByteLerp(oldColor.red, newColor.red, alpha256);
+				newColor.green = VPMT_UByteLerp(oldColor.green, newColor.green, alpha256);
+				newColor.blue = VPMT_UByteLerp(oldColor.blue, newColor.blue, alpha256);
+				newColor.alpha = VPMT_UByteLerp(oldColor.alpha, newColor.alpha, alpha256);
 
 			} else if (context->blendSrcFactor == GL_SRC_ALPHA_SATURATE
 					   && context->blendDstFactor == GL_ONE) {
@@ -314,4 +249,742 @@ void VPMT_Fragment(VPMT_Context * context, VPMT_FrameBuffer * fb, VPMT_Color4ub
 	VPMT_FrameWriteColor(fb, newColor);
 }
 
+void VPMT_Fragment(VPMT_Context * context, VPMT_FrameBuffer * fb, VPMT_Color4ub newColor,
+				   GLuint depth)
+{
+	/* alpha test */
+	if (context->alphaTestEnabled && context->alphaFunc == GL_LEQUAL) {
+		if (newColor.alpha > context->alphaRefub) {
+			return;
+		}
+	}
+
+	if (VPMT_FragmentDepthStencil(context, fb, depth)) {
+		VPMT_FragmentColor(context, fb, newColor);
+	}
+}
+
+/*
+** -------------------------------------------------------------------------
+** Generate a span of fragments
+**
+** A span covers up to VPMT_FRAGMENT_SPAN_SIZE pixels in positive x starting
+** at the current framebuffer position; bit i of the coverage mask selects
+** pixel i. Each stage processes the whole span before the next one starts.
+** The SIMD code processes groups of 4 pixels and may therefore access
+** array elements past count.
+** -------------------------------------------------------------------------
+*/
+
+static VPMT_INLINE GLuint SpanMask(GLsizei count)
+{
+	return count >= 32 ? ~0u : (1u << count) - 1u;
+}
+
+#if defined(VPMT_SSE2)
+
+/*
+** Expand bits index .. index + 3 of mask into a lane mask.
+*/
+static VPMT_INLINE __m128i LaneMask(GLuint mask, GLsizei index)
+{
+	__m128i bits = _mm_set_epi32(8, 4, 2, 1);
+
+	return _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(mask >> index), bits), bits);
+}
+
+static VPMT_INLINE GLuint MoveMask(__m128i value)
+{
+	return (GLuint) _mm_movemask_ps(_mm_castsi128_ps(value));
+}
+
+#endif
+
+/*
+** Read the depth and stencil values of count pixels that are adjacent in
+** memory, starting at base.
+*/
+static void ReadDepthStencilRun(const VPMT_FrameBuffer * fb, const GLubyte * base,
+								GLsizei count, GLuint depth[], GLuint stencil[])
+{
+	GLsizei index;
+
+	switch (fb->depthStencilType) {
+	case VPMT_DEPTH_16:
+		{
+			const GLushort *ptr = (const GLushort *) base;
+
+			for (index = 0; index < count; ++index) {
+				depth[index] = ptr[index];
+				stencil[index] = 0;
+			}
+		}
+
+		break;
+
+	case VPMT_DEPTH_24_STENCIL_8:
+		{
+			const GLuint *ptr = (const GLuint *) base;
+
+			for (index = 0; index < count; ++index) {
+				depth[index] = ptr[index] >> 8;
+				stencil[index] = ptr[index] & 0xffu;
+			}
+		}
+
+		break;
+
+	case VPMT_DEPTH_32:
+		{
+			const GLuint *ptr = (const GLuint *) base;
+
+			for (index = 0; index < count; ++index) {
+				depth[index] = ptr[index];
+				stencil[index] = 0;
+			}
+		}
+
+		break;
+
+	default:
+		assert(GL_FALSE);
+	}
+}
+
+/*
+** Write back the depth values selected by depthMask and the stencil values
+** selected by stencilMask to count pixels that are adjacent in memory,
+** starting at base.
+*/
+static void WriteDepthStencilRun(const VPMT_FrameBuffer * fb, GLubyte * base, GLsizei count,
+								 const GLuint depth[], GLuint depthMask,
+								 const GLuint stencil[], GLuint stencilMask)
+{
+	GLsizei index;
+
+	switch (fb->depthStencilType) {
+	case VPMT_DEPTH_16:
+		{
+			GLushort *ptr = (GLushort *) base;
+
+			for (index = 0; index < count; ++index) {
+				if (depthMask & (1u << index)) {
+					ptr[index] = depth[index];
+				}
+			}
+		}
+
+		break;
+
+	case VPMT_DEPTH_24_STENCIL_8:
+		{
+			GLuint *ptr = (GLuint *) base;
+
+			for (index = 0; index < count; ++index) {
+				if (depthMask & (1u << index)) {
+					ptr[index] = (ptr[index] & 0xffu) | (depth[index] << 8);
+				}
+
+				if (stencilMask & (1u << index)) {
+					ptr[index] = (ptr[index] & 0xffffff00u) | stencil[index];
+				}
+			}
+		}
+
+		break;
+
+	case VPMT_DEPTH_32:
+		{
+			GLuint *ptr = (GLuint *) base;
+
+			for (index = 0; index < count; ++index) {
+				if (depthMask & (1u << index)) {
+					ptr[index] = depth[index];
+				}
+			}
+		}
+
+		break;
+
+	default:
+		assert(GL_FALSE);
+	}
+}
+
+static void ReadDepthStencilSpan(const VPMT_Context * context, const VPMT_FrameBuffer * fb,
+								 GLsizei count, GLuint depth[], GLuint stencil[])
+{
+	GLsizei start, run;
+
+	for (start = 0; start < count; start += run) {
+		const GLubyte *base = VPMT_FrameBufferAddress(fb, VPMT_FRAME_DEPTH_STENCIL_BUFFER, start);
+
+		run = VPMT_FrameBufferRun(fb, start, count);
+		ReadDepthStencilRun(fb, base, run, depth + start, stencil + start);
+	}
+}
+
+static void WriteDepthStencilSpan(const VPMT_Context * context, const VPMT_FrameBuffer * fb,
+								  GLsizei count, const GLuint depth[], GLuint depthMask,
+								  const GLuint stencil[], GLuint stencilMask)
+{
+	GLsizei start, run;
+
+	for (start = 0; start < count; start += run) {
+		GLubyte *base = VPMT_FrameBufferAddress(fb, VPMT_FRAME_DEPTH_STENCIL_BUFFER, start);
+
+		run = VPMT_FrameBufferRun(fb, start, count);
+		WriteDepthStencilRun(fb, base, run, depth + start, depthMask >> start, stencil + start,
+							 stencilMask >> start);
+	}
+}
+
+static GLuint DepthTestSpan(GLenum func, GLsizei count, const GLuint depth[],
+							const GLuint oldDepth[])
+{
+	GLuint result = 0;
+	GLsizei index;
+
+	if (func == GL_ALWAYS) {
+		return SpanMask(count);
+	}
+
+	assert(func == GL_LESS || func == GL_LEQUAL);
+
+#if defined(VPMT_SSE2)
+	{
+		/* bias the values to use the signed comparison */
+		__m128i bias = _mm_set1_epi32(0x80000000);
+
+		for (index = 0; index < count; index += 4) {
+			__m128i newValue =
+				_mm_xor_si128(_mm_loadu_si128((const __m128i *) (depth + index)), bias);
+			__m128i oldValue =
+				_mm_xor_si128(_mm_loadu_si128((const __m128i *) (oldDepth + index)), bias);
+
+			if (func == GL_LESS) {
+				result |= MoveMask(_mm_cmplt_epi32(newValue, oldValue)) << index;
+			} else {
+				result |= (~MoveMask(_mm_cmpgt_epi32(newValue, oldValue)) & 0xfu) << index;
+			}
+		}
+	}
+#else
+	for (index = 0; index < count; ++index) {
+		GLboolean pass = func == GL_LESS ?
+			depth[index] < oldDepth[index] : depth[index] <= oldDepth[index];
+
+		result |= (GLuint) pass << index;
+	}
+#endif
+
+	return result & SpanMask(count);
+}
+
+static GLuint StencilTestSpan(const VPMT_Context * context, GLsizei count,
+							  const GLuint stencil[], GLuint stencilBufferMask)
+{
+	GLuint valueMask = stencilBufferMask & context->stencilMask;
+	GLuint maskedRef = valueMask & context->stencilRef;
+	GLuint result = 0;
+	GLsizei index;
+
+	switch (context->stencilFunc) {
+	case GL_NEVER:
+		return 0;
+
+	case GL_ALWAYS:
+		return SpanMask(count);
+
+	default:
+		break;
+	}
+
+#if defined(VPMT_SSE2)
+	{
+		__m128i ref = _mm_set1_epi32(maskedRef);
+		__m128i mask = _mm_set1_epi32(valueMask);
+
+		for (index = 0; index < count; index += 4) {
+			__m128i value =
+				_mm_and_si128(_mm_loadu_si128((const __m128i *) (stencil + index)), mask);
+			GLuint bits;
+
+			switch (context->stencilFunc) {
+			case GL_LESS:
+				bits = MoveMask(_mm_cmplt_epi32(ref, value));
+				break;
+			case GL_LEQUAL:
+				bits = ~MoveMask(_mm_cmpgt_epi32(ref, value));
+				break;
+			case GL_GREATER:
+				bits = MoveMask(_mm_cmpgt_epi32(ref, value));
+				break;
+			case GL_GEQUAL:
+				bits = ~MoveMask(_mm_cmplt_epi32(ref, value));
+				break;
+			case GL_EQUAL:
+				bits = MoveMask(_mm_cmpeq_epi32(ref, value));
+				break;
+			case GL_NOTEQUAL:
+				bits = ~MoveMask(_mm_cmpeq_epi32(ref, value));
+				break;
+			default:
+				assert(GL_FALSE);
+				bits = 0;
+				break;
+			}
+
+			result |= (bits & 0xfu) << index;
+		}
+	}
+#else
+	for (index = 0; index < count; ++index) {
+		GLuint maskedValue = valueMask & stencil[index];
+		GLboolean pass;
+
+		switch (context->stencilFunc) {
+		case GL_LESS:
+			pass = maskedRef < maskedValue;
+			break;
+		case GL_LEQUAL:
+			pass = maskedRef <= maskedValue;
+			break;
+		case GL_GREATER:
+			pass = maskedRef > maskedValue;
+			break;
+		case GL_GEQUAL:
+			pass = maskedRef >= maskedValue;
+			break;
+		case GL_EQUAL:
+			pass = maskedRef == maskedValue;
+			break;
+		case GL_NOTEQUAL:
+			pass = maskedRef != maskedValue;
+			break;
+		default:
+			assert(GL_FALSE);
+			pass = GL_FALSE;
+			break;
+		}
+
+		result |= (GLuint) pass << index;
+	}
+#endif
+
+	return result & SpanMask(count);
+}
+
+/*
+** Apply the stencil operation op to the pixels selected by mask.
+*/
+static void StencilOpSpan(GLenum op, GLsizei count, const GLuint oldStencil[],
+						  GLuint newStencil[], GLuint mask, GLuint ref, GLuint stencilBufferMask)
+{
+	GLsizei index;
+
+	if (!mask || op == GL_KEEP) {
+		return;
+	}
+
+#if defined(VPMT_SSE2)
+	{
+		__m128i bufferMask = _mm_set1_epi32(stencilBufferMask);
+
+		for (index = 0; index < count; index += 4) {
+			__m128i lanes = LaneMask(mask, index);
+			__m128i value = _mm_loadu_si128((const __m128i *) (oldStencil + index));
+			__m128i result;
+
+			switch (op) {
+			case GL_ZERO:
+				result = _mm_setzero_si128();
+				break;
+			case GL_REPLACE:
+				result = _mm_set1_epi32(ref);
+				break;
+			case GL_INCR:
+				/* comparison results are -1 for true */
+				result = _mm_sub_epi32(value, _mm_cmplt_epi32(value, bufferMask));
+				break;
+			case GL_DECR:
+				result = _mm_add_epi32(value, _mm_cmpgt_epi32(value, _mm_setzero_si128()));
+				break;
+			case GL_INVERT:
+				result = _mm_andnot_si128(value, bufferMask);
+				break;
+			default:
+				assert(GL_FALSE);
+				result = value;
+				break;
+			}
+
+			result =
+				_mm_or_si128(_mm_and_si128(lanes, result),
+							 _mm_andnot_si128(lanes,
+											  _mm_loadu_si128((const __m128i *)
+															  (newStencil + index))));
+			_mm_storeu_si128((__m128i *) (newStencil + index), result);
+		}
+	}
+#else
+	for (index = 0; index < count; ++index) {
+		GLuint value = oldStencil[index];
+
+		if (!(mask & (1u << index))) {
+			continue;
+		}
+
+		switch (op) {
+		case GL_ZERO:
+			newStencil[index] = 0;
+			break;
+		case GL_REPLACE:
+			newStencil[index] = ref;
+			break;
+		case GL_INCR:
+			newStencil[index] = (value < stencilBufferMask) ? value + 1 : value;
+			break;
+		case GL_DECR:
+			newStencil[index] = (value > 0) ? value - 1 : 0;
+			break;
+		case GL_INVERT:
+			newStencil[index] = ~value & stencilBufferMask;
+			break;
+		default:
+			assert(GL_FALSE);
+			break;
+		}
+	}
+#endif
+}
+
+/*
+** Combine new and old stencil values based on the stencil write mask.
+*/
+static void StencilWriteMaskSpan(GLsizei count, const GLuint oldStencil[], GLuint newStencil[],
+								 GLuint writeMask, GLuint stencilBufferMask)
+{
+	GLsizei index;
+
+#if defined(VPMT_SSE2)
+	__m128i mask = _mm_set1_epi32(writeMask);
+	__m128i bufferMask = _mm_set1_epi32(stencilBufferMask);
+
+	for (index = 0; index < count; index += 4) {
+		__m128i oldValue = _mm_loadu_si128((const __m128i *) (oldStencil + index));
+		__m128i newValue = _mm_loadu_si128((const __m128i *) (newStencil + index));
+
+		newValue =
+			_mm_and_si128(_mm_or_si128(_mm_and_si128(mask, newValue),
+									   _mm_andnot_si128(mask, oldValue)), bufferMask);
+		_mm_storeu_si128((__m128i *) (newStencil + index), newValue);
+	}
+#else
+	for (index = 0; index < count; ++index) {
+		newStencil[index] =
+			((writeMask & newStencil[index]) | (~writeMask & oldStencil[index])) &
+			stencilBufferMask;
+	}
+#endif
+}
+
+/*
+** Perform depth and stencil test for a span and update the depth and
+** stencil buffer. Returns the mask of fragments that passed.
+*/
+GLuint VPMT_FragmentSpanDepthStencil(VPMT_Context * context, VPMT_FrameBuffer * fb,
+									 GLsizei count, const GLuint depths[], GLuint mask)
+{
+	GLuint oldDepth[VPMT_FRAGMENT_SPAN_SIZE];
+	GLuint oldStencil[VPMT_FRAGMENT_SPAN_SIZE], newStencil[VPMT_FRAGMENT_SPAN_SIZE];
+	GLuint depthPass, passMask, stencilMask = 0;
+	GLsizei index;
+
+	assert(count <= VPMT_FRAGMENT_SPAN_SIZE);
+
+	mask &= SpanMask(count);
+
+	if (!mask ||
+		!(context->depthWriteMask || context->depthTestEnabled || context->stencilTestEnabled)) {
+		return mask;
+	}
+
+	ReadDepthStencilSpan(context, fb, count, oldDepth, oldStencil);
+
+	if (context->depthTestEnabled) {
+		depthPass = DepthTestSpan(context->depthFunc, count, depths, oldDepth);
+	} else {
+		depthPass = SpanMask(count);
+	}
+
+	if (context->stencilTestEnabled) {
+		GLuint stencilBufferMask = (1 << context->stencilBits) - 1;
+		GLuint stencilPass = StencilTestSpan(context, count, oldStencil, stencilBufferMask);
+
+		for (index = 0; index < count; ++index) {
+			newStencil[index] = oldStencil[index];
+		}
+
+		StencilOpSpan(context->stencilOpFail, count, oldStencil, newStencil,
+					  mask & ~stencilPass, context->stencilRef, stencilBufferMask);
+		StencilOpSpan(context->stencilOpZFail, count, oldStencil, newStencil,
+					  mask & stencilPass & ~depthPass, context->stencilRef, stencilBufferMask);
+		StencilOpSpan(context->stencilOpZPass, count, oldStencil, newStencil,
+					  mask & stencilPass & depthPass, context->stencilRef, stencilBufferMask);
+		StencilWriteMaskSpan(count, oldStencil, newStencil, context->stencilWriteMask,
+							 stencilBufferMask);
+
+		passMask = mask & stencilPass & depthPass;
+		stencilMask = mask;
+	} else {
+		passMask = mask & depthPass;
+	}
+
+	WriteDepthStencilSpan(context, fb, count, depths, context->depthWriteMask ? passMask : 0,
+						  newStencil, stencilMask);
+
+	return passMask;
+}
+
+/*
+** Blend kernels operating on the colors of a span. The SIMD versions process
+** 4 pixels per iteration on 16 bit lanes.
+*/
+
+/*
+** new = old + (new - old) * alpha256 / 256, evaluated as
+** (old * (256 - alpha256) + new * alpha256) / 256 to stay within 16 bits.
+*/
+static void BlendSrcAlphaSpan(GLsizei count, const VPMT_Color4ub oldColors[],
+							  VPMT_Color4ub newColors[])
+{
+	GLsizei index;
+
+#if defined(VPMT_SSE2)
+	__m128i zero = _mm_setzero_si128();
+	__m128i one256 = _mm_set1_epi16(256);
+
+	for (index = 0; index < count; index += 4) {
+		__m128i oldValue = _mm_loadu_si128((const __m128i *) (oldColors + index));
+		__m128i newValue = _mm_loadu_si128((const __m128i *) (newColors + index));
+		__m128i result[2];
+		GLsizei half;
+
+		for (half = 0; half < 2; ++half) {
+			__m128i oldLanes = half ? _mm_unpackhi_epi8(oldValue, zero) :
+				_mm_unpacklo_epi8(oldValue, zero);
+			__m128i newLanes = half ? _mm_unpackhi_epi8(newValue, zero) :
+				_mm_unpacklo_epi8(newValue, zero);
+			__m128i alpha =
+				_mm_shufflehi_epi16(_mm_shufflelo_epi16(newLanes, 0xff), 0xff);
+
+			alpha = _mm_add_epi16(alpha, _mm_srli_epi16(alpha, 7));
+			result[half] =
+				_mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(oldLanes,
+															 _mm_sub_epi16(one256, alpha)),
+											 _mm_mullo_epi16(newLanes, alpha)), 8);
+		}
+
+		_mm_storeu_si128((__m128i *) (newColors + index), _mm_packus_epi16(result[0], result[1]));
+	}
+#else
+	for (index = 0; index < count; ++index) {
+		VPMT_Color4ub oldColor = oldColors[index], *newColor = newColors + index;
+		GLuint alpha256 = VPMT_Color255To256(newColor->alpha);
+
+		newColor->red = VPMT_UByteLerp(oldColor.red, newColor->red, alpha256);
+		newColor->green = VPMT_UByteLerp(oldColor.green, newColor->green, alpha256);
+		newColor->blue = VPMT_UByteLerp(oldColor.blue, newColor->blue, alpha256);
+		newColor->alpha = VPMT_UByteLerp(oldColor.alpha, newColor->alpha, alpha256);
+	}
+#endif
+}
+
+/*
+** f = min(new.alpha, 1 - old.alpha); new.rgb = min(1, old.rgb + new.rgb * f),
+** new.alpha = old.alpha + f
+*/
+static void BlendSaturateSpan(GLsizei count, const VPMT_Color4ub oldColors[],
+							  VPMT_Color4ub newColors[])
+{
+	GLsizei index;
+
+#if defined(VPMT_SSE2)
+	__m128i zero = _mm_setzero_si128();
+	__m128i max = _mm_set1_epi16(0xff);
+	__m128i round = _mm_set1_epi16(0x80);
+	__m128i alphaLanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+
+	for (index = 0; index < count; index += 4) {
+		__m128i oldValue = _mm_loadu_si128((const __m128i *) (oldColors + index));
+		__m128i newValue = _mm_loadu_si128((const __m128i *) (newColors + index));
+		__m128i result[2];
+		GLsizei half;
+
+		for (half = 0; half < 2; ++half) {
+			__m128i oldLanes = half ? _mm_unpackhi_epi8(oldValue, zero) :
+				_mm_unpacklo_epi8(oldValue, zero);
+			__m128i newLanes = half ? _mm_unpackhi_epi8(newValue, zero) :
+				_mm_unpacklo_epi8(newValue, zero);
+			__m128i factor = _mm_min_epi16(newLanes, _mm_sub_epi16(max, oldLanes));
+			__m128i factor256, product;
+
+			factor = _mm_shufflehi_epi16(_mm_shufflelo_epi16(factor, 0xff), 0xff);
+			factor256 = _mm_add_epi16(factor, _mm_srli_epi16(factor, 7));
+			product =
+				_mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(newLanes, factor256), round), 8);
+			product =
+				_mm_or_si128(_mm_andnot_si128(alphaLanes, product),
+							 _mm_and_si128(alphaLanes, factor));
+
+			/* the final pack saturates the color channels */
+			result[half] = _mm_add_epi16(oldLanes, product);
+		}
+
+		_mm_storeu_si128((__m128i *) (newColors + index), _mm_packus_epi16(result[0], result[1]));
+	}
+#else
+	for (index = 0; index < count; ++index) {
+		VPMT_Color4ub oldColor = oldColors[index], *newColor = newColors + index;
+		GLubyte alpha = VPMT_MIN(newColor->alpha, 0xffu - oldColor.alpha);
+		GLuint alpha256 = VPMT_Color255To256(alpha);
+
+		newColor->red = (GLubyte) VPMT_MIN(VPMT_UBYTE_MAX, (GLushort) oldColor.red + VPMT_UByteMul256(newColor->red, alpha256));
+		newColor->green = (GLubyte) VPMT_MIN(VPMT_UBYTE_MAX, (GLushort) oldColor.green + VPMT_UByteMul256(newColor->green, alpha256));
+		newColor->blue = (GLubyte) VPMT_MIN(VPMT_UBYTE_MAX, (GLushort) oldColor.blue + VPMT_UByteMul256(newColor->blue, alpha256));
+		newColor->alpha = oldColor.alpha + alpha;			   /* this is clamped at 0..1 */
+	}
+#endif
+}
+
+/*
+** Combine new and old colors based on the color write mask.
+*/
+static void ColorWriteMaskSpan(const VPMT_Context * context, GLsizei count,
+							   const VPMT_Color4ub oldColors[], VPMT_Color4ub newColors[])
+{
+	GLsizei index;
+
+#if defined(VPMT_SSE2)
+	VPMT_Color4ub writeMask[4];
+	__m128i writeMask4;
+
+	for (index = 0; index < 4; ++index) {
+		writeMask[index].red = context->colorWriteMask[0] ? 0xffu : 0;
+		writeMask[index].green = context->colorWriteMask[1] ? 0xffu : 0;
+		writeMask[index].blue = context->colorWriteMask[2] ? 0xffu : 0;
+		writeMask[index].alpha = context->colorWriteMask[3] ? 0xffu : 0;
+	}
+
+	writeMask4 = _mm_loadu_si128((const __m128i *) writeMask);
+
+	for (index = 0; index < count; index += 4) {
+		__m128i newValue = _mm_loadu_si128((const __m128i *) (newColors + index));
+		__m128i oldValue = _mm_loadu_si128((const __m128i *) (oldColors + index));
+
+		newValue =
+			_mm_or_si128(_mm_and_si128(writeMask4, newValue),
+						 _mm_andnot_si128(writeMask4, oldValue));
+		_mm_storeu_si128((__m128i *) (newColors + index), newValue);
+	}
+#else
+	for (index = 0; index < count; ++index) {
+		VPMT_Color4ub *newColor = newColors + index, oldColor = oldColors[index];
+
+		newColor->red =
+			VPMT_SELECT(context->colorWriteMask[0], newColor->red, oldColor.red);
+		newColor->green =
+			VPMT_SELECT(context->colorWriteMask[1], newColor->green, oldColor.green);
+		newColor->blue =
+			VPMT_SELECT(context->colorWriteMask[2], newColor->blue, oldColor.blue);
+		newColor->alpha =
+			VPMT_SELECT(context->colorWriteMask[3], newColor->alpha, oldColor.alpha);
+	}
+#endif
+}
+
+/*
+** Blend the fragment colors of a span and write them to the color buffer.
+*/
+void VPMT_FragmentSpanColor(VPMT_Context * context, VPMT_FrameBuffer * fb, GLsizei count,
+							const VPMT_Color4ub colors[], GLuint mask)
+{
+	VPMT_Color4ub oldColors[VPMT_FRAGMENT_SPAN_SIZE], newColors[VPMT_FRAGMENT_SPAN_SIZE];
+	GLboolean hasMaskedColor, hasEnabledColor;
+	GLsizei index;
+
+	assert(count <= VPMT_FRAGMENT_SPAN_SIZE);
+
+	/* is there any color component that needs to be written? */
+	hasEnabledColor =
+		(context->redBits && context->colorWriteMask[0]) ||
+		(context->greenBits && context->colorWriteMask[1]) ||
+		(context->blueBits && context->colorWriteMask[2]) ||
+		(context->alphaBits && context->colorWriteMask[3]);
+
+	mask &= SpanMask(count);
+
+	if (!hasEnabledColor || !mask) {
+		return;
+	}
+
+	/* is there any color component that needs to be preserved? */
+	hasMaskedColor =
+		(context->redBits && !context->colorWriteMask[0]) ||
+		(context->greenBits && !context->colorWriteMask[1]) ||
+		(context->blueBits && !context->colorWriteMask[2]) ||
+		(context->alphaBits && !context->colorWriteMask[3]);
+
+	if ((context->blendEnabled && context->blendSrcFactor != GL_ONE) || hasMaskedColor) {
+		VPMT_FrameReadColorSpan(fb, count, oldColors, mask);
+
+		for (index = 0; index < count; ++index) {
+			newColors[index] = colors[index];
+		}
+
+		/* perform blend */
+		if (context->blendEnabled) {
+			/* OpenGL SC only provides the following two blend modes */
+			if (context->blendSrcFactor == GL_SRC_ALPHA
+				&& context->blendDstFactor == GL_ONE_MINUS_SRC_ALPHA) {
+				BlendSrcAlphaSpan(count, oldColors, newColors);
+			} else if (context->blendSrcFactor == GL_SRC_ALPHA_SATURATE
+					   && context->blendDstFactor == GL_ONE) {
+				BlendSaturateSpan(count, oldColors, newColors);
+			} else {
+				assert(context->blendSrcFactor == GL_ONE && context->blendDstFactor == GL_ZERO);
+			}
+		}
+
+		/* multiplex color components based on colorWriteMask */
+		if (hasMaskedColor) {
+			ColorWriteMaskSpan(context, count, oldColors, newColors);
+		}
+
+		colors = newColors;
+	}
+
+	/* write to framebuffer */
+	VPMT_FrameWriteColorSpan(fb, count, colors, mask);
+}
+
+void VPMT_FragmentSpan(VPMT_Context * context, VPMT_FrameBuffer * fb, GLsizei count,
+					   const VPMT_Color4ub colors[], const GLuint depths[], GLuint mask)
+{
+	GLsizei index;
+
+	/* alpha test */
+	if (context->alphaTestEnabled && context->alphaFunc == GL_LEQUAL) {
+		for (index = 0; index < count; ++index) {
+			if (colors[index].alpha > context->alphaRefub) {
+				mask &= ~(1u << index);
+			}
+		}
+	}
+
+	mask = VPMT_FragmentSpanDepthStencil(context, fb, count, depths, mask);
+	VPMT_FragmentSpanColor(context, fb, count, colors, mask);
+}
+
 /* $Id: fragproc.c 74 2008-11-23 07:25:12Z hmwill $ */
@@ -15,110 +15,59 @@
 #include "context.h"
 #include "frame.h"
 
+#if defined(VPMT_SSE2)
+#	include <emmintrin.h>
+#endif
+
 
 static VPMT_Color4ub ReadColor565(const VPMT_FrameBuffer * fb)
 {
-	const GLushort *ptr = (const GLushort *) fb->current[0];
-	VPMT_Color4ub result;
-
-	result.red = (*ptr & 0xF800) >> 8 | (*ptr & 0xF800) >> 13;
-	result.green = (*ptr & 0x07E0) >> 3 | (*ptr & 0x07E0) >> 9;
-	result.blue = (*ptr & 0x001F) << 3 | (*ptr & 0x001F) >> 2;
-	result.alpha = 0xffu;
-
-	return result;
+	return VPMT_FrameUnpackColor565(*(const GLushort *) fb->current[0]);
 }
 
 static void WriteColor565(const VPMT_FrameBuffer * fb, VPMT_Color4ub color)
 {
-	GLushort *ptr = (GLushort *) fb->current[0];
-
-	*ptr =
-		((color.red << 8) & 0xF800) | ((color.green << 3) & 0x07E0) | ((color.blue >> 3) & 0x001F);
+	*(GLushort *) fb->current[0] = VPMT_FramePackColor565(color);
 }
 
 static VPMT_Color4ub ReadColor5551(const VPMT_FrameBuffer * fb)
 {
-	const GLushort *ptr = (const GLushort *) fb->current[0];
-	VPMT_Color4ub result;
-
-	result.red = (*ptr & 0xF800) >> 8 | (*ptr & 0xF800) >> 13;
-	result.green = (*ptr & 0x07C0) >> 3 | (*ptr & 0x07C0) >> 8;
-	result.blue = (*ptr & 0x003E) << 2 | (*ptr & 0x003E) >> 3;
-	result.alpha = (*ptr & 1) ? 0xffu : 0u;
-
-	return result;
+	return VPMT_FrameUnpackColor5551(*(const GLushort *) fb->current[0]);
 }
 
 static void WriteColor5551(const VPMT_FrameBuffer * fb, VPMT_Color4ub color)
 {
-	GLushort *ptr = (GLushort *) fb->current[0];
-
-	*ptr =
-		((color.red << 8) & 0xF800) |
-		((color.green << 3) & 0x07C0) | ((color.blue >> 2) & 0x003E) | ((color.alpha >> 7) & 1);
+	*(GLushort *) fb->current[0] = VPMT_FramePackColor5551(color);
 }
 
 static VPMT_Color4ub ReadColor4444(const VPMT_FrameBuffer * fb)
 {
-	const GLushort *ptr = (const GLushort *) fb->current[0];
-	VPMT_Color4ub result;
-
-	result.red = (*ptr & 0xF000) >> 8 | (*ptr & 0xF000) >> 12;
-	result.green = (*ptr & 0x0F00) >> 4 | (*ptr & 0x0F00) >> 8;
-	result.blue = (*ptr & 0x00F0) | (*ptr & 0x00F0) >> 4;
-	result.alpha = (*ptr & 0x000F) << 4 | (*ptr & 0x000F);
-
-	return result;
+	return VPMT_FrameUnpackColor4444(*(const GLushort *) fb->current[0]);
 }
 
 static void WriteColor4444(const VPMT_FrameBuffer * fb, VPMT_Color4ub color)
 {
-	GLushort *ptr = (GLushort *) fb->current[0];
-
-	*ptr =
-		((color.red << 8) & 0xF000) |
-		((color.green << 4) & 0x0F00) | ((color.blue) & 0x00F0) | ((color.alpha >> 4) & 0x000F);
+	*(GLushort *) fb->current[0] = VPMT_FramePackColor4444(color);
 }
 
 static VPMT_Color4ub ReadColor8888(const VPMT_FrameBuffer * fb)
 {
-	const GLuint *ptr = (const GLuint *) fb->current[0];
-	VPMT_Color4ub result;
-
-	result.red = (*ptr & 0xFF000000) >> 24;
-	result.green = (*ptr & 0x00FF0000) >> 16;
-	result.blue = (*ptr & 0x0000FF00) >> 8;
-	result.alpha = (*ptr & 0x000000FF);
-
-	return result;
+	return VPMT_FrameUnpackColor8888(*(const GLuint *) fb->current[0]);
 }
 
 static void WriteColor8888(const VPMT_FrameBuffer * fb, VPMT_Color4ub color)
 {
-	GLuint *ptr = (GLuint *) fb->current[0];
-
-	*ptr = color.red << 24 | color.green << 16 | color.blue << 8 | color.alpha;
+	*(GLuint *) fb->current[0] = VPMT_FramePackColor8888(color);
 }
 
 static VPMT_Color4ub ReadColor8888_REV(const VPMT_FrameBuffer * fb)
 {
-	const GLuint *ptr = (const GLuint *) fb->current[0];
-	VPMT_Color4ub result;
-
-	result.red = (*ptr & 0x000000FF);
-	result.green = (*ptr & 0x0000FF00) >> 8;
-	result.blue = (*ptr & 0x00FF0000) >> 16;
-	result.alpha = (*ptr & 0xFF000000) >> 24;
-
-	return result;
+	return VPMT_FrameUnpackColor8888_REV(*(const GLuint *) fb->current[0]);
 }
 
 static void WriteColor8888_REV(const VPMT_FrameBuffer * fb, VPMT_Color4ub color)
 {
-	GLuint *ptr = (GLuint *) fb->current[0];
-
-	*ptr = color.alpha << 24 | color.blue << 16 | color.green << 8 | color.red;
+	*(GLuint *) fb->current[0] = VPMT_FramePackColor8888_REV(color);
 }
 
 static GLuint ReadDepth16(const VPMT_FrameBuffer * fb)
@@ -192,6 +141,30 @@ void VPMT_FrameBufferInit(VPMT_FrameBuffer * fb, VPMT_Surface * surface)
 {
 	const VPMT_PixelFormat *pixelFormat = surface->image.pixelFormat;
 
+#if VPMT_TILED_SURFACE
+	GLsizei tiles =
+		(surface->image.size.width + VPMT_SURFACE_TILE_MASK) >> VPMT_SURFACE_TILE_BITS;
+	GLsizei index;
+
+	/* this code assumes 2 buffers; RGBA and depth/stencil */
+	fb->base[0] = ((GLubyte *) surface->colorBuffer);
+	fb->dx[0] = surface->image.pixelFormat->size;
+
+	fb->base[1] = ((GLubyte *) surface->depthStencilBuffer);
+	fb->dx[1] = surface->depthStencilFormat->bits / 8;
+
+	for (index = 0; index < VPMT_MAX_RENDER_BUFFERS; ++index) {
+		fb->current[index] = fb->base[index];
+		fb->dy[index] = fb->dx[index] << VPMT_SURFACE_TILE_BITS;
+		fb->tilePitch[index] = (tiles * fb->dx[index]) << (2 * VPMT_SURFACE_TILE_BITS);
+		fb->tileDx[index] =
+			fb->dx[index] * (VPMT_SURFACE_TILE_SIZE * VPMT_SURFACE_TILE_SIZE -
+							 VPMT_SURFACE_TILE_MASK);
+		fb->tileDy[index] = fb->tilePitch[index] - fb->dy[index] * VPMT_SURFACE_TILE_MASK;
+	}
+
+	fb->x = fb->y = 0;
+#else
 	/* this code assumes 2 buffers; RGBA and depth/stencil */
 	fb->current[0] = ((GLubyte *) surface->image.data);
 	fb->dx[0] = surface->image.pixelFormat->size;
@@ -200,6 +173,7 @@ void VPMT_FrameBufferInit(VPMT_FrameBuffer * fb, VPMT_Surface * surface)
 	fb->current[1] = ((GLubyte *) surface->depthStencilBuffer);
 	fb->dx[1] = surface->depthStencilFormat->bits / 8;
 	fb->dy[1] = surface->depthStencilFormat->bits / 8 * surface->image.size.width;
+#endif
 
 	switch (pixelFormat->baseFormat) {
 	case GL_RGB:
@@ -207,6 +181,7 @@ void VPMT_FrameBufferInit(VPMT_FrameBuffer * fb, VPMT_Surface * surface)
 		case GL_UNSIGNED_SHORT_5_6_5:
 			fb->readColor = ReadColor565;
 			fb->writeColor = WriteColor565;
+			fb->colorFormat = VPMT_FRAME_COLOR_565;
 			break;
 
 		default:
@@ -222,11 +197,13 @@ void VPMT_FrameBufferInit(VPMT_FrameBuffer * fb, VPMT_Surface * surface)
 		case GL_UNSIGNED_SHORT_4_4_4_4:
 			fb->readColor = ReadColor4444;
 			fb->writeColor = WriteColor4444;
+			fb->colorFormat = VPMT_FRAME_COLOR_4444;
 			break;
 
 		case GL_UNSIGNED_SHORT_5_5_5_1:
 			fb->readColor = ReadColor5551;
 			fb->writeColor = WriteColor5551;
+			fb->colorFormat = VPMT_FRAME_COLOR_5551;
 			break;
 
 #if (!VPMT_LITTLE_ENDIAN)
@@ -235,6 +212,7 @@ void VPMT_FrameBufferInit(VPMT_FrameBuffer * fb, VPMT_Surface * surface)
 		case GL_UNSIGNED_INT_8_8_8_8:
 			fb->readColor = ReadColor8888;
 			fb->writeColor = WriteColor8888;
+			fb->colorFormat = VPMT_FRAME_COLOR_8888;
 			break;
 
 #if (VPMT_LITTLE_ENDIAN)
@@ -243,6 +221,7 @@ void VPMT_FrameBufferInit(VPMT_FrameBuffer * fb, VPMT_Surface * surface)
 		case GL_UNSIGNED_INT_8_8_8_8_REV:
 			fb->readColor = ReadColor8888_REV;
 			fb->writeColor = WriteColor8888_REV;
+			fb->colorFormat = VPMT_FRAME_COLOR_8888_REV;
 			break;
 
 		default:
@@ -254,6 +233,8 @@ void VPMT_FrameBufferInit(VPMT_FrameBuffer * fb, VPMT_Surface * surface)
 		break;
 	}
 
+	fb->depthStencilType = surface->depthStencilFormat->type;
+
 	switch (surface->depthStencilFormat->type) {
 	case VPMT_DEPTH_16:
 		fb->readDepth = ReadDepth16;
@@ -284,4 +265,540 @@ void VPMT_FrameBufferInit(VPMT_FrameBuffer * fb, VPMT_Surface * surface)
 	}
 }
 
+/*
+** Size in bytes of a buffer of width x height pixels of size bytes each in
+** the surface memory layout
+*/
+GLsizei VPMT_FrameBufferBytes(GLsizei width, GLsizei height, GLsizei size)
+{
+#if VPMT_TILED_SURFACE
+	width = (width + VPMT_SURFACE_TILE_MASK) & ~VPMT_SURFACE_TILE_MASK;
+	height = (height + VPMT_SURFACE_TILE_MASK) & ~VPMT_SURFACE_TILE_MASK;
+#endif
+
+	return width * height * size;
+}
+
+/*
+** Copy the pixels within rect of the tiled color buffer of a locked surface
+** to its image, which always uses the linear layout. If rect is NULL, the
+** entire surface is copied.
+*/
+void VPMT_FrameUpdateImage(VPMT_Surface * surface, const VPMT_Rect * rect)
+{
+#if VPMT_TILED_SURFACE
+	GLsizei size = surface->image.pixelFormat->size;
+	GLint x, y, minX, minY, maxX, maxY;
+	VPMT_FrameBuffer fb;
+	GLsizei run;
+
+	if (!surface->colorBuffer || !surface->image.data) {
+		return;
+	}
+
+	minX = minY = 0;
+	maxX = surface->image.size.width;
+	maxY = surface->image.size.height;
+
+	if (rect) {
+		minX = VPMT_MAX(minX, rect->origin[0]);
+		minY = VPMT_MAX(minY, rect->origin[1]);
+		maxX = VPMT_MIN(maxX, rect->origin[0] + rect->size.width);
+		maxY = VPMT_MIN(maxY, rect->origin[1] + rect->size.height);
+	}
+
+	VPMT_FrameBufferInit(&fb, surface);
+
+	for (y = minY; y < maxY; ++y) {
+		GLubyte *dst = (GLubyte *) surface->image.data + y * surface->image.pitch;
+
+		for (x = minX; x < maxX; x += run) {
+			run = VPMT_MIN(VPMT_SURFACE_TILE_SIZE - (x & VPMT_SURFACE_TILE_MASK), maxX - x);
+			memcpy(dst + x * size,
+				   VPMT_FrameBufferTileAddress(&fb, VPMT_FRAME_COLOR_BUFFER, x, y), run * size);
+		}
+	}
+#endif
+}
+
+/*
+** Read the colors of the pixels selected by mask from count pixels that are
+** adjacent in memory, starting at ptr.
+*/
+static void ReadColorRun(const VPMT_FrameBuffer * fb, const GLubyte * ptr, GLsizei count,
+						 VPMT_Color4ub colors[], GLuint mask)
+{
+	const GLushort *ptr16 = (const GLushort *) ptr;
+	const GLuint *ptr32 = (const GLuint *) ptr;
+	GLsizei index;
+
+	switch (fb->colorFormat) {
+	case VPMT_FRAME_COLOR_565:
+		for (index = 0; index < count; ++index) {
+			if (mask & (1u << index)) {
+				colors[index] = VPMT_FrameUnpackColor565(ptr16[index]);
+			}
+		}
+
+		break;
+
+	case VPMT_FRAME_COLOR_5551:
+		for (index = 0; index < count; ++index) {
+			if (mask & (1u << index)) {
+				colors[index] = VPMT_FrameUnpackColor5551(ptr16[index]);
+			}
+		}
+
+		break;
+
+	case VPMT_FRAME_COLOR_4444:
+		for (index = 0; index < count; ++index) {
+			if (mask & (1u << index)) {
+				colors[index] = VPMT_FrameUnpackColor4444(ptr16[index]);
+			}
+		}
+
+		break;
+
+	case VPMT_FRAME_COLOR_8888:
+		for (index = 0; index < count; ++index) {
+			if (mask & (1u << index)) {
+				colors[index] = VPMT_FrameUnpackColor8888(ptr32[index]);
+			}
+		}
+
+		break;
+
+	case VPMT_FRAME_COLOR_8888_REV:
+		/* the memory layout matches VPMT_Color4ub on little endian targets */
+		for (index = 0; index < count; ++index) {
+#if defined(VPMT_SSE2)
+			if (((mask >> index) & 0xfu) == 0xfu && index + 4 <= count) {
+				_mm_storeu_si128((__m128i *) (colors + index),
+								 _mm_loadu_si128((const __m128i *) (ptr32 + index)));
+				index += 3;
+				continue;
+			}
+#endif
+			if (mask & (1u << index)) {
+				colors[index] = VPMT_FrameUnpackColor8888_REV(ptr32[index]);
+			}
+		}
+
+		break;
+	}
+}
+
+/*
+** Write the colors of the pixels selected by mask to count pixels that are
+** adjacent in memory, starting at ptr.
+*/
+static void WriteColorRun(const VPMT_FrameBuffer * fb, GLubyte * ptr, GLsizei count,
+						  const VPMT_Color4ub colors[], GLuint mask)
+{
+	GLushort *ptr16 = (GLushort *) ptr;
+	GLuint *ptr32 = (GLuint *) ptr;
+	GLsizei index;
+
+	switch (fb->colorFormat) {
+	case VPMT_FRAME_COLOR_565:
+		for (index = 0; index < count; ++index) {
+			if (mask & (1u << index)) {
+				ptr16[index] = VPMT_FramePackColor565(colors[index]);
+			}
+		}
+
+		break;
+
+	case VPMT_FRAME_COLOR_5551:
+		for (index = 0; index < count; ++index) {
+			if (mask & (1u << index)) {
+				ptr16[index] = VPMT_FramePackColor5551(colors[index]);
+			}
+		}
+
+		break;
+
+	case VPMT_FRAME_COLOR_4444:
+		for (index = 0; index < count; ++index) {
+			if (mask & (1u << index)) {
+				ptr16[index] = VPMT_FramePackColor4444(colors[index]);
+			}
+		}
+
+		break;
+
+	case VPMT_FRAME_COLOR_8888:
+		for (index = 0; index < count; ++index) {
+			if (mask & (1u << index)) {
+				ptr32[index] = VPMT_FramePackColor8888(colors[index]);
+			}
+		}
+
+		break;
+
+	case VPMT_FRAME_COLOR_8888_REV:
+		for (index = 0; index < count; ++index) {
+#if defined(VPMT_SSE2)
+			if (((mask >> index) & 0xfu) == 0xfu && index + 4 <= count) {
+				_mm_storeu_si128((__m128i *) (ptr32 + index),
+								 _mm_loadu_si128((const __m128i *) (colors + index)));
+				index += 3;
+				continue;
+			}
+#endif
+			if (mask & (1u << index)) {
+				ptr32[index] = VPMT_FramePackColor8888_REV(colors[index]);
+			}
+		}
+
+		break;
+	}
+}
+
+/*
+** Read the colors of the pixels selected by mask from a span starting at
+** the current framebuffer position.
+*/
+void VPMT_FrameReadColorSpan(const VPMT_FrameBuffer * fb, GLsizei count, VPMT_Color4ub colors[],
+							 GLuint mask)
+{
+	GLsizei start, run;
+
+	for (start = 0; start < count; start += run) {
+		run = VPMT_FrameBufferRun(fb, start, count);
+		ReadColorRun(fb, VPMT_FrameBufferAddress(fb, VPMT_FRAME_COLOR_BUFFER, start), run,
+					 colors + start, mask >> start);
+	}
+}
+
+/*
+** Write the colors of the pixels selected by mask to a span starting at
+** the current framebuffer position.
+*/
+void VPMT_FrameWriteColorSpan(const VPMT_FrameBuffer * fb, GLsizei count,
+							  const VPMT_Color4ub colors[], GLuint mask)
+{
+	GLsizei start, run;
+
+	for (start = 0; start < count; start += run) {
+		run = VPMT_FrameBufferRun(fb, start, count);
+		WriteColorRun(fb, VPMT_FrameBufferAddress(fb, VPMT_FRAME_COLOR_BUFFER, start), run,
+					  colors + start, mask >> start);
+	}
+}
+
+/*
+** Write the same color to a span of count pixels starting at the current
+** framebuffer position.
+*/
+void VPMT_FrameFillColorSpan(const VPMT_FrameBuffer * fb, GLsizei count, VPMT_Color4ub color)
+{
+	GLuint value = VPMT_FrameColorValue(fb, color);
+	GLsizei start, run;
+
+	for (start = 0; start < count; start += run) {
+		GLubyte *ptr = VPMT_FrameBufferAddress(fb, VPMT_FRAME_COLOR_BUFFER, start);
+
+		run = VPMT_FrameBufferRun(fb, start, count);
+
+		if (fb->dx[VPMT_FRAME_COLOR_BUFFER] == 4) {
+			VPMT_FrameFill32((GLuint *) ptr, run, value);
+		} else {
+			VPMT_FrameFill16((GLushort *) ptr, run, (GLushort) value);
+		}
+	}
+}
+
+/*
+** Fill count 16 bit pixels with value. The bulk of the run is written with
+** aligned 16 byte stores where available, otherwise with 32 bit stores.
+*/
+void VPMT_FrameFill16(GLushort * ptr, GLsizei count, GLushort value)
+{
+	GLuint value32 = value | (value << 16);
+
+#if defined(VPMT_SSE2)
+	while (count > 0 && ((size_t) ptr & 15)) {
+		*ptr++ = value;
+		--count;
+	}
+
+	if (count >= 8) {
+		__m128i value128 = _mm_set1_epi32(value32);
+
+		do {
+			_mm_store_si128((__m128i *) ptr, value128);
+			ptr += 8;
+			count -= 8;
+		} while (count >= 8);
+	}
+#else
+	if (count > 0 && ((size_t) ptr & 3)) {
+		*ptr++ = value;
+		--count;
+	}
+
+	for (; count >= 2; count -= 2, ptr += 2) {
+		*(GLuint *) ptr = value32;
+	}
+#endif
+
+	while (count-- > 0) {
+		*ptr++ = value;
+	}
+}
+
+/*
+** Fill count 32 bit pixels with value.
+*/
+void VPMT_FrameFill32(GLuint * ptr, GLsizei count, GLuint value)
+{
+#if defined(VPMT_SSE2)
+	while (count > 0 && ((size_t) ptr & 15)) {
+		*ptr++ = value;
+		--count;
+	}
+
+	if (count >= 4) {
+		__m128i value128 = _mm_set1_epi32(value);
+
+		do {
+			_mm_store_si128((__m128i *) ptr, value128);
+			ptr += 4;
+			count -= 4;
+		} while (count >= 4);
+	}
+#endif
+
+	while (count-- > 0) {
+		*ptr++ = value;
+	}
+}
+
+/*
+** Fill count pixels with value, modifying only the bits selected by mask.
+*/
+static void FillMasked16(GLushort * ptr, GLsizei count, GLushort value, GLushort mask)
+{
+	value &= mask;
+
+#if defined(VPMT_SSE2)
+	while (count > 0 && ((size_t) ptr & 15)) {
+		*ptr = (*ptr & ~mask) | value;
+		++ptr;
+		--count;
+	}
+
+	if (count >= 8) {
+		__m128i value128 = _mm_set1_epi16((short) value);
+		__m128i mask128 = _mm_set1_epi16((short) mask);
+
+		do {
+			__m128i old = _mm_load_si128((const __m128i *) ptr);
+			_mm_store_si128((__m128i *) ptr, _mm_or_si128(_mm_andnot_si128(mask128, old), value128));
+			ptr += 8;
+			count -= 8;
+		} while (count >= 8);
+	}
+#endif
+
+	for (; count > 0; --count, ++ptr) {
+		*ptr = (*ptr & ~mask) | value;
+	}
+}
+
+static void FillMasked32(GLuint * ptr, GLsizei count, GLuint value, GLuint mask)
+{
+	value &= mask;
+
+#if defined(VPMT_SSE2)
+	while (count > 0 && ((size_t) ptr & 15)) {
+		*ptr = (*ptr & ~mask) | value;
+		++ptr;
+		--count;
+	}
+
+	if (count >= 4) {
+		__m128i value128 = _mm_set1_epi32(value);
+		__m128i mask128 = _mm_set1_epi32(mask);
+
+		do {
+			__m128i old = _mm_load_si128((const __m128i *) ptr);
+			_mm_store_si128((__m128i *) ptr, _mm_or_si128(_mm_andnot_si128(mask128, old), value128));
+			ptr += 4;
+			count -= 4;
+		} while (count >= 4);
+	}
+#endif
+
+	for (; count > 0; --count, ++ptr) {
+		*ptr = (*ptr & ~mask) | value;
+	}
+}
+
+/*
+** Fill count pixels of size bytes each with value, modifying only the bits
+** selected by mask.
+*/
+static void FillRun(GLubyte * ptr, GLsizei size, GLsizei count, GLuint value, GLuint mask,
+					GLuint allBits)
+{
+	if (size == 4) {
+		if ((mask & allBits) == allBits) {
+			VPMT_FrameFill32((GLuint *) ptr, count, value);
+		} else {
+			FillMasked32((GLuint *) ptr, count, value, mask);
+		}
+	} else {
+		if ((mask & allBits) == allBits) {
+			VPMT_FrameFill16((GLushort *) ptr, count, (GLushort) value);
+		} else {
+			FillMasked16((GLushort *) ptr, count, (GLushort) value, (GLushort) mask);
+		}
+	}
+}
+
+#if VPMT_TILED_SURFACE
+
+/*
+** Fill the pixels [x, endX) of row y of a buffer in the tiled layout
+*/
+static void FillTileRow(const VPMT_FrameBuffer * fb, GLsizei buffer, GLint x, GLint endX,
+						GLint y, GLuint value, GLuint mask)
+{
+	GLsizei run;
+
+	for (; x < endX; x += run) {
+		run = VPMT_MIN(VPMT_SURFACE_TILE_SIZE - (x & VPMT_SURFACE_TILE_MASK), endX - x);
+		FillRun(VPMT_FrameBufferTileAddress(fb, buffer, x, y), fb->dx[buffer], run, value, mask,
+				VPMT_FrameAllBits(fb, buffer));
+	}
+}
+
+#endif
+
+/*
+** Fill a rectangle of width x height pixels of a buffer starting at its
+** current framebuffer position. Only the bits of value selected by mask are
+** written. Rows that are adjacent in memory are filled as a single run.
+*/
+void VPMT_FrameFillRect(const VPMT_FrameBuffer * fb, GLsizei buffer, GLsizei width,
+						GLsizei height, GLuint value, GLuint mask)
+{
+	GLsizei size = fb->dx[buffer];
+	GLuint allBits = VPMT_FrameAllBits(fb, buffer);
+#if !VPMT_TILED_SURFACE
+	GLubyte *ptr = fb->current[buffer];
+	GLsizei pitch = fb->dy[buffer];
+#endif
+
+	if (width <= 0 || height <= 0 || !(mask & allBits)) {
+		return;
+	}
+
+#if VPMT_TILED_SURFACE
+	{
+		GLint x = fb->x, endX = fb->x + width, y = fb->y, endY = fb->y + height;
+		GLint tileX = (x + VPMT_SURFACE_TILE_MASK) & ~VPMT_SURFACE_TILE_MASK;
+		GLint tileEndX = endX & ~VPMT_SURFACE_TILE_MASK;
+		GLint row;
+
+		while (y < endY) {
+			if (!(y & VPMT_SURFACE_TILE_MASK) && y + VPMT_SURFACE_TILE_SIZE <= endY &&
+				tileX < tileEndX) {
+				/* the tiles covered within a row of tiles are adjacent in memory */
+				FillRun(VPMT_FrameBufferTileAddress(fb, buffer, tileX, y), size,
+						(tileEndX - tileX) << VPMT_SURFACE_TILE_BITS, value, mask, allBits);
+
+				for (row = 0; row < VPMT_SURFACE_TILE_SIZE; ++row, ++y) {
+					FillTileRow(fb, buffer, x, tileX, y, value, mask);
+					FillTileRow(fb, buffer, tileEndX, endX, y, value, mask);
+				}
+			} else {
+				FillTileRow(fb, buffer, x, endX, y++, value, mask);
+			}
+		}
+	}
+#else
+	if (pitch == size * width) {
+		width *= height;
+		height = 1;
+	} else if (pitch == -size * width) {
+		ptr += pitch * (height - 1);
+		width *= height;
+		height = 1;
+	}
+
+	for (; height != 0; --height, ptr += pitch) {
+		FillRun(ptr, size, width, value, mask, allBits);
+	}
+#endif
+}
+
+/*
+** Packed color buffer value for color
+*/
+GLuint VPMT_FrameColorValue(const VPMT_FrameBuffer * fb, VPMT_Color4ub color)
+{
+	switch (fb->colorFormat) {
+	case VPMT_FRAME_COLOR_565:
+		return VPMT_FramePackColor565(color);
+	case VPMT_FRAME_COLOR_5551:
+		return VPMT_FramePackColor5551(color);
+	case VPMT_FRAME_COLOR_4444:
+		return VPMT_FramePackColor4444(color);
+	case VPMT_FRAME_COLOR_8888:
+		return VPMT_FramePackColor8888(color);
+	default:
+		return VPMT_FramePackColor8888_REV(color);
+	}
+}
+
+/*
+** Bits of the color buffer modified under the color write mask colorMask
+*/
+GLuint VPMT_FrameColorMask(const VPMT_FrameBuffer * fb, const GLboolean colorMask[4])
+{
+	VPMT_Color4ub maskColor;
+
+	maskColor.red = colorMask[0] ? 0xffu : 0u;
+	maskColor.green = colorMask[1] ? 0xffu : 0u;
+	maskColor.blue = colorMask[2] ? 0xffu : 0u;
+	maskColor.alpha = colorMask[3] ? 0xffu : 0u;
+
+	return VPMT_FrameColorValue(fb, maskColor);
+}
+
+/*
+** Packed depth/stencil buffer value for depth and stencil
+*/
+GLuint VPMT_FrameDepthStencilValue(const VPMT_FrameBuffer * fb, GLuint depth, GLuint stencil)
+{
+	if (fb->depthStencilType == VPMT_DEPTH_24_STENCIL_8) {
+		return depth << 8 | (stencil & 0xffu);
+	} else {
+		return depth;
+	}
+}
+
+/*
+** Bits of the depth/stencil buffer modified when writing depth values if
+** depthMask is set, and the stencil bits selected by stencilMask
+*/
+GLuint VPMT_FrameDepthStencilMask(const VPMT_FrameBuffer * fb, GLboolean depthMask,
+								  GLuint stencilMask)
+{
+	switch (fb->depthStencilType) {
+	case VPMT_DEPTH_16:
+		return depthMask ? 0xffffu : 0u;
+	case VPMT_DEPTH_24_STENCIL_8:
+		return (depthMask ? 0xffffff00u : 0u) | (stencilMask & 0xffu);
+	case VPMT_DEPTH_32:
+		return depthMask ? ~0u : 0u;
+	default:
+		return 0u;
+	}
+}
+
 /* $Id: frame.c 74 2008-11-23 07:25:12Z hmwill $ */
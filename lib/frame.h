@@ -17,6 +17,27 @@
 
 typedef struct VPMT_FrameBuffer VPMT_FrameBuffer;
 
+typedef enum {
+	VPMT_FRAME_COLOR_565,
+	VPMT_FRAME_COLOR_5551,
+	VPMT_FRAME_COLOR_4444,
+	VPMT_FRAME_COLOR_8888,
+	VPMT_FRAME_COLOR_8888_REV
+} VPMT_FrameColorFormat;
+
+/* buffer indices into VPMT_FrameBuffer */
+#define VPMT_FRAME_COLOR_BUFFER			0
+#define VPMT_FRAME_DEPTH_STENCIL_BUFFER	1
+
+/*
+** In the tiled surface layout, the buffers are made of square tiles of
+** VPMT_SURFACE_TILE_SIZE pixels that are stored one after the other, and
+** bottom to top. The pixels of a tile are stored row by row. Only the pixels
+** of a row within a tile are adjacent in memory.
+*/
+#define VPMT_SURFACE_TILE_SIZE			(1 << VPMT_SURFACE_TILE_BITS)
+#define VPMT_SURFACE_TILE_MASK			(VPMT_SURFACE_TILE_SIZE - 1)
+
 typedef VPMT_Color4ub(*VPMT_FrameReadColorFunc) (const VPMT_FrameBuffer * fb);
 typedef void (*VPMT_FrameWriteColorFunc) (const VPMT_FrameBuffer * fb, VPMT_Color4ub color);
 typedef GLuint(*VPMT_FrameReadDepthFunc) (const VPMT_FrameBuffer * fb);
@@ -30,16 +51,151 @@ struct VPMT_FrameBuffer {
 	GLsizei dy[VPMT_MAX_RENDER_BUFFERS];					   /* increment in positive Y */
 	GLubyte *save[VPMT_MAX_RENDER_BUFFERS];					   /* address save area */
 
+#if VPMT_TILED_SURFACE
+	GLubyte *base[VPMT_MAX_RENDER_BUFFERS];					   /* address of pixel (0, 0) */
+	GLsizei tileDx[VPMT_MAX_RENDER_BUFFERS];				   /* X increment into the next tile */
+	GLsizei tileDy[VPMT_MAX_RENDER_BUFFERS];				   /* Y increment into the next tile */
+	GLsizei tilePitch[VPMT_MAX_RENDER_BUFFERS];				   /* size of a row of tiles */
+	GLint x, y;												   /* current position */
+	GLint saveX, saveY;										   /* position save area */
+#endif
+
 	VPMT_FrameReadColorFunc readColor;
 	VPMT_FrameWriteColorFunc writeColor;
 	VPMT_FrameReadDepthFunc readDepth;
 	VPMT_FrameWriteDepthFunc writeDepth;
 	VPMT_FrameReadStencilFunc readStencil;
 	VPMT_FrameWriteStencilFunc writeStencil;
+
+	VPMT_FrameColorFormat colorFormat;						   /* color buffer layout */
+	VPMT_DepthStencilType depthStencilType;					   /* depth/stencil buffer layout */
 };
 
 //void VPMT_FrameBufferClear(VPMT_FrameBuffer * fb, VPMT_Color4ub clearColor, GLuint clearDepth, GLuint clearStencil);
 void VPMT_FrameBufferInit(VPMT_FrameBuffer * fb, VPMT_Surface * surface);
+GLsizei VPMT_FrameBufferBytes(GLsizei width, GLsizei height, GLsizei size);
+void VPMT_FrameUpdateImage(VPMT_Surface * surface, const VPMT_Rect * rect);
+void VPMT_FrameReadColorSpan(const VPMT_FrameBuffer * fb, GLsizei count, VPMT_Color4ub colors[],
+							 GLuint mask);
+void VPMT_FrameWriteColorSpan(const VPMT_FrameBuffer * fb, GLsizei count,
+							  const VPMT_Color4ub colors[], GLuint mask);
+void VPMT_FrameFillColorSpan(const VPMT_FrameBuffer * fb, GLsizei count, VPMT_Color4ub color);
+
+void VPMT_FrameFillRect(const VPMT_FrameBuffer * fb, GLsizei buffer, GLsizei width,
+						GLsizei height, GLuint value, GLuint mask);
+
+GLuint VPMT_FrameColorValue(const VPMT_FrameBuffer * fb, VPMT_Color4ub color);
+GLuint VPMT_FrameColorMask(const VPMT_FrameBuffer * fb, const GLboolean colorMask[4]);
+GLuint VPMT_FrameDepthStencilValue(const VPMT_FrameBuffer * fb, GLuint depth, GLuint stencil);
+GLuint VPMT_FrameDepthStencilMask(const VPMT_FrameBuffer * fb, GLboolean depthMask,
+								  GLuint stencilMask);
+
+void VPMT_FrameFill16(GLushort * ptr, GLsizei count, GLushort value);
+void VPMT_FrameFill32(GLuint * ptr, GLsizei count, GLuint value);
+
+#if VPMT_TILED_SURFACE
+
+/*
+** Address of pixel (x, y) of a buffer in the tiled layout
+*/
+static VPMT_INLINE GLubyte *VPMT_FrameBufferTileAddress(const VPMT_FrameBuffer * fb,
+														GLsizei buffer, GLint x, GLint y)
+{
+	return fb->base[buffer] + (y >> VPMT_SURFACE_TILE_BITS) * fb->tilePitch[buffer] +
+		(((x >> VPMT_SURFACE_TILE_BITS) << (2 * VPMT_SURFACE_TILE_BITS)) +
+		 ((y & VPMT_SURFACE_TILE_MASK) << VPMT_SURFACE_TILE_BITS) +
+		 (x & VPMT_SURFACE_TILE_MASK)) * fb->dx[buffer];
+}
+
+static VPMT_INLINE void VPMT_FrameBufferMove(VPMT_FrameBuffer * fb, GLint deltaX, GLint deltaY)
+{
+	GLsizei index;
+
+	fb->x += deltaX;
+	fb->y += deltaY;
+
+	for (index = 0; index < VPMT_MAX_RENDER_BUFFERS; ++index) {
+		fb->current[index] = VPMT_FrameBufferTileAddress(fb, index, fb->x, fb->y);
+	}
+}
+
+static VPMT_INLINE void VPMT_FrameBufferStepX(VPMT_FrameBuffer * fb)
+{
+	GLboolean crossing = (++fb->x & VPMT_SURFACE_TILE_MASK) == 0;
+	GLsizei index;
+
+	for (index = 0; index < VPMT_MAX_RENDER_BUFFERS; ++index) {
+		fb->current[index] += crossing ? fb->tileDx[index] : fb->dx[index];
+	}
+}
+
+static VPMT_INLINE void VPMT_FrameBufferStepNegX(VPMT_FrameBuffer * fb)
+{
+	GLboolean crossing = (fb->x-- & VPMT_SURFACE_TILE_MASK) == 0;
+	GLsizei index;
+
+	for (index = 0; index < VPMT_MAX_RENDER_BUFFERS; ++index) {
+		fb->current[index] -= crossing ? fb->tileDx[index] : fb->dx[index];
+	}
+}
+
+static VPMT_INLINE void VPMT_FrameBufferStepY(VPMT_FrameBuffer * fb)
+{
+	GLboolean crossing = (++fb->y & VPMT_SURFACE_TILE_MASK) == 0;
+	GLsizei index;
+
+	for (index = 0; index < VPMT_MAX_RENDER_BUFFERS; ++index) {
+		fb->current[index] += crossing ? fb->tileDy[index] : fb->dy[index];
+	}
+}
+
+static VPMT_INLINE void VPMT_FrameBufferSave(VPMT_FrameBuffer * fb)
+{
+	GLsizei index;
+
+	for (index = 0; index < VPMT_MAX_RENDER_BUFFERS; ++index) {
+		fb->save[index] = fb->current[index];
+	}
+
+	fb->saveX = fb->x;
+	fb->saveY = fb->y;
+}
+
+static VPMT_INLINE void VPMT_FrameBufferRestore(VPMT_FrameBuffer * fb)
+{
+	GLsizei index;
+
+	for (index = 0; index < VPMT_MAX_RENDER_BUFFERS; ++index) {
+		fb->current[index] = fb->save[index];
+	}
+
+	fb->x = fb->saveX;
+	fb->y = fb->saveY;
+}
+
+/*
+** Number of pixels of a span of count pixels, starting offset pixels to the
+** right of the current position, that are adjacent in memory
+*/
+static VPMT_INLINE GLsizei VPMT_FrameBufferRun(const VPMT_FrameBuffer * fb, GLsizei offset,
+											   GLsizei count)
+{
+	GLsizei run = VPMT_SURFACE_TILE_SIZE - ((fb->x + offset) & VPMT_SURFACE_TILE_MASK);
+
+	return VPMT_MIN(run, count - offset);
+}
+
+/*
+** Address of a buffer offset pixels to the right of the current position
+*/
+static VPMT_INLINE GLubyte *VPMT_FrameBufferAddress(const VPMT_FrameBuffer * fb, GLsizei buffer,
+													GLsizei offset)
+{
+	return offset ? VPMT_FrameBufferTileAddress(fb, buffer, fb->x + offset, fb->y) :
+		fb->current[buffer];
+}
+
+#else
 
 static VPMT_INLINE void VPMT_FrameBufferMove(VPMT_FrameBuffer * fb, GLint deltaX, GLint deltaY)
 {
@@ -95,6 +251,122 @@ static VPMT_INLINE void VPMT_FrameBufferRestore(VPMT_FrameBuffer * fb)
 	}
 }
 
+static VPMT_INLINE GLsizei VPMT_FrameBufferRun(const VPMT_FrameBuffer * fb, GLsizei offset,
+											   GLsizei count)
+{
+	return count - offset;
+}
+
+static VPMT_INLINE GLubyte *VPMT_FrameBufferAddress(const VPMT_FrameBuffer * fb, GLsizei buffer,
+													GLsizei offset)
+{
+	return fb->current[buffer] + offset * fb->dx[buffer];
+}
+
+#endif
+
+/*
+** Conversion between color values and the packed pixel representation of
+** the supported color buffer formats
+*/
+
+static VPMT_INLINE VPMT_Color4ub VPMT_FrameUnpackColor565(GLushort value)
+{
+	VPMT_Color4ub result;
+
+	result.red = (value & 0xF800) >> 8 | (value & 0xF800) >> 13;
+	result.green = (value & 0x07E0) >> 3 | (value & 0x07E0) >> 9;
+	result.blue = (value & 0x001F) << 3 | (value & 0x001F) >> 2;
+	result.alpha = 0xffu;
+
+	return result;
+}
+
+static VPMT_INLINE GLushort VPMT_FramePackColor565(VPMT_Color4ub color)
+{
+	return
+		((color.red << 8) & 0xF800) | ((color.green << 3) & 0x07E0) | ((color.blue >> 3) & 0x001F);
+}
+
+static VPMT_INLINE VPMT_Color4ub VPMT_FrameUnpackColor5551(GLushort value)
+{
+	VPMT_Color4ub result;
+
+	result.red = (value & 0xF800) >> 8 | (value & 0xF800) >> 13;
+	result.green = (value & 0x07C0) >> 3 | (value & 0x07C0) >> 8;
+	result.blue = (value & 0x003E) << 2 | (value & 0x003E) >> 3;
+	result.alpha = (value & 1) ? 0xffu : 0u;
+
+	return result;
+}
+
+static VPMT_INLINE GLushort VPMT_FramePackColor5551(VPMT_Color4ub color)
+{
+	return
+		((color.red << 8) & 0xF800) |
+		((color.green << 3) & 0x07C0) | ((color.blue >> 2) & 0x003E) | ((color.alpha >> 7) & 1);
+}
+
+static VPMT_INLINE VPMT_Color4ub VPMT_FrameUnpackColor4444(GLushort value)
+{
+	VPMT_Color4ub result;
+
+	result.red = (value & 0xF000) >> 8 | (value & 0xF000) >> 12;
+	result.green = (value & 0x0F00) >> 4 | (value & 0x0F00) >> 8;
+	result.blue = (value & 0x00F0) | (value & 0x00F0) >> 4;
+	result.alpha = (value & 0x000F) << 4 | (value & 0x000F);
+
+	return result;
+}
+
+static VPMT_INLINE GLushort VPMT_FramePackColor4444(VPMT_Color4ub color)
+{
+	return
+		((color.red << 8) & 0xF000) |
+		((color.green << 4) & 0x0F00) | ((color.blue) & 0x00F0) | ((color.alpha >> 4) & 0x000F);
+}
+
+static VPMT_INLINE VPMT_Color4ub VPMT_FrameUnpackColor8888(GLuint value)
+{
+	VPMT_Color4ub result;
+
+	result.red = (value & 0xFF000000) >> 24;
+	result.green = (value & 0x00FF0000) >> 16;
+	result.blue = (value & 0x0000FF00) >> 8;
+	result.alpha = (value & 0x000000FF);
+
+	return result;
+}
+
+static VPMT_INLINE GLuint VPMT_FramePackColor8888(VPMT_Color4ub color)
+{
+	return color.red << 24 | color.green << 16 | color.blue << 8 | color.alpha;
+}
+
+static VPMT_INLINE VPMT_Color4ub VPMT_FrameUnpackColor8888_REV(GLuint value)
+{
+	VPMT_Color4ub result;
+
+	result.red = (value & 0x000000FF);
+	result.green = (value & 0x0000FF00) >> 8;
+	result.blue = (value & 0x00FF0000) >> 16;
+	result.alpha = (value & 0xFF000000) >> 24;
+
+	return result;
+}
+
+static VPMT_INLINE GLuint VPMT_FramePackColor8888_REV(VPMT_Color4ub color)
+{
+	return color.alpha << 24 | color.blue << 16 | color.green << 8 | color.red;
+}
+
+/*
+** All bits of a pixel of the given buffer
+*/
+static VPMT_INLINE GLuint VPMT_FrameAllBits(const VPMT_FrameBuffer * fb, GLsizei buffer)
+{
+	return fb->dx[buffer] == 4 ? ~0u : 0xffffu;
+}
 
 static VPMT_INLINE VPMT_Color4ub VPMT_FrameReadColor(const VPMT_FrameBuffer * fb)
 {
@@ -662,6 +662,116 @@ GLAPI void APIENTRY glGetColorTableParameterivEXT(GLenum target, GLenum pname, G
 
 #endif
 
+/*
+** -------------------------------------------------------------------------
+** GL_ARB_vertex_buffer_object
+** -------------------------------------------------------------------------
+*/
+#if GL_ARB_vertex_buffer_object
+
+GLAPI void APIENTRY glBindBufferARB(GLenum target, GLuint buffer)
+{
+	VPMT_Context *context = VPMT_CONTEXT();
+	context->dispatch->BindBuffer(context, target, buffer);
+}
+
+GLAPI void APIENTRY glBufferDataARB(GLenum target, GLsizeiptrARB size, const GLvoid * data,
+									GLenum usage)
+{
+	VPMT_Context *context = VPMT_CONTEXT();
+	context->dispatch->BufferData(context, target, size, data, usage);
+}
+
+GLAPI void APIENTRY glBufferSubDataARB(GLenum target, GLintptrARB offset, GLsizeiptrARB size,
+									   const GLvoid * data)
+{
+	VPMT_Context *context = VPMT_CONTEXT();
+	context->dispatch->BufferSubData(context, target, offset, size, data);
+}
+
+GLAPI void APIENTRY glDeleteBuffersARB(GLsizei n, const GLuint * buffers)
+{
+	VPMT_Context *context = VPMT_CONTEXT();
+	context->dispatch->DeleteBuffers(context, n, buffers);
+}
+
+GLAPI void APIENTRY glGenBuffersARB(GLsizei n, GLuint * buffers)
+{
+	VPMT_Context *context = VPMT_CONTEXT();
+	context->dispatch->GenBuffers(context, n, buffers);
+}
+
+#endif
+
+/*
+** -------------------------------------------------------------------------
+** GL_EXT_compiled_vertex_array
+** -------------------------------------------------------------------------
+*/
+#if GL_EXT_compiled_vertex_array
+
+GLAPI void APIENTRY glLockArraysEXT(GLint first, GLsizei count)
+{
+	VPMT_Context *context = VPMT_CONTEXT();
+	context->dispatch->LockArrays(context, first, count);
+}
+
+GLAPI void APIENTRY glUnlockArraysEXT(void)
+{
+	VPMT_Context *context = VPMT_CONTEXT();
+	context->dispatch->UnlockArrays(context);
+}
+
+#endif
+
+/*
+** -------------------------------------------------------------------------
+** GL_EXT_multi_draw_arrays
+** -------------------------------------------------------------------------
+*/
+#if GL_EXT_multi_draw_arrays
+
+GLAPI void APIENTRY glMultiDrawArraysEXT(GLenum mode, const GLint * first, const GLsizei * count,
+										 GLsizei primcount)
+{
+	VPMT_Context *context = VPMT_CONTEXT();
+	context->dispatch->MultiDrawArrays(context, mode, first, count, primcount);
+}
+
+GLAPI void APIENTRY glMultiDrawElementsEXT(GLenum mode, const GLsizei * count, GLenum type,
+										   const GLvoid ** indices, GLsizei primcount)
+{
+	VPMT_Context *context = VPMT_CONTEXT();
+	context->dispatch->MultiDrawElements(context, mode, count, type, indices, primcount);
+}
+
+#endif
+
+/*
+** -------------------------------------------------------------------------
+** GL_VPMT_instanced_modelview
+** -------------------------------------------------------------------------
+*/
+#if GL_VPMT_instanced_modelview
+
+GLAPI void APIENTRY glDrawArraysInstancedVPMT(GLenum mode, GLint first, GLsizei count,
+											  GLsizei primcount, const GLfloat * modelviews)
+{
+	VPMT_Context *context = VPMT_CONTEXT();
+	context->dispatch->DrawArraysInstanced(context, mode, first, count, primcount, modelviews);
+}
+
+GLAPI void APIENTRY glDrawElementsInstancedVPMT(GLenum mode, GLsizei count, GLenum type,
+												const GLvoid * indices, GLsizei primcount,
+												const GLfloat * modelviews)
+{
+	VPMT_Context *context = VPMT_CONTEXT();
+	context->dispatch->DrawElementsInstanced(context, mode, count, type, indices, primcount,
+											 modelviews);
+}
+
+#endif
+
 /*
 ** -------------------------------------------------------------------------
 ** Dispatch table
@@ -774,6 +884,29 @@ VPMT_Dispatch VPMT_DispatchExecute = {
 	&VPMT_ExecGetColorTable,
 	&VPMT_ExecGetColorTableParameteriv,
 #endif
+
+#if GL_ARB_vertex_buffer_object
+	&VPMT_ExecBindBuffer,
+	&VPMT_ExecBufferData,
+	&VPMT_ExecBufferSubData,
+	&VPMT_ExecDeleteBuffers,
+	&VPMT_ExecGenBuffers,
+#endif
+
+#if GL_EXT_compiled_vertex_array
+	&VPMT_ExecLockArrays,
+	&VPMT_ExecUnlockArrays,
+#endif
+
+#if GL_EXT_multi_draw_arrays
+	&VPMT_ExecMultiDrawArrays,
+	&VPMT_ExecMultiDrawElements,
+#endif
+
+#if GL_VPMT_instanced_modelview
+	&VPMT_ExecDrawArraysInstanced,
+	&VPMT_ExecDrawElementsInstanced,
+#endif
 };
 
 /* $Id: gl.c 74 2008-11-23 07:25:12Z hmwill $ */
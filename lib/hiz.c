@@ -0,0 +1,206 @@
+/*
+** -------------------------------------------------------------------------
+** Vincent SC 1.0 Rendering Library
+**
+** Hierarchical depth buffer for early block rejection
+**
+** Copyright (C) 2008 Vincent Pervasive Media Technologies, LLC. 
+**
+** Licensed under the Artistic License 2.0.
+** -------------------------------------------------------------------------
+*/
+
+#include "common.h"
+#include "GL/gl.h"
+#include "context.h"
+#include "hiz.h"
+
+/*
+** -------------------------------------------------------------------------
+** The depth buffer of a surface is divided into blocks of
+** VPMT_HIZ_BLOCK_SIZE pixels square, aligned to the surface origin. For
+** each block, the farthest depth value that may be stored within the block
+** is kept. Clearing the depth buffer sets the bound exactly. With the depth
+** functions GL_LESS and GL_LEQUAL, depth writes can only decrease stored
+** values, so the bounds remain valid; blocks covered completely by a
+** triangle lower their bound to the farthest depth of the triangle within
+** the block. Any other depth state that writes depth values invalidates
+** the bounds until the next complete clear.
+** -------------------------------------------------------------------------
+*/
+
+/*
+** Intersection of a block and the surface area
+*/
+static void BlockRect(const VPMT_Surface * surface, GLint blockX, GLint blockY, VPMT_Rect * rect)
+{
+	rect->origin[0] = blockX << VPMT_HIZ_BLOCK_BITS;
+	rect->origin[1] = blockY << VPMT_HIZ_BLOCK_BITS;
+	rect->size.width = VPMT_MIN(VPMT_HIZ_BLOCK_SIZE, surface->image.size.width - rect->origin[0]);
+	rect->size.height =
+		VPMT_MIN(VPMT_HIZ_BLOCK_SIZE, surface->image.size.height - rect->origin[1]);
+}
+
+static GLboolean ContainsRect(const VPMT_Rect * outer, const VPMT_Rect * inner)
+{
+	return
+		inner->origin[0] >= outer->origin[0] &&
+		inner->origin[1] >= outer->origin[1] &&
+		inner->origin[0] + inner->size.width <= outer->origin[0] + outer->size.width &&
+		inner->origin[1] + inner->size.height <= outer->origin[1] + outer->size.height;
+}
+
+/*
+** Can writing fragments with the current depth state increase stored depth
+** values?
+*/
+static GLboolean MayIncreaseDepth(const VPMT_Context * context)
+{
+	if (!context->depthWriteMask) {
+		return GL_FALSE;
+	}
+
+	if (!context->depthTestEnabled) {
+		return GL_TRUE;
+	}
+
+	switch (context->depthFunc) {
+	case GL_NEVER:
+	case GL_LESS:
+	case GL_LEQUAL:
+	case GL_EQUAL:
+		return GL_FALSE;
+
+	default:
+		return GL_TRUE;
+	}
+}
+
+/*
+** -------------------------------------------------------------------------
+** Exported functions
+** -------------------------------------------------------------------------
+*/
+
+GLboolean VPMT_HiZInit(VPMT_Surface * surface)
+{
+	VPMT_HiZState *state = &surface->hiZ;
+
+	state->width = (surface->image.size.width + VPMT_HIZ_BLOCK_SIZE - 1) >> VPMT_HIZ_BLOCK_BITS;
+	state->height = (surface->image.size.height + VPMT_HIZ_BLOCK_SIZE - 1) >> VPMT_HIZ_BLOCK_BITS;
+	state->valid = GL_FALSE;
+	state->blocks = VPMT_MALLOC(state->width * state->height * sizeof(GLuint));
+
+	return state->blocks != NULL;
+}
+
+void VPMT_HiZDeinit(VPMT_Surface * surface)
+{
+	if (surface->hiZ.blocks) {
+		VPMT_FREE(surface->hiZ.blocks);
+		surface->hiZ.blocks = NULL;
+	}
+
+	surface->hiZ.valid = GL_FALSE;
+}
+
+void VPMT_HiZClear(VPMT_Surface * surface, const VPMT_Rect * rect, GLuint depth)
+{
+	VPMT_HiZState *state = &surface->hiZ;
+	GLint blockX, blockY, blockMinX, blockMinY, blockMaxX, blockMaxY;
+	VPMT_Rect blockRect;
+
+	if (!state->blocks || rect->size.width <= 0 || rect->size.height <= 0) {
+		return;
+	}
+
+	if (!state->valid) {
+		/* blocks outside of rect would keep an unknown bound */
+		if (rect->origin[0] > 0 || rect->origin[1] > 0 ||
+			rect->origin[0] + rect->size.width < surface->image.size.width ||
+			rect->origin[1] + rect->size.height < surface->image.size.height) {
+			return;
+		}
+
+		state->valid = GL_TRUE;
+	}
+
+	blockMinX = rect->origin[0] >> VPMT_HIZ_BLOCK_BITS;
+	blockMinY = rect->origin[1] >> VPMT_HIZ_BLOCK_BITS;
+	blockMaxX = (rect->origin[0] + rect->size.width - 1) >> VPMT_HIZ_BLOCK_BITS;
+	blockMaxY = (rect->origin[1] + rect->size.height - 1) >> VPMT_HIZ_BLOCK_BITS;
+
+	for (blockY = blockMinY; blockY <= blockMaxY; ++blockY) {
+		GLuint *farthest = state->blocks + blockY * state->width + blockMinX;
+
+		for (blockX = blockMinX; blockX <= blockMaxX; ++blockX, ++farthest) {
+			BlockRect(surface, blockX, blockY, &blockRect);
+
+			/* partially cleared blocks can only raise their bound */
+			if (ContainsRect(rect, &blockRect) || *farthest < depth) {
+				*farthest = depth;
+			}
+		}
+	}
+}
+
+void VPMT_HiZPrepare(VPMT_Context * context)
+{
+	VPMT_Surface *surface = context->writeSurface;
+
+	context->hiZMode = 0;
+
+	if (!surface || !surface->hiZ.blocks || !context->depthBits) {
+		return;
+	}
+
+	if (MayIncreaseDepth(context)) {
+		surface->hiZ.valid = GL_FALSE;
+		return;
+	}
+
+	/* skipping fragments must not skip any stencil updates */
+	if (!VPMT_HIERARCHICAL_Z || !surface->hiZ.valid || !context->depthTestEnabled ||
+		context->stencilTestEnabled ||
+		(context->depthFunc != GL_LESS && context->depthFunc != GL_LEQUAL)) {
+		return;
+	}
+
+	context->hiZMode = VPMT_HIZ_REJECT;
+
+	if (context->depthFunc == GL_LESS) {
+		context->hiZMode |= VPMT_HIZ_LESS;
+	}
+
+	/* every fragment of a covered block is written */
+	if (context->depthWriteMask && !context->alphaTestEnabled &&
+		!context->polygonStippleEnabled) {
+		context->hiZMode |= VPMT_HIZ_UPDATE;
+	}
+}
+
+GLboolean VPMT_HiZOccluded(const VPMT_Surface * surface, GLuint mode, GLuint depth,
+						   const VPMT_Rect * rect)
+{
+	const VPMT_HiZState *state = &surface->hiZ;
+	GLint blockX, blockY, blockMinX, blockMinY, blockMaxX, blockMaxY;
+
+	blockMinX = rect->origin[0] >> VPMT_HIZ_BLOCK_BITS;
+	blockMinY = rect->origin[1] >> VPMT_HIZ_BLOCK_BITS;
+	blockMaxX = (rect->origin[0] + rect->size.width - 1) >> VPMT_HIZ_BLOCK_BITS;
+	blockMaxY = (rect->origin[1] + rect->size.height - 1) >> VPMT_HIZ_BLOCK_BITS;
+
+	for (blockY = blockMinY; blockY <= blockMaxY; ++blockY) {
+		const GLuint *farthest = state->blocks + blockY * state->width + blockMinX;
+
+		for (blockX = blockMinX; blockX <= blockMaxX; ++blockX, ++farthest) {
+			if (!VPMT_HiZReject(mode, depth, *farthest)) {
+				return GL_FALSE;
+			}
+		}
+	}
+
+	return GL_TRUE;
+}
+
+/* $Id: hiz.c 74 2008-11-23 07:25:12Z hmwill $ */
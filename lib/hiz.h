@@ -0,0 +1,91 @@
+/*
+** -------------------------------------------------------------------------
+** Vincent SC 1.0 Rendering Library
+**
+** Hierarchical depth buffer for early block rejection
+**
+** Copyright (C) 2008 Vincent Pervasive Media Technologies, LLC. 
+**
+** Licensed under the Artistic License 2.0.
+** -------------------------------------------------------------------------
+*/
+
+#ifndef VPMT_HIZ_H
+#define VPMT_HIZ_H
+
+#include "context.h"
+
+/* rasterizer modes selected by VPMT_HiZPrepare */
+#define VPMT_HIZ_REJECT		1								   /* reject occluded blocks */
+#define VPMT_HIZ_LESS		2								   /* depth function is GL_LESS */
+#define VPMT_HIZ_UPDATE		4								   /* covered blocks lower the bound */
+
+/*
+** Allocate the block depth bounds of a newly created surface. The bounds
+** are invalid until the depth buffer is cleared completely.
+*/
+GLboolean VPMT_HiZInit(VPMT_Surface * surface);
+
+/*
+** Release the block depth bounds of a surface.
+*/
+void VPMT_HiZDeinit(VPMT_Surface * surface);
+
+/*
+** Update the block depth bounds for a clear of the depth buffer within rect.
+*/
+void VPMT_HiZClear(VPMT_Surface * surface, const VPMT_Rect * rect, GLuint depth);
+
+/*
+** Invalidate the block depth bounds of the write surface if the current
+** depth state may increase stored depth values, and select the mode used
+** by the triangle rasterizer. Needs to be called before fragments are
+** written.
+*/
+void VPMT_HiZPrepare(VPMT_Context * context);
+
+/*
+** Are the pixels within rect occluded for a primitive whose depth values
+** are not smaller than depth?
+*/
+GLboolean VPMT_HiZOccluded(const VPMT_Surface * surface, GLuint mode, GLuint depth,
+						   const VPMT_Rect * rect);
+
+/*
+** Farthest depth value of the block containing pixel (x, y)
+*/
+static VPMT_INLINE GLuint *VPMT_HiZBlock(const VPMT_Surface * surface, GLint x, GLint y)
+{
+	return surface->hiZ.blocks +
+		(y >> VPMT_HIZ_BLOCK_BITS) * surface->hiZ.width + (x >> VPMT_HIZ_BLOCK_BITS);
+}
+
+/*
+** Depth buffer value of an interpolated depth, rounded down. Fragment depth
+** values are truncated, so the result bounds the values stored for
+** fragments of depth not smaller than depth.
+*/
+static VPMT_INLINE GLuint VPMT_HiZDepth(GLfloat depth)
+{
+	if (depth <= 0.0f) {
+		return 0;
+	} else if (depth >= 4294967296.0f) {
+		return ~0u;
+	} else {
+		return (GLuint) depth;
+	}
+}
+
+/*
+** Do all fragments of depth not smaller than depth fail against farthest?
+** The comparison is performed in depth buffer units, as single precision
+** cannot represent all values of 24 and 32 bit depth buffers.
+*/
+static VPMT_INLINE GLboolean VPMT_HiZReject(GLuint mode, GLuint depth, GLuint farthest)
+{
+	return (mode & VPMT_HIZ_LESS) ? depth >= farthest : depth > farthest;
+}
+
+#endif
+
+/* $Id: hiz.h 74 2008-11-23 07:25:12Z hmwill $ */
@@ -13,6 +13,7 @@
 #include "common.h"
 #include "GL/gl.h"
 #include "context.h"
+#include "vertex.h"
 
 /*
 ** -------------------------------------------------------------------------
@@ -203,6 +204,11 @@ void VPMT_ExecMaterialf(VPMT_Context * context, GLenum face, GLenum pname, GLflo
 		return;
 	}
 
+	if (context->renderMode != GL_INVALID_MODE) {
+		/* vertices collected so far use the previous material */
+		VPMT_VertexBatchFlush(context);
+	}
+
 	switch (pname) {
 	case GL_SHININESS:
 		if (param < 0.0f || param > 128.0f) {
@@ -231,6 +237,11 @@ void VPMT_ExecMaterialfv(VPMT_Context * context, GLenum face, GLenum pname, cons
 		return;
 	}
 
+	if (context->renderMode != GL_INVALID_MODE) {
+		/* vertices collected so far use the previous material */
+		VPMT_VertexBatchFlush(context);
+	}
+
 	switch (pname) {
 	case GL_AMBIENT:
 		VPMT_Vec4Copy(context->materialAmbient, params);
@@ -2207,6 +2207,33 @@ VPMT_Dispatch VPMT_DispatchRecord = {
 	&VPMT_ExecGetColorTable,
 	&VPMT_ExecGetColorTableParameteriv,
 #endif
+
+#if GL_ARB_vertex_buffer_object
+	/* buffer object commands are not compiled into display lists */
+	&VPMT_ExecBindBuffer,
+	&VPMT_ExecBufferData,
+	&VPMT_ExecBufferSubData,
+	&VPMT_ExecDeleteBuffers,
+	&VPMT_ExecGenBuffers,
+#endif
+
+#if GL_EXT_compiled_vertex_array
+	/* array locks are client state and are not compiled into display lists */
+	&VPMT_ExecLockArrays,
+	&VPMT_ExecUnlockArrays,
+#endif
+
+#if GL_EXT_multi_draw_arrays
+	/* compiled as the sequence of individual draw commands */
+	&VPMT_ExecMultiDrawArrays,
+	&VPMT_ExecMultiDrawElements,
+#endif
+
+#if GL_VPMT_instanced_modelview
+	/* compiled as the sequence of matrix and individual draw commands */
+	&VPMT_ExecDrawArraysInstanced,
+	&VPMT_ExecDrawElementsInstanced,
+#endif
 };
 
 /* $Id: list.c 74 2008-11-23 07:25:12Z hmwill $ */
@@ -13,6 +13,15 @@
 #include "common.h"
 #include "GL/gl.h"
 
+#if VPMT_RASTER_THREADS
+#	if defined(_WIN32)
+#		include <windows.h>
+#	else
+#		include <pthread.h>
+#		include <semaphore.h>
+#	endif
+#endif
+
 void *VPMT_Malloc(VPMT_Size_t size)
 {
 	return malloc(size);
@@ -112,4 +121,237 @@ void VPMT_FreeDebug(void *ptr, const char *filename, int line)
 	}
 }
 
+/*
+** -------------------------------------------------------------------------
+** Threads and synchronization primitives
+** -------------------------------------------------------------------------
+*/
+
+#if VPMT_RASTER_THREADS
+
+struct VPMT_ThreadImpl {
+	VPMT_ThreadFunc func;
+	void *arg;
+#if defined(_WIN32)
+	HANDLE handle;
+#else
+	pthread_t handle;
+#endif
+};
+
+struct VPMT_MutexImpl {
+#if defined(_WIN32)
+	CRITICAL_SECTION section;
+#else
+	pthread_mutex_t mutex;
+#endif
+};
+
+struct VPMT_SemaphoreImpl {
+#if defined(_WIN32)
+	HANDLE handle;
+#else
+	sem_t semaphore;
+#endif
+};
+
+#if defined(_WIN32)
+
+static DWORD WINAPI ThreadMain(LPVOID arg)
+{
+	VPMT_Thread thread = (VPMT_Thread) arg;
+
+	thread->func(thread->arg);
+	return 0;
+}
+
+VPMT_Thread VPMT_ThreadCreate(VPMT_ThreadFunc func, void *arg)
+{
+	VPMT_Thread thread = VPMT_MALLOC(sizeof(struct VPMT_ThreadImpl));
+
+	if (!thread) {
+		return NULL;
+	}
+
+	thread->func = func;
+	thread->arg = arg;
+	thread->handle = CreateThread(NULL, 0, ThreadMain, thread, 0, NULL);
+
+	if (!thread->handle) {
+		VPMT_FREE(thread);
+		return NULL;
+	}
+
+	return thread;
+}
+
+void VPMT_ThreadJoin(VPMT_Thread thread)
+{
+	WaitForSingleObject(thread->handle, INFINITE);
+	CloseHandle(thread->handle);
+	VPMT_FREE(thread);
+}
+
+VPMT_Mutex VPMT_MutexCreate(void)
+{
+	VPMT_Mutex mutex = VPMT_MALLOC(sizeof(struct VPMT_MutexImpl));
+
+	if (mutex) {
+		InitializeCriticalSection(&mutex->section);
+	}
+
+	return mutex;
+}
+
+void VPMT_MutexDestroy(VPMT_Mutex mutex)
+{
+	DeleteCriticalSection(&mutex->section);
+	VPMT_FREE(mutex);
+}
+
+void VPMT_MutexLock(VPMT_Mutex mutex)
+{
+	EnterCriticalSection(&mutex->section);
+}
+
+void VPMT_MutexUnlock(VPMT_Mutex mutex)
+{
+	LeaveCriticalSection(&mutex->section);
+}
+
+VPMT_Semaphore VPMT_SemaphoreCreate(unsigned int count)
+{
+	VPMT_Semaphore semaphore = VPMT_MALLOC(sizeof(struct VPMT_SemaphoreImpl));
+
+	if (!semaphore) {
+		return NULL;
+	}
+
+	semaphore->handle = CreateSemaphore(NULL, count, LONG_MAX, NULL);
+
+	if (!semaphore->handle) {
+		VPMT_FREE(semaphore);
+		return NULL;
+	}
+
+	return semaphore;
+}
+
+void VPMT_SemaphoreDestroy(VPMT_Semaphore semaphore)
+{
+	CloseHandle(semaphore->handle);
+	VPMT_FREE(semaphore);
+}
+
+void VPMT_SemaphoreWait(VPMT_Semaphore semaphore)
+{
+	WaitForSingleObject(semaphore->handle, INFINITE);
+}
+
+void VPMT_SemaphorePost(VPMT_Semaphore semaphore, unsigned int count)
+{
+	if (count) {
+		ReleaseSemaphore(semaphore->handle, count, NULL);
+	}
+}
+
+#else
+
+static void *ThreadMain(void *arg)
+{
+	VPMT_Thread thread = (VPMT_Thread) arg;
+
+	thread->func(thread->arg);
+	return NULL;
+}
+
+VPMT_Thread VPMT_ThreadCreate(VPMT_ThreadFunc func, void *arg)
+{
+	VPMT_Thread thread = VPMT_MALLOC(sizeof(struct VPMT_ThreadImpl));
+
+	if (!thread) {
+		return NULL;
+	}
+
+	thread->func = func;
+	thread->arg = arg;
+
+	if (pthread_create(&thread->handle, NULL, ThreadMain, thread)) {
+		VPMT_FREE(thread);
+		return NULL;
+	}
+
+	return thread;
+}
+
+void VPMT_ThreadJoin(VPMT_Thread thread)
+{
+	pthread_join(thread->handle, NULL);
+	VPMT_FREE(thread);
+}
+
+VPMT_Mutex VPMT_MutexCreate(void)
+{
+	VPMT_Mutex mutex = VPMT_MALLOC(sizeof(struct VPMT_MutexImpl));
+
+	if (mutex && pthread_mutex_init(&mutex->mutex, NULL)) {
+		VPMT_FREE(mutex);
+		return NULL;
+	}
+
+	return mutex;
+}
+
+void VPMT_MutexDestroy(VPMT_Mutex mutex)
+{
+	pthread_mutex_destroy(&mutex->mutex);
+	VPMT_FREE(mutex);
+}
+
+void VPMT_MutexLock(VPMT_Mutex mutex)
+{
+	pthread_mutex_lock(&mutex->mutex);
+}
+
+void VPMT_MutexUnlock(VPMT_Mutex mutex)
+{
+	pthread_mutex_unlock(&mutex->mutex);
+}
+
+VPMT_Semaphore VPMT_SemaphoreCreate(unsigned int count)
+{
+	VPMT_Semaphore semaphore = VPMT_MALLOC(sizeof(struct VPMT_SemaphoreImpl));
+
+	if (semaphore && sem_init(&semaphore->semaphore, 0, count)) {
+		VPMT_FREE(semaphore);
+		return NULL;
+	}
+
+	return semaphore;
+}
+
+void VPMT_SemaphoreDestroy(VPMT_Semaphore semaphore)
+{
+	sem_destroy(&semaphore->semaphore);
+	VPMT_FREE(semaphore);
+}
+
+void VPMT_SemaphoreWait(VPMT_Semaphore semaphore)
+{
+	while (sem_wait(&semaphore->semaphore)) {
+		/* restart if interrupted by a signal */
+	}
+}
+
+void VPMT_SemaphorePost(VPMT_Semaphore semaphore, unsigned int count)
+{
+	while (count--) {
+		sem_post(&semaphore->semaphore);
+	}
+}
+
+#endif
+
+#endif
+
 /* $Id: platform.c 74 2008-11-23 07:25:12Z hmwill $ */
@@ -37,6 +37,24 @@
 #	define VPMT_EMULATE_FLOAT_MATH
 #endif
 
+/*
+** -------------------------------------------------------------------------
+** SIMD instruction set extensions available on the target
+** -------------------------------------------------------------------------
+*/
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#	define VPMT_SSE2
+#endif
+
+#if defined(__AVX__)
+#	define VPMT_AVX
+#endif
+
+#if defined(_M_X64) || defined(__x86_64__)
+#	define VPMT_X86_64
+#endif
+
 /*
 ** -------------------------------------------------------------------------
 ** Provide memory management debug helper functions
@@ -63,6 +81,31 @@ void VPMT_FreeDebug(void *ptr, const char *filename, int line);
 #	define VPMT_FREE(ptr) VPMT_Free(ptr)
 #endif
 
+/*
+** -------------------------------------------------------------------------
+** Threads and synchronization primitives
+** -------------------------------------------------------------------------
+*/
+
+typedef struct VPMT_ThreadImpl *VPMT_Thread;
+typedef struct VPMT_MutexImpl *VPMT_Mutex;
+typedef struct VPMT_SemaphoreImpl *VPMT_Semaphore;
+
+typedef void (*VPMT_ThreadFunc) (void *arg);
+
+VPMT_Thread VPMT_ThreadCreate(VPMT_ThreadFunc func, void *arg);
+void VPMT_ThreadJoin(VPMT_Thread thread);
+
+VPMT_Mutex VPMT_MutexCreate(void);
+void VPMT_MutexDestroy(VPMT_Mutex mutex);
+void VPMT_MutexLock(VPMT_Mutex mutex);
+void VPMT_MutexUnlock(VPMT_Mutex mutex);
+
+VPMT_Semaphore VPMT_SemaphoreCreate(unsigned int count);
+void VPMT_SemaphoreDestroy(VPMT_Semaphore semaphore);
+void VPMT_SemaphoreWait(VPMT_Semaphore semaphore);
+void VPMT_SemaphorePost(VPMT_Semaphore semaphore, unsigned int count);
+
 #endif
 
 /* $Id: platform.h 74 2008-11-23 07:25:12Z hmwill $ */
@@ -158,4 +158,51 @@ void VPMT_RasterPrepareInterpolants(VPMT_Context * context)
 	context->rasterInterpolants = rasterInterpolants;
 }
 
+/*
+** Conservative pixel bounds of the fragments generated for a primitive.
+*/
+static void SetBounds(VPMT_Rect * bounds, GLint minX, GLint minY, GLint maxX, GLint maxY)
+{
+	bounds->origin[0] = minX;
+	bounds->origin[1] = minY;
+	bounds->size.width = maxX - minX;
+	bounds->size.height = maxY - minY;
+}
+
+void VPMT_RasterPointBounds(const VPMT_Context * context, const VPMT_RasterVertex * a,
+							VPMT_Rect * bounds)
+{
+	GLint x = a->screenCoords[0] >> VPMT_SUBPIXEL_BITS;
+	GLint y = a->screenCoords[1] >> VPMT_SUBPIXEL_BITS;
+	GLint extent = context->pointSmoothEnabled ?
+		(context->aaPointSize >> VPMT_SUBPIXEL_BITS) + 2 : (context->integerPointSize >> 1) + 2;
+
+	SetBounds(bounds, x - extent, y - extent, x + extent, y + extent);
+}
+
+void VPMT_RasterLineBounds(const VPMT_Context * context, const VPMT_RasterVertex * a,
+						   const VPMT_RasterVertex * b, VPMT_Rect * bounds)
+{
+	GLint extent = (context->integerLineWidth >> 1) + 2;
+	GLint minX = VPMT_MIN(a->screenCoords[0], b->screenCoords[0]) >> VPMT_SUBPIXEL_BITS;
+	GLint minY = VPMT_MIN(a->screenCoords[1], b->screenCoords[1]) >> VPMT_SUBPIXEL_BITS;
+	GLint maxX = VPMT_MAX(a->screenCoords[0], b->screenCoords[0]) >> VPMT_SUBPIXEL_BITS;
+	GLint maxY = VPMT_MAX(a->screenCoords[1], b->screenCoords[1]) >> VPMT_SUBPIXEL_BITS;
+
+	SetBounds(bounds, minX - extent, minY - extent, maxX + extent, maxY + extent);
+}
+
+void VPMT_RasterTriangleBounds(const VPMT_Context * context, const VPMT_RasterVertex * a,
+							   const VPMT_RasterVertex * b, const VPMT_RasterVertex * c,
+							   VPMT_Rect * bounds)
+{
+	GLint minX = VPMT_MIN(VPMT_MIN(a->screenCoords[0], b->screenCoords[0]), c->screenCoords[0]);
+	GLint minY = VPMT_MIN(VPMT_MIN(a->screenCoords[1], b->screenCoords[1]), c->screenCoords[1]);
+	GLint maxX = VPMT_MAX(VPMT_MAX(a->screenCoords[0], b->screenCoords[0]), c->screenCoords[0]);
+	GLint maxY = VPMT_MAX(VPMT_MAX(a->screenCoords[1], b->screenCoords[1]), c->screenCoords[1]);
+
+	SetBounds(bounds, (minX >> VPMT_SUBPIXEL_BITS) - 1, (minY >> VPMT_SUBPIXEL_BITS) - 1,
+			  (maxX >> VPMT_SUBPIXEL_BITS) + 2, (maxY >> VPMT_SUBPIXEL_BITS) + 2);
+}
+
 /* $Id: raster.c 74 2008-11-23 07:25:12Z hmwill $ */
@@ -37,6 +37,17 @@ void VPMT_RasterPrepareLine(VPMT_Context * context);
 void VPMT_RasterPrepareTriangle(VPMT_Context * context);
 void VPMT_LineStippleReset(VPMT_Context * context);
 
+/*
+** Conservative pixel bounds of the fragments generated for a primitive
+*/
+void VPMT_RasterPointBounds(const VPMT_Context * context, const VPMT_RasterVertex * a,
+							VPMT_Rect * bounds);
+void VPMT_RasterLineBounds(const VPMT_Context * context, const VPMT_RasterVertex * a,
+						   const VPMT_RasterVertex * b, VPMT_Rect * bounds);
+void VPMT_RasterTriangleBounds(const VPMT_Context * context, const VPMT_RasterVertex * a,
+							   const VPMT_RasterVertex * b, const VPMT_RasterVertex * c,
+							   VPMT_Rect * bounds);
+
 void VPMT_RasterQuadAA(VPMT_Context * context, const VPMT_RasterVertex * a,
 					   const VPMT_RasterVertex * b, const VPMT_RasterVertex * c,
 					   const VPMT_RasterVertex * d);
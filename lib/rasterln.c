@@ -135,27 +135,32 @@ static void RasterVerticalBar(VPMT_Context * context, GLuint x, GLuint y,
 							  VPMT_Color4ub rgba, GLuint depth, GLsizei count)
 {
 	VPMT_FrameBuffer fb;
-
-	VPMT_FrameBufferInit(&fb, context->writeSurface);
-	VPMT_FrameBufferMove(&fb, x, y);
+	VPMT_Color4ub colors[VPMT_FRAGMENT_SPAN_SIZE];
+	GLuint depths[VPMT_FRAGMENT_SPAN_SIZE];
 
 	/* pixel ownership test based on intersection of scissor and surface rect */
-	if ((x - context->activeSurfaceRect.origin[0]) < 0 ||
-		(x - context->activeSurfaceRect.origin[0]) >=
-		(GLuint) context->activeSurfaceRect.size.width) {
+	if ((GLint) (x - context->activeSurfaceRect.origin[0]) < 0 ||
+		(GLint) (x - context->activeSurfaceRect.origin[0]) >=
+		context->activeSurfaceRect.size.width) {
 		return;
 	}
 
+	VPMT_FrameBufferInit(&fb, context->writeSurface);
+	VPMT_FrameBufferMove(&fb, x, y);
+
+	colors[0] = rgba;
+	depths[0] = depth;
+
 	do {
 		/* pixel ownership test based on intersection of scissor and surface rect */
-		if ((y - context->activeSurfaceRect.origin[1]) < 0
-			|| (y - context->activeSurfaceRect.origin[1]) >=
-			(GLuint) context->activeSurfaceRect.size.height) {
-			continue;
+		if ((GLint) (y - context->activeSurfaceRect.origin[1]) >= 0 &&
+			(GLint) (y - context->activeSurfaceRect.origin[1]) <
+			context->activeSurfaceRect.size.height) {
+			VPMT_FragmentSpan(context, &fb, 1, colors, depths, 1u);
 		}
 
-		VPMT_Fragment(context, &fb, rgba, depth);
 		VPMT_FrameBufferStepY(&fb);
+		++y;
 	} while (--count);
 }
 
@@ -163,28 +168,42 @@ static void RasterHorizontalBar(VPMT_Context * context, GLuint x, GLuint y,
 								VPMT_Color4ub rgba, GLuint depth, GLsizei count)
 {
 	VPMT_FrameBuffer fb;
+	VPMT_Color4ub colors[VPMT_FRAGMENT_SPAN_SIZE];
+	GLuint depths[VPMT_FRAGMENT_SPAN_SIZE];
+	GLsizei index;
+
+	/* pixel ownership test based on intersection of scissor and surface rect */
+	if ((GLint) (y - context->activeSurfaceRect.origin[1]) < 0 ||
+		(GLint) (y - context->activeSurfaceRect.origin[1]) >=
+		context->activeSurfaceRect.size.height) {
+		return;
+	}
 
 	VPMT_FrameBufferInit(&fb, context->writeSurface);
 	VPMT_FrameBufferMove(&fb, x, y);
 
-	/* pixel ownership test based on intersection of scissor and surface rect */
-	if ((y - context->activeSurfaceRect.origin[1]) < 0
-		|| (y - context->activeSurfaceRect.origin[1]) >=
-		(GLuint) context->activeSurfaceRect.size.height) {
-		return;
+	for (index = 0; index < VPMT_MIN(count, VPMT_FRAGMENT_SPAN_SIZE); ++index) {
+		colors[index] = rgba;
+		depths[index] = depth;
 	}
 
 	do {
-		/* pixel ownership test based on intersection of scissor and surface rect */
-		if ((x - context->activeSurfaceRect.origin[0]) < 0 ||
-			(x - context->activeSurfaceRect.origin[0]) >=
-			(GLuint) context->activeSurfaceRect.size.width) {
-			continue;
+		GLsizei spanCount = VPMT_MIN(count, VPMT_FRAGMENT_SPAN_SIZE);
+		GLuint mask = 0;
+
+		for (index = 0; index < spanCount; ++index, ++x) {
+			/* pixel ownership test based on intersection of scissor and surface rect */
+			if ((GLint) (x - context->activeSurfaceRect.origin[0]) >= 0 &&
+				(GLint) (x - context->activeSurfaceRect.origin[0]) <
+				context->activeSurfaceRect.size.width) {
+				mask |= 1u << index;
+			}
 		}
 
-		VPMT_Fragment(context, &fb, rgba, depth);
-		VPMT_FrameBufferStepX(&fb);
-	} while (--count);
+		VPMT_FragmentSpan(context, &fb, spanCount, colors, depths, mask);
+		VPMT_FrameBufferMove(&fb, spanCount, 0);
+		count -= spanCount;
+	} while (count > 0);
 }
 
 static void RasterLineFlat(VPMT_Context * context, const VPMT_RasterVertex * a,
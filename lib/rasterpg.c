@@ -15,6 +15,13 @@
 #include "context.h"
 #include "raster.h"
 #include "frame.h"
+#include "span.h"
+#include "hiz.h"
+#include "zplane.h"
+
+#if defined(VPMT_SSE2)
+#	include <emmintrin.h>
+#endif
 
 #define SUBPIXEL_MASK ((1 << VPMT_SUBPIXEL_BITS) - 1)
 #define HALF (1 << (VPMT_SUBPIXEL_BITS - 1))
@@ -112,13 +119,13 @@ static void SetupTriangleRasterVariables(RasterVariables * vars, const VPMT_Rast
 	vars->equ[1] = y3 * x2 - x3 * y2 + (dybc < 0 || (dybc == 0 && dxbc > 0));
 	vars->equ[2] = y1 * x3 - x1 * y3 + (dyca < 0 || (dyca == 0 && dxca > 0));
 
-	vars->equ_dy[0] = -dxab << VPMT_SUBPIXEL_BITS;
-	vars->equ_dy[1] = -dxbc << VPMT_SUBPIXEL_BITS;
-	vars->equ_dy[2] = -dxca << VPMT_SUBPIXEL_BITS;
+	vars->equ_dy[0] = -dxab * ONE;
+	vars->equ_dy[1] = -dxbc * ONE;
+	vars->equ_dy[2] = -dxca * ONE;
 
-	vars->equ_dx[0] = dyab << VPMT_SUBPIXEL_BITS;
-	vars->equ_dx[1] = dybc << VPMT_SUBPIXEL_BITS;
-	vars->equ_dx[2] = dyca << VPMT_SUBPIXEL_BITS;
+	vars->equ_dx[0] = dyab * ONE;
+	vars->equ_dx[1] = dybc * ONE;
+	vars->equ_dx[2] = dyca * ONE;
 
 	/* determine values for pixel corner of (minx, miny) */
 	VPMT_Vec3ScaleAdd(vars->equ, vars->equ_dx, vars->minx, vars->equ);
@@ -158,15 +165,15 @@ static void SetupQuadAARasterVariables(RasterVariables * vars, const VPMT_Raster
 	vars->equ[2] = y4 * x3 - x4 * y3 + (dycd < 0 || (dycd == 0 && dxcd > 0));
 	vars->equ[3] = y1 * x4 - x1 * y4 + (dyda < 0 || (dyda == 0 && dxda > 0));
 
-	vars->equ_dy[0] = -dxab << VPMT_SUBPIXEL_BITS;
-	vars->equ_dy[1] = -dxbc << VPMT_SUBPIXEL_BITS;
-	vars->equ_dy[2] = -dxcd << VPMT_SUBPIXEL_BITS;
-	vars->equ_dy[3] = -dxda << VPMT_SUBPIXEL_BITS;
+	vars->equ_dy[0] = -dxab * ONE;
+	vars->equ_dy[1] = -dxbc * ONE;
+	vars->equ_dy[2] = -dxcd * ONE;
+	vars->equ_dy[3] = -dxda * ONE;
 
-	vars->equ_dx[0] = dyab << VPMT_SUBPIXEL_BITS;
-	vars->equ_dx[1] = dybc << VPMT_SUBPIXEL_BITS;
-	vars->equ_dx[2] = dycd << VPMT_SUBPIXEL_BITS;
-	vars->equ_dx[3] = dyda << VPMT_SUBPIXEL_BITS;
+	vars->equ_dx[0] = dyab * ONE;
+	vars->equ_dx[1] = dybc * ONE;
+	vars->equ_dx[2] = dycd * ONE;
+	vars->equ_dx[3] = dyda * ONE;
 
 	/* determine values for pixel corner of (minx, miny) */
 	VPMT_Vec4ScaleAdd(vars->equ, vars->equ_dx, vars->minx, vars->equ);
@@ -183,8 +190,21 @@ typedef struct Interpolants {
 
 typedef struct Interpolation {
 	Interpolants current, dx, dy, save;
+	GLsizei perspectiveSpan;								   /* pixels per perspective division */
 } Interpolation;
 
+/*
+** Texture coordinates and rho interpolated linearly between two pixels with
+** exact perspective division.
+*/
+typedef struct AffineSegment {
+	VPMT_Vec2 texCoords[VPMT_MAX_TEX_UNITS], texCoordsDx[VPMT_MAX_TEX_UNITS];
+	GLfloat rho[VPMT_MAX_TEX_UNITS], rhoDx[VPMT_MAX_TEX_UNITS];
+} AffineSegment;
+
+#define TEX_COORD_INTERPOLANTS \
+	(((1 << VPMT_MAX_TEX_UNITS) - 1) * VPMT_RasterInterpolateTexCoord0)
+
 VPMT_INLINE static GLfloat Square(GLfloat value)
 {
 	return value * value;
@@ -245,6 +265,8 @@ static void InterpolationInit(Interpolation * interp, const VPMT_RasterVertex *
 	/* determine area */
 	GLfloat area = fdxab * fdybc - fdyab * fdxbc;
 
+	interp->perspectiveSpan = 1;
+
 	/* initialize to last vertex */
 	interp->current.depth = c->depth;
 	interp->current.invW = c->invW;
@@ -522,149 +544,173 @@ static VPMT_INLINE void InterpolationRestore(Interpolation * interp, GLuint rast
 	}
 }
 
-static VPMT_INLINE VPMT_Color4ub FragmentShader(VPMT_Context * context,
-												const Interpolants * current)
+/*
+** Number of pixels between exact perspective divisions for a triangle, as
+** requested by the perspective correction hint. Texture coordinates and rho
+** are interpolated linearly in between. Under GL_FASTEST, triangles with
+** nearly constant w are interpolated linearly across each piece of a row.
+*/
+static GLsizei PerspectiveSpan(const VPMT_Context * context, const VPMT_RasterVertex * a,
+							   const VPMT_RasterVertex * b, const VPMT_RasterVertex * c)
 {
-	GLsizei index;
-	GLfloat W = 1.0f / current->invW, W2 = W * W;
+	GLfloat minInvW, maxInvW;
 
-	VPMT_Vec2 texCoords[VPMT_MAX_TEX_UNITS];
-	GLfloat rho[VPMT_MAX_TEX_UNITS];
+	switch (context->perspectiveCorrectionHint) {
+	case GL_NICEST:
+		return 1;
 
-	for (index = 0; index < VPMT_MAX_TEX_UNITS; ++index) {
-		if (context->rasterInterpolants & (VPMT_RasterInterpolateTexCoord0 << index)) {
-			VPMT_Vec2Scale(texCoords[index], current->texCoordsOverW[index], W);
+	case GL_FASTEST:
+		minInvW = VPMT_MIN(a->invW, VPMT_MIN(b->invW, c->invW));
+		maxInvW = VPMT_MAX(a->invW, VPMT_MAX(b->invW, c->invW));
 
-			if (context->rasterInterpolants & (VPMT_RasterInterpolateRho0 << index)) {
-				rho[index] = current->rhoOverW2[index] * W2;
-			}
+		if (maxInvW - minInvW <= minInvW * (1.0f / 64.0f)) {
+			return VPMT_TILE_SIZE;
 		}
-	}
 
-	return VPMT_TexImageUnitsExecute(context->texUnits, VPMT_ConvertVec4ToColor4us(current->rgba),
-									 texCoords, rho);
+		return VPMT_PERSPECTIVE_SPAN_FASTEST;
+
+	default:
+		return VPMT_PERSPECTIVE_SPAN;
+	}
 }
 
-static void RasterTriangle(VPMT_Context * context, const VPMT_RasterVertex * a,
-						   const VPMT_RasterVertex * b, const VPMT_RasterVertex * c)
+/*
+** Initialize the interpolation values at the center of pixel (0, 0), including
+** the polygon offset.
+*/
+static void InterpolationInitOrigin(VPMT_Context * context, Interpolation * origin,
+									const VPMT_RasterVertex * a, const VPMT_RasterVertex * b,
+									const VPMT_RasterVertex * c)
 {
 	GLuint rasterInterpolants = context->rasterInterpolants;
-	RasterVariables vars;
-	Interpolation interpolation;
-	VPMT_FrameBuffer fb;
-
-	GLfloat xStart, yStart, deltaX, deltaY;
-	GLint x, y;
-
-	/* Setup the rasterizer variables */
-	InterpolationInit(&interpolation, a, b, c, context->texUnits, rasterInterpolants);
-	SetupTriangleRasterVariables(&vars, a, b, c);
-
-	vars.maxx =
-		VPMT_MIN(vars.maxx,
-				 context->activeSurfaceRect.origin[0] + context->activeSurfaceRect.size.width);
-	vars.maxy =
-		VPMT_MIN(vars.maxy,
-				 context->activeSurfaceRect.origin[1] + context->activeSurfaceRect.size.height);
-	vars.minx = VPMT_MAX(vars.minx, context->activeSurfaceRect.origin[0]);
-	vars.miny = VPMT_MAX(vars.miny, context->activeSurfaceRect.origin[1]);
-
-	/* x and y coordinate of pixel center of min/min-corner of rectangle */
-	xStart = vars.minx + 0.5f;
-	yStart = vars.miny + 0.5f;
 
-	/* vector from a to (xmin, xmax) pixel center */
-	deltaX = xStart - (c->screenCoords[0] * (1.0f / ONE));
-	deltaY = yStart - (c->screenCoords[1] * (1.0f / ONE));
+	InterpolationInit(origin, a, b, c, context->texUnits, rasterInterpolants);
+	InterpolationMove(origin, 0.5f - c->screenCoords[0] * PRECISION,
+					  0.5f - c->screenCoords[1] * PRECISION, rasterInterpolants);
 
-	InterpolationMove(&interpolation, deltaX, deltaY, rasterInterpolants);
+	if (rasterInterpolants & TEX_COORD_INTERPOLANTS) {
+		origin->perspectiveSpan = PerspectiveSpan(context, a, b, c);
+	}
 
 	if (context->polygonOffsetFillEnabled) {
-		interpolation.current.depth +=
-			sqrtf(Square(interpolation.dx.depth) +
-				  Square(interpolation.dy.depth)) * context->polygonOffsetFactor;
+		origin->current.depth +=
+			sqrtf(Square(origin->dx.depth) +
+				  Square(origin->dy.depth)) * context->polygonOffsetFactor;
 
 		if (context->writeSurface) {
-			interpolation.current.depth += context->polygonOffsetUnit;
+			origin->current.depth += context->polygonOffsetUnit;
 		}
 	}
+}
 
-	x = vars.minx;
+/*
+** Perspective correct texture coordinates and rho for the values given.
+*/
+static VPMT_INLINE void TexCoords(GLuint rasterInterpolants, GLfloat invW,
+								  const VPMT_Vec2 texCoordsOverW[], const GLfloat rhoOverW2[],
+								  VPMT_Vec2 texCoords[], GLfloat rho[])
+{
+	GLsizei index;
+	GLfloat W = 1.0f / invW, W2 = W * W;
 
-	VPMT_FrameBufferInit(&fb, context->writeSurface);
-	VPMT_FrameBufferMove(&fb, vars.minx, vars.miny);
+	for (index = 0; index < VPMT_MAX_TEX_UNITS; ++index) {
+		if (rasterInterpolants & (VPMT_RasterInterpolateTexCoord0 << index)) {
+			VPMT_Vec2Scale(texCoords[index], texCoordsOverW[index], W);
 
-	for (y = vars.miny; y < vars.maxy; y++) {
-		VPMT_Vec3i cx;
-		GLint xsave;
-		GLboolean seenFragment = GL_FALSE;
+			if (rasterInterpolants & (VPMT_RasterInterpolateRho0 << index)) {
+				rho[index] = rhoOverW2[index] * W2;
+			} else {
+				rho[index] = 0.0f;
+			}
+		}
+	}
+}
 
-		VPMT_Vec3Copy(cx, vars.equ);
-		InterpolationSave(&interpolation, rasterInterpolants);
-		VPMT_FrameBufferSave(&fb);
-		xsave = x;
+/*
+** Set up the segment of count pixels starting offset pixels to the right of
+** the current interpolation values.
+*/
+static void AffineSegmentInit(AffineSegment * segment, const Interpolation * interp,
+							  GLuint rasterInterpolants, GLsizei offset, GLsizei count)
+{
+	VPMT_Vec2 texCoordsOverW[VPMT_MAX_TEX_UNITS], texCoords[VPMT_MAX_TEX_UNITS];
+	GLfloat rhoOverW2[VPMT_MAX_TEX_UNITS], rho[VPMT_MAX_TEX_UNITS];
+	GLfloat invW, scale = 1.0f / count;
+	GLsizei index, pass;
 
-		for (; x < vars.maxx; ++x) {
-			if (cx[0] > 0 && cx[1] > 0 && cx[2] > 0) {
-				if (GetPolygonStipple(context, x, y)) {
-					/* render the fragment */
-					VPMT_Color4ub rgba = FragmentShader(context, &interpolation.current);
-					VPMT_Fragment(context, &fb, rgba, (GLuint) interpolation.current.depth);
-				}
+	for (pass = 0; pass < 2; ++pass) {
+		GLfloat delta = (GLfloat) (pass ? offset + count : offset);
 
-				if (!seenFragment) {
-					VPMT_Vec3Copy(vars.equ, cx);
-					InterpolationSave(&interpolation, rasterInterpolants);
-					VPMT_FrameBufferSave(&fb);
-					xsave = x;
-					seenFragment = GL_TRUE;
-				}
-			} else if (seenFragment) {
-				break;
+		invW = interp->dx.invW * delta + interp->current.invW;
+
+		for (index = 0; index < VPMT_MAX_TEX_UNITS; ++index) {
+			if (rasterInterpolants & (VPMT_RasterInterpolateTexCoord0 << index)) {
+				VPMT_Vec2ScaleAdd(texCoordsOverW[index], interp->dx.texCoordsOverW[index], delta,
+								  interp->current.texCoordsOverW[index]);
 			}
 
-			VPMT_Vec3Add(cx, cx, vars.equ_dx);
-			InterpolationStepX(&interpolation, rasterInterpolants);
-			VPMT_FrameBufferStepX(&fb);
+			if (rasterInterpolants & (VPMT_RasterInterpolateRho0 << index)) {
+				rhoOverW2[index] =
+					interp->dx.rhoOverW2[index] * delta + interp->current.rhoOverW2[index];
+			}
 		}
 
-		VPMT_Vec3Copy(cx, vars.equ);
-		InterpolationRestore(&interpolation, rasterInterpolants);
-		VPMT_FrameBufferRestore(&fb);
+		TexCoords(rasterInterpolants, invW, texCoordsOverW, rhoOverW2,
+				  pass ? texCoords : segment->texCoords, pass ? rho : segment->rho);
+	}
 
-		for (x = xsave - 1; x >= vars.minx; --x) {
-			VPMT_Vec3Sub(cx, cx, vars.equ_dx);
-			InterpolationStepNegX(&interpolation, rasterInterpolants);
-			VPMT_FrameBufferStepNegX(&fb);
+	for (index = 0; index < VPMT_MAX_TEX_UNITS; ++index) {
+		if (rasterInterpolants & (VPMT_RasterInterpolateTexCoord0 << index)) {
+			VPMT_Vec2Sub(texCoords[index], texCoords[index], segment->texCoords[index]);
+			VPMT_Vec2Scale(segment->texCoordsDx[index], texCoords[index], scale);
+			segment->rhoDx[index] = (rho[index] - segment->rho[index]) * scale;
+		}
+	}
+}
 
-			if (cx[0] > 0 && cx[1] > 0 && cx[2] > 0) {
-				if (GetPolygonStipple(context, x, y)) {
-					/* render the fragment */
-					VPMT_Color4ub rgba = FragmentShader(context, &interpolation.current);
-					VPMT_Fragment(context, &fb, rgba, (GLuint) interpolation.current.depth);
-				}
+static VPMT_INLINE void AffineSegmentStep(AffineSegment * segment, GLuint rasterInterpolants)
+{
+	GLsizei index;
 
-				if (!seenFragment) {
-					VPMT_Vec3Copy(vars.equ, cx);
-					InterpolationSave(&interpolation, rasterInterpolants);
-					VPMT_FrameBufferSave(&fb);
-					xsave = x;
-					seenFragment = GL_TRUE;
-				}
-			} else if (seenFragment) {
-				break;
-			}
+	for (index = 0; index < VPMT_MAX_TEX_UNITS; ++index) {
+		if (rasterInterpolants & (VPMT_RasterInterpolateTexCoord0 << index)) {
+			VPMT_Vec2Add(segment->texCoords[index], segment->texCoords[index],
+						 segment->texCoordsDx[index]);
+			segment->rho[index] += segment->rhoDx[index];
 		}
-
-		x = xsave;
-		VPMT_Vec3Add(vars.equ, vars.equ, vars.equ_dy);
-		InterpolationRestore(&interpolation, rasterInterpolants);
-		InterpolationStepY(&interpolation, rasterInterpolants);
-		VPMT_FrameBufferRestore(&fb);
-		VPMT_FrameBufferStepY(&fb);
 	}
 }
 
+/*
+** Number of pixels from x to the next exact perspective division, but not
+** beyond end.
+*/
+static VPMT_INLINE GLsizei AffineSegmentLength(GLint x, GLint end, GLsizei perspectiveSpan)
+{
+	return VPMT_MIN((x | (perspectiveSpan - 1)) + 1, end) - x;
+}
+
+static VPMT_INLINE VPMT_Color4ub FragmentShader(VPMT_Context * context,
+												const Interpolants * current)
+{
+	VPMT_Vec2 texCoords[VPMT_MAX_TEX_UNITS];
+	GLfloat rho[VPMT_MAX_TEX_UNITS];
+
+	TexCoords(context->rasterInterpolants, current->invW, current->texCoordsOverW,
+			  current->rhoOverW2, texCoords, rho);
+
+	return VPMT_TexImageUnitsExecute(context->texUnits, VPMT_ConvertVec4ToColor4us(current->rgba),
+									 texCoords, rho);
+}
+
+static VPMT_INLINE VPMT_Color4ub AffineFragmentShader(VPMT_Context * context,
+													  const Interpolants * current,
+													  const AffineSegment * segment)
+{
+	return VPMT_TexImageUnitsExecute(context->texUnits, VPMT_ConvertVec4ToColor4us(current->rgba),
+									 segment->texCoords, segment->rho);
+}
+
 typedef struct Edge {
 	GLint x;												   // Current Fix(X) value
 	GLint delta;											   // Fix(DX/DY)
@@ -688,267 +734,677 @@ static VPMT_INLINE GLint FixedMul(GLint a, GLint b)
 	return (GLint) (((__int64) a * b) >> FRAC_BITS);
 }
 
+/*
+** Without alpha test, the outcome of depth and stencil test does not depend
+** on the fragment color. In this case, the tests are performed before the
+** fragment is shaded, and occluded fragments are never textured. If
+** depthPasses is set, all fragments are known to pass the depth test, and the
+** depth buffer is not accessed.
+*/
 static void RasterTriangleScanLine(VPMT_Context * context, Interpolation * interpolation,
-								   VPMT_FrameBuffer * fb, GLsizei length, GLuint stipple)
+								   VPMT_FrameBuffer * fb, GLint x, GLsizei length, GLuint stipple,
+								   GLboolean depthPasses)
 {
 	GLuint rasterInterpolants = context->rasterInterpolants;
+	GLboolean earlyDepthStencil = !context->alphaTestEnabled;
+	GLboolean affine = interpolation->perspectiveSpan > 1;
+	VPMT_Color4ub colors[VPMT_FRAGMENT_SPAN_SIZE];
+	GLuint depths[VPMT_FRAGMENT_SPAN_SIZE];
+	GLint end = x + length;
+	GLsizei remaining = 0;
+	AffineSegment segment;
+
+	while (length > 0) {
+		GLsizei count = VPMT_MIN(length, VPMT_FRAGMENT_SPAN_SIZE);
+		GLfloat depth = interpolation->current.depth;
+		GLuint mask = 0;
+		GLsizei index;
+
+		/* coverage from the stipple pattern, and the depth values */
+		for (index = 0; index < count; ++index) {
+			mask |= (stipple >> 31) << index;
+			stipple = RotateLeft(stipple, 1);
+			depths[index] = (GLuint) depth;
+			depth += interpolation->dx.depth;
+		}
 
-	if (length > 0) {
-		do {
-			// generate a fragment
-			if (stipple & 0x80000000u) {
-				GLuint depth = (GLuint) interpolation->current.depth;
-				VPMT_Color4ub rgba = FragmentShader(context, &interpolation->current);
-				VPMT_Fragment(context, fb, rgba, depth);
+		if (context->rasterDepthOnly) {
+			/* no color is written, so only update depth & stencil */
+			if (!depthPasses) {
+				VPMT_FragmentSpanDepthStencil(context, fb, count, depths, mask);
 			}
 
-			stipple = RotateLeft(stipple, 1);
+			interpolation->current.depth = depth;
+			VPMT_FrameBufferMove(fb, count, 0);
+			x += count;
+			length -= count;
+			continue;
+		}
 
-			if (!--length)
-				return;
+		if (earlyDepthStencil && !depthPasses) {
+			mask = VPMT_FragmentSpanDepthStencil(context, fb, count, depths, mask);
+		}
+
+		/* shade the fragments that are still alive */
+		for (index = 0; index < count; ++index) {
+			if (affine && !remaining) {
+				remaining = AffineSegmentLength(x + index, end, interpolation->perspectiveSpan);
+				AffineSegmentInit(&segment, interpolation, rasterInterpolants, 0, remaining);
+			}
+
+			if (mask & (1u << index)) {
+				colors[index] = affine ?
+					AffineFragmentShader(context, &interpolation->current, &segment) :
+					FragmentShader(context, &interpolation->current);
+			}
 
 			InterpolationStepX(interpolation, rasterInterpolants);
-			VPMT_FrameBufferStepX(fb);
-		} while (GL_TRUE);
-//  } else if (length < 0) {
-//      assert(GL_FALSE);
+
+			if (affine) {
+				AffineSegmentStep(&segment, rasterInterpolants);
+				--remaining;
+			}
+		}
+
+		if (earlyDepthStencil) {
+			VPMT_FragmentSpanColor(context, fb, count, colors, mask);
+		} else {
+			VPMT_FragmentSpan(context, fb, count, colors, depths, mask);
+		}
+
+		VPMT_FrameBufferMove(fb, count, 0);
+		x += count;
+		length -= count;
 	}
 }
 
-static void RasterTriangleScan(VPMT_Context * context, const VPMT_RasterVertex * a,
-							   const VPMT_RasterVertex * b, const VPMT_RasterVertex * c)
+/*
+** Rasterize length pixels of a row starting with the interpolation values
+** given, using the span function if there is one for the state. If advance
+** is set, the interpolation and the frame buffer position are moved past the
+** run, otherwise their values are undefined on return.
+*/
+static void RasterTriangleRun(VPMT_Context * context, Interpolation * interpolation,
+							  VPMT_FrameBuffer * fb, GLint x, GLsizei length, GLuint stipple,
+							  GLboolean depthPasses, GLboolean advance)
 {
 	GLuint rasterInterpolants = context->rasterInterpolants;
-	VPMT_FrameBuffer fb;
-	Interpolation interpolation;
-	Edge left, right, mid;
-	GLint y, startY, midY, endY;
-	GLboolean switchLeft;
-
-	/* clip rectangle - this test will become conditional */
-	GLint minX = context->activeSurfaceRect.origin[0];
-	GLint minY = context->activeSurfaceRect.origin[1];
-	GLint maxX = context->activeSurfaceRect.origin[0] + context->activeSurfaceRect.size.width;
-	GLint maxY = context->activeSurfaceRect.origin[1] + context->activeSurfaceRect.size.height;
-
-	GLint x1 = (a->screenCoords[0] + HALF) << VPMT_VIEWPORT_COORD_BITS;
-	GLint x2 = (b->screenCoords[0] + HALF) << VPMT_VIEWPORT_COORD_BITS;
-	GLint x3 = (c->screenCoords[0] + HALF) << VPMT_VIEWPORT_COORD_BITS;
-	GLint y1 = (a->screenCoords[1] + HALF) << VPMT_VIEWPORT_COORD_BITS;
-	GLint y2 = (b->screenCoords[1] + HALF) << VPMT_VIEWPORT_COORD_BITS;
-	GLint y3 = (c->screenCoords[1] + HALF) << VPMT_VIEWPORT_COORD_BITS;
-
-	if (y1 > y2) {
-		SWAP(y1, y2, GLint);
-		SWAP(x1, x2, GLint);
-	}
+	VPMT_RasterSpanFunc function = depthPasses ? context->rasterColorSpan : context->rasterSpan;
+
+	if (function) {
+		VPMT_Span span;
+
+		span.color = fb->current[0];
+		span.depthStencil = fb->current[1];
+		span.length = length;
+		span.depth = interpolation->current.depth;
+		span.depthDx = interpolation->dx.depth;
+		VPMT_Vec4Copy(span.rgba, interpolation->current.rgba);
+		VPMT_Vec4Copy(span.rgbaDx, interpolation->dx.rgba);
+		span.invW = interpolation->current.invW;
+		span.invWDx = interpolation->dx.invW;
+		VPMT_Vec2Copy(span.texCoords, interpolation->current.texCoordsOverW[0]);
+		VPMT_Vec2Copy(span.texCoordsDx, interpolation->dx.texCoordsOverW[0]);
+
+		if (rasterInterpolants & VPMT_RasterInterpolateRho0) {
+			span.rho = interpolation->current.rhoOverW2[0];
+			span.rhoDx = interpolation->dx.rhoOverW2[0];
+		} else {
+			span.rho = span.rhoDx = 0.0f;
+		}
 
-	if (y1 > y3) {
-		SWAP(y1, y3, GLint);
-		SWAP(x1, x3, GLint);
-	}
+		span.unit = context->texUnits;
+		span.x = x;
+		span.perspectiveSpan = interpolation->perspectiveSpan;
 
-	if (y2 > y3) {
-		SWAP(y2, y3, GLint);
-		SWAP(x2, x3, GLint);
-	}
+		function(&span);
 
-	startY = (y1 - 1) >> FRAC_BITS;
-	midY = (y2 - 1) >> FRAC_BITS;
-	endY = (y3 - 1) >> FRAC_BITS;
+		if (advance) {
+			GLsizei index;
 
-	/* y-culling */
-	if (startY >= maxY || endY <= minY || maxY <= minY) {
-		return;
-	}
+			for (index = 0; index < length; ++index) {
+				InterpolationStepX(interpolation, rasterInterpolants);
+			}
 
-	/* not enough y-extent */
-	if (endY == startY) {
-		return;
+			VPMT_FrameBufferMove(fb, length, 0);
+		}
+	} else {
+		RasterTriangleScanLine(context, interpolation, fb, x, length, stipple, depthPasses);
 	}
+}
 
-	if (midY != endY && midY < maxY) {
-		mid.delta = FixedDiv(x3 - x2, y3 - y2);
-		mid.x = x2 + FixedMul(mid.delta, (FRAC_ONE - (y2 & FRAC_MASK)) & FRAC_MASK);
-	}
+/*
+** Is the block containing column x marked in the bit mask kept? The pixels
+** of a marked block pass the depth test without accessing the depth buffer.
+*/
+static VPMT_INLINE GLboolean BlockKept(const GLuint * kept, GLint x)
+{
+	GLint block = x >> VPMT_HIZ_BLOCK_BITS;
 
-	if (midY == startY) {
-		midY = endY /* + 1 */ ;
-		left = mid;
-	} else {
-		left.delta = FixedDiv(x2 - x1, y2 - y1);
-		left.x = x1 + FixedMul(left.delta, (FRAC_ONE - (y1 & FRAC_MASK)) & FRAC_MASK);
-	}
+	return (kept[block >> 5] & (1u << (block & 31))) != 0;
+}
 
-	right.delta = FixedDiv(x3 - x1, y3 - y1);
-	right.x = x1 + FixedMul(right.delta, (FRAC_ONE - (y1 & FRAC_MASK)) & FRAC_MASK);
+/*
+** Depth at the center of pixel (x, y), stepped pixel by pixel from column
+** restart. Where a run of pixels starts depends on the blocks culled by the
+** hierarchical depth test, which differ between passes drawing the same
+** triangle; the depth values do not, as long as the restart column does not.
+*/
+static VPMT_INLINE GLfloat RowDepth(const Interpolation * origin, GLint restart, GLint x, GLint y)
+{
+	GLfloat depth = origin->current.depth;
 
-	if ((left.x > right.x) || (left.x == right.x) && (left.delta > right.delta)) {
-		SWAP(left, right, Edge);
-		switchLeft = GL_FALSE;
-	} else {
-		switchLeft = GL_TRUE;
+	/* same sequence of operations as InterpolationMove and InterpolationStepX */
+	depth += origin->dx.depth * (GLfloat) restart + origin->dy.depth * (GLfloat) y;
+
+	for (; restart < x; ++restart) {
+		depth += origin->dx.depth;
 	}
 
-	if (startY < minY) {
-		y = minY;
-		left.x += left.delta * (y - startY);
-		right.x += right.delta * (y - startY);
-	} else {
-		y = startY;
+	return depth;
+}
+
+/*
+** Rasterize the pixels [x, endX) of row y. The run is split at tile boundaries,
+** and interpolation restarts from the triangle origin for each piece. This way,
+** the fragments generated for a pixel do not depend on how the run has been
+** clipped, which allows the tiled rasterizer to reproduce the serial output.
+** Depth is interpolated from the start of the tile, or from the first pixel
+** of the row covered by the triangle, left, if that is further right; see
+** RowDepth. Within a piece, the pixels of the blocks marked in kept are
+** rasterized without depth test, continuing the interpolation of the piece.
+** The same applies to the surface tiles crossed by a piece in the tiled
+** layout.
+*/
+static void RasterTriangleSpan(VPMT_Context * context, const Interpolation * origin,
+							   VPMT_FrameBuffer * fb, GLint x, GLint endX, GLint y, GLint left,
+							   const GLuint * kept)
+{
+	GLuint rasterInterpolants = context->rasterInterpolants;
+	GLuint pattern = ~0u;
+
+	if (context->polygonStippleEnabled) {
+		GLuint offset = y % 32;
+		pattern =
+			(context->polygonStipple.bytes[offset] << 24) |
+			(context->polygonStipple.bytes[offset + 1] << 16) |
+			(context->polygonStipple.bytes[offset + 2] << 8) |
+			(context->polygonStipple.bytes[offset + 3]);
 	}
 
-	VPMT_FrameBufferInit(&fb, context->writeSurface);
-	VPMT_FrameBufferMove(&fb, 0, y);
+	do {
+		GLint end = VPMT_MIN(endX, (x | (VPMT_TILE_SIZE - 1)) + 1);
+		Interpolation interpolation = *origin;
 
-	InterpolationInit(&interpolation, a, b, c, context->texUnits, rasterInterpolants);
-	InterpolationMove(&interpolation, 0.5f - c->screenCoords[0] * PRECISION,
-					  0.5f - c->screenCoords[1] * PRECISION + y, rasterInterpolants);
+		VPMT_FrameBufferSave(fb);
+		VPMT_FrameBufferMove(fb, x, 0);
+		InterpolationMove(&interpolation, (GLfloat) x, (GLfloat) y, rasterInterpolants);
 
-	if (context->polygonOffsetFillEnabled) {
-		interpolation.current.depth +=
-			sqrtf(Square(interpolation.dx.depth) +
-				  Square(interpolation.dy.depth)) * context->polygonOffsetFactor;
+		if (rasterInterpolants & VPMT_RasterInterpolateDepth) {
+			GLint restart = VPMT_MAX(x & ~(VPMT_TILE_SIZE - 1), VPMT_MIN(left, x));
 
-		if (context->writeSurface) {
-			interpolation.current.depth += context->polygonOffsetUnit;
+			interpolation.current.depth = RowDepth(origin, restart, x, y);
+		}
+
+		while (x < end) {
+			GLuint stipple = context->polygonStippleEnabled ? RotateLeft(pattern, x % 32) : ~0u;
+			GLboolean depthPasses = kept && BlockKept(kept, x);
+			GLint stop = end;
+
+			if (kept) {
+				stop = x;
+
+				do {
+					stop = (stop | (VPMT_HIZ_BLOCK_SIZE - 1)) + 1;
+				} while (stop < end && BlockKept(kept, stop) == depthPasses);
+
+				stop = VPMT_MIN(stop, end);
+			}
+#if VPMT_TILED_SURFACE
+			stop = VPMT_MIN(stop, (x | VPMT_SURFACE_TILE_MASK) + 1);
+#endif
+			RasterTriangleRun(context, &interpolation, fb, x, stop - x, stipple, depthPasses,
+							  stop < end);
+			x = stop;
 		}
+
+		VPMT_FrameBufferRestore(fb);
+	} while (x < endX);
+}
+
+/*
+** -------------------------------------------------------------------------
+** Block-based halfspace rasterizer
+** -------------------------------------------------------------------------
+*/
+
+/* the coverage mask of a block row is 8 bits wide */
+#define BLOCK_BITS	3
+#define BLOCK_SIZE	(1 << BLOCK_BITS)
+
+#define BLOCK_EMPTY		0
+#define BLOCK_PARTIAL	1
+#define BLOCK_FULL		2
+
+/*
+** Per-triangle edge function increments. accept and reject are the offsets
+** from the center of the top-left pixel of a block to the pixel center in
+** the block with the smallest and largest edge function value. The fourth
+** lane is unused and always inside.
+*/
+typedef struct BlockEdges {
+	VPMT_Vec4i dx, dy;
+	VPMT_Vec4i stepX, stepY;
+	VPMT_Vec4i accept, reject;
+#if defined(VPMT_SSE2)
+	__m128i low[3], high[3];							   /* pixels 0-3 and 4-7 of a row */
+#endif
+} BlockEdges;
+
+static void SetupBlockEdges(BlockEdges * edges, const RasterVariables * vars)
+{
+	GLsizei index;
+
+	for (index = 0; index < 3; ++index) {
+		GLint dx = vars->equ_dx[index], dy = vars->equ_dy[index];
+		GLint cornerX = dx * (BLOCK_SIZE - 1), cornerY = dy * (BLOCK_SIZE - 1);
+
+		edges->dx[index] = dx;
+		edges->dy[index] = dy;
+		edges->stepX[index] = dx * BLOCK_SIZE;
+		edges->stepY[index] = dy * BLOCK_SIZE;
+		edges->accept[index] = VPMT_MIN(cornerX, 0) + VPMT_MIN(cornerY, 0);
+		edges->reject[index] = VPMT_MAX(cornerX, 0) + VPMT_MAX(cornerY, 0);
+
+#if defined(VPMT_SSE2)
+		edges->low[index] = _mm_setr_epi32(0, dx, 2 * dx, 3 * dx);
+		edges->high[index] = _mm_setr_epi32(4 * dx, 5 * dx, 6 * dx, 7 * dx);
+#endif
 	}
 
-	/* clip */
-	if (endY >= maxY) {
-		endY = maxY;
+	edges->dx[3] = edges->dy[3] = edges->stepX[3] = edges->stepY[3] = 0;
+	edges->accept[3] = edges->reject[3] = 0;
+}
+
+/*
+** Classify a block given the edge function values at its top-left pixel.
+*/
+static VPMT_INLINE GLuint ClassifyBlock(const BlockEdges * edges, const VPMT_Vec4i equ)
+{
+#if defined(VPMT_SSE2)
+	__m128i value = _mm_loadu_si128((const __m128i *) equ);
+	__m128i zero = _mm_setzero_si128();
+	__m128i reject = _mm_add_epi32(value, _mm_loadu_si128((const __m128i *) edges->reject));
+	__m128i accept = _mm_add_epi32(value, _mm_loadu_si128((const __m128i *) edges->accept));
+
+	if (_mm_movemask_epi8(_mm_cmpgt_epi32(reject, zero)) != 0xffff) {
+		return BLOCK_EMPTY;
 	}
 
-	if (y >= midY) {
-		if (switchLeft) {
-			left = mid;
-			left.x += left.delta * (y - midY);
-		} else {
-			right = mid;
-			right.x += right.delta * (y - midY);
+	return _mm_movemask_epi8(_mm_cmpgt_epi32(accept, zero)) == 0xffff ? BLOCK_FULL : BLOCK_PARTIAL;
+#else
+	if (equ[0] + edges->reject[0] <= 0 || equ[1] + edges->reject[1] <= 0 ||
+		equ[2] + edges->reject[2] <= 0) {
+		return BLOCK_EMPTY;
+	}
+
+	return (equ[0] + edges->accept[0] > 0 && equ[1] + edges->accept[1] > 0 &&
+			equ[2] + edges->accept[2] > 0) ? BLOCK_FULL : BLOCK_PARTIAL;
+#endif
+}
+
+/*
+** Determine the coverage mask of a block row given the edge function values at
+** its first pixel. Bit i corresponds to pixel i of the row.
+*/
+static VPMT_INLINE GLuint BlockRowMask(const BlockEdges * edges, const VPMT_Vec4i equ)
+{
+#if defined(VPMT_SSE2)
+	__m128i zero = _mm_setzero_si128();
+	__m128i e0 = _mm_set1_epi32(equ[0]);
+	__m128i e1 = _mm_set1_epi32(equ[1]);
+	__m128i e2 = _mm_set1_epi32(equ[2]);
+
+	__m128i low =
+		_mm_and_si128(_mm_and_si128(_mm_cmpgt_epi32(_mm_add_epi32(e0, edges->low[0]), zero),
+									_mm_cmpgt_epi32(_mm_add_epi32(e1, edges->low[1]), zero)),
+					  _mm_cmpgt_epi32(_mm_add_epi32(e2, edges->low[2]), zero));
+	__m128i high =
+		_mm_and_si128(_mm_and_si128(_mm_cmpgt_epi32(_mm_add_epi32(e0, edges->high[0]), zero),
+									_mm_cmpgt_epi32(_mm_add_epi32(e1, edges->high[1]), zero)),
+					  _mm_cmpgt_epi32(_mm_add_epi32(e2, edges->high[2]), zero));
+
+	return _mm_movemask_epi8(_mm_packs_epi16(_mm_packs_epi32(low, high), zero));
+#else
+	GLint e0 = equ[0], e1 = equ[1], e2 = equ[2];
+	GLuint mask = 0, bit;
+
+	for (bit = 1; bit < (1u << BLOCK_SIZE); bit <<= 1) {
+		if (e0 > 0 && e1 > 0 && e2 > 0) {
+			mask |= bit;
 		}
 
-		goto part2;
+		e0 += edges->dx[0];
+		e1 += edges->dx[1];
+		e2 += edges->dx[2];
 	}
 
-	if (midY >= maxY) {
-		midY = maxY;
-	}
+	return mask;
+#endif
+}
 
-	for (;;) {
-		GLint leftBoundary = left.x >> FRAC_BITS;
-		GLint rightBoundary = right.x >> FRAC_BITS;
-		GLint width;
-		GLuint stipple;
-
-		/* clipping - will be conditional */
-		leftBoundary = leftBoundary < minX ? minX : leftBoundary;
-		rightBoundary = rightBoundary >= maxX ? maxX : rightBoundary;
-
-		if ((width = rightBoundary - leftBoundary) > 0) {
-			VPMT_FrameBufferSave(&fb);
-			VPMT_FrameBufferMove(&fb, leftBoundary, 0);
-			InterpolationSave(&interpolation, rasterInterpolants);
-			InterpolationMove(&interpolation, (GLfloat) leftBoundary, 0, rasterInterpolants);
-
-			if (context->polygonStippleEnabled) {
-				GLuint offset = y % 32;
-				stipple =
-					(context->polygonStipple.bytes[offset] << 24) |
-					(context->polygonStipple.bytes[offset + 1] << 16) |
-					(context->polygonStipple.bytes[offset + 2] << 8) |
-					(context->polygonStipple.bytes[offset + 3]);
-
-				stipple = RotateLeft(stipple, leftBoundary % 32);
-			} else {
-				stipple = ~0u;
-			}
+/*
+** Add the runs of covered pixels in mask, relative to x, to the pending span
+** [span[0], span[1]) of row y, whose first covered pixel is left. A run that
+** does not continue the pending span causes the pending span to be rasterized
+** first.
+*/
+static void BlockRowSpans(VPMT_Context * context, const Interpolation * origin,
+						  VPMT_FrameBuffer * fb, GLint span[2], GLint x, GLint y, GLint left,
+						  GLuint mask, const GLuint * kept)
+{
+	while (mask) {
+		GLint start = 0, end;
 
-			RasterTriangleScanLine(context, &interpolation, &fb, width, stipple);
-			VPMT_FrameBufferRestore(&fb);
-			InterpolationRestore(&interpolation, rasterInterpolants);
+		while (!(mask & (1u << start))) {
+			++start;
 		}
 
-		left.x += left.delta;
-		right.x += right.delta;
+		for (end = start; mask & (1u << end); ++end) ;
+
+		mask &= ~0u << end;
 
-		/* y is incremented here! */
-		if (++y == midY) {
-			break;
+		if (span[1] != x + start) {
+			if (span[1] > span[0]) {
+				RasterTriangleSpan(context, origin, fb, span[0], span[1], y, left, kept);
+			}
+
+			span[0] = x + start;
 		}
 
-		VPMT_FrameBufferStepY(&fb);
-		InterpolationStepY(&interpolation, rasterInterpolants);
+		span[1] = x + end;
+	}
+}
+
+/*
+** First column of row y covered by the triangle. Only the edges whose
+** function values increase to the right bound the row on the left. Unlike
+** the runs of pixels passed to RasterTriangleSpan, the result depends
+** neither on the clip rectangle nor on the blocks culled.
+*/
+static GLint RowLeft(const RasterVariables * vars, GLint y)
+{
+	GLint left = 0, index;
+
+	for (index = 0; index < 3; ++index) {
+		GLint dx = vars->equ_dx[index];
+
+		if (dx > 0) {
+			GLint equ = vars->equ[index] + (y - vars->miny) * vars->equ_dy[index];
+
+			/* smallest offset with a positive edge function value */
+			GLint offset = equ > 0 ? -((equ - 1) / dx) : -equ / dx + 1;
+
+			left = VPMT_MAX(left, offset);
+		}
 	}
 
-	if (midY == endY) {
+	return vars->minx + left;
+}
+
+/*
+** Smallest and largest depth of the triangle plane over the pixel centers of
+** a rectangle, widened by the rounding error of the span interpolation.
+*/
+static VPMT_INLINE GLfloat PlaneMinDepth(const Interpolation * origin, GLfloat slack, GLint x,
+										 GLint y, GLsizei width, GLsizei height)
+{
+	GLfloat dx = origin->dx.depth * (width - 1), dy = origin->dy.depth * (height - 1);
+
+	return origin->current.depth + origin->dx.depth * x + origin->dy.depth * y +
+		VPMT_MIN(dx, 0.0f) + VPMT_MIN(dy, 0.0f) - slack;
+}
+
+static VPMT_INLINE GLfloat PlaneMaxDepth(const Interpolation * origin, GLfloat slack, GLint x,
+										 GLint y, GLsizei width, GLsizei height)
+{
+	GLfloat dx = origin->dx.depth * (width - 1), dy = origin->dy.depth * (height - 1);
+
+	return origin->current.depth + origin->dx.depth * x + origin->dy.depth * y +
+		VPMT_MAX(dx, 0.0f) + VPMT_MAX(dy, 0.0f) + slack;
+}
+
+/*
+** Smallest depth of a compressed block at (x, y)
+*/
+static VPMT_INLINE GLfloat BlockMinDepth(const VPMT_DepthPlane * plane, GLfloat slack, GLint x,
+										 GLint y)
+{
+	GLfloat dx = plane->dx * (BLOCK_SIZE - 1), dy = plane->dy * (BLOCK_SIZE - 1);
+
+	return plane->depth + plane->dx * x + plane->dy * y +
+		VPMT_MIN(dx, 0.0f) + VPMT_MIN(dy, 0.0f) - slack;
+}
+
+/*
+** Rasterize a triangle by walking its bounding rectangle in blocks of
+** BLOCK_SIZE x BLOCK_SIZE pixels. Blocks that are entirely outside of one of
+** the edges are skipped, blocks that are entirely inside of all edges are
+** filled without per-pixel tests. The resulting runs of pixels are handed to
+** RasterTriangleSpan, which keeps the output identical to the tiled rasterizer.
+** Blocks whose stored depth values are all nearer than the triangle are
+** skipped based on the hierarchical depth bounds of the surface. A triangle
+** that covers a compressed depth block and is nearer than all of its depth
+** values replaces the plane of the block; the pixels of such a block are
+** rasterized without depth test.
+*/
+static void RasterTriangleBlock(VPMT_Context * context, const VPMT_RasterVertex * a,
+								const VPMT_RasterVertex * b, const VPMT_RasterVertex * c)
+{
+	RasterVariables vars;
+	BlockEdges edges;
+	Interpolation origin;
+	VPMT_FrameBuffer fb;
+	VPMT_Vec4i rowEqu;
+	GLint minX, minY, maxX, maxY, startX, bx, by, row;
+	GLuint hiZMode = context->hiZMode;
+	GLboolean depthPlanes;
+	GLuint kept[(VPMT_MAX_VIEWPORT_WIDTH >> BLOCK_BITS) / 32];
+	GLfloat slack;
+
+	SetupTriangleRasterVariables(&vars, a, b, c);
+
+	minX = VPMT_MAX(vars.minx, context->activeSurfaceRect.origin[0]);
+	minY = VPMT_MAX(vars.miny, context->activeSurfaceRect.origin[1]);
+	maxX =
+		VPMT_MIN(vars.maxx,
+				 context->activeSurfaceRect.origin[0] + context->activeSurfaceRect.size.width);
+	maxY =
+		VPMT_MIN(vars.maxy,
+				 context->activeSurfaceRect.origin[1] + context->activeSurfaceRect.size.height);
+
+	if (minX >= maxX || minY >= maxY) {
 		return;
 	}
 
-	/* tail increments from previous loop */
-	VPMT_FrameBufferStepY(&fb);
-	InterpolationStepY(&interpolation, rasterInterpolants);
+	InterpolationInitOrigin(context, &origin, a, b, c);
+	depthPlanes = context->writeSurface->depthPlanes.blocks != NULL;
 
-	if (switchLeft) {
-		left = mid;
-	} else {
-		right = mid;
+	if (!(context->rasterInterpolants & VPMT_RasterInterpolateDepth)) {
+		hiZMode = 0;
 	}
 
-  part2:
-	for (;;) {
-		GLint leftBoundary = left.x >> FRAC_BITS;
-		GLint rightBoundary = right.x >> FRAC_BITS;
-		GLint width;
-		GLuint stipple;
-
-		/* clipping - will be conditional */
-		leftBoundary = leftBoundary < minX ? minX : leftBoundary;
-		rightBoundary = rightBoundary >= maxX ? maxX : rightBoundary;
-
-		if ((width = rightBoundary - leftBoundary) > 0) {
-			VPMT_FrameBufferSave(&fb);
-			VPMT_FrameBufferMove(&fb, leftBoundary, 0);
-			InterpolationSave(&interpolation, rasterInterpolants);
-			InterpolationMove(&interpolation, (GLfloat) leftBoundary, 0, rasterInterpolants);
-
-			if (context->polygonStippleEnabled) {
-				GLuint offset = y % 32;
-				stipple =
-					(context->polygonStipple.bytes[offset] << 24) |
-					(context->polygonStipple.bytes[offset + 1] << 16) |
-					(context->polygonStipple.bytes[offset + 2] << 8) |
-					(context->polygonStipple.bytes[offset + 3]);
-
-				stipple = RotateLeft(stipple, leftBoundary % 32);
-			} else {
-				stipple = ~0u;
+	/* span depth values are accumulated in single precision */
+	slack = 1.0f + context->depthFixedPointScale * (1.0f / 65536.0f);
+
+	if (hiZMode) {
+		VPMT_Rect rect;
+
+		rect.origin[0] = minX;
+		rect.origin[1] = minY;
+		rect.size.width = maxX - minX;
+		rect.size.height = maxY - minY;
+
+		if (VPMT_HiZOccluded(context->writeSurface, hiZMode,
+							 VPMT_HiZDepth(PlaneMinDepth(&origin, slack, minX, minY,
+														 rect.size.width, rect.size.height)),
+							 &rect)) {
+			return;
+		}
+	}
+
+	SetupBlockEdges(&edges, &vars);
+
+	/* blocks are aligned to the surface origin */
+	startX = minX & ~(BLOCK_SIZE - 1);
+	by = minY & ~(BLOCK_SIZE - 1);
+
+	/* edge function values at the top-left pixel of the first block */
+	rowEqu[0] = vars.equ[0] + (startX - vars.minx) * edges.dx[0] + (by - vars.miny) * edges.dy[0];
+	rowEqu[1] = vars.equ[1] + (startX - vars.minx) * edges.dx[1] + (by - vars.miny) * edges.dy[1];
+	rowEqu[2] = vars.equ[2] + (startX - vars.minx) * edges.dx[2] + (by - vars.miny) * edges.dy[2];
+	rowEqu[3] = 1;
+
+	VPMT_FrameBufferInit(&fb, context->writeSurface);
+	VPMT_FrameBufferMove(&fb, 0, minY);
+
+	for (; by < maxY; by += BLOCK_SIZE) {
+		GLint spans[BLOCK_SIZE][2], left[BLOCK_SIZE];
+		GLint startRow = VPMT_MAX(by, minY) - by;
+		GLint endRow = VPMT_MIN(by + BLOCK_SIZE, maxY) - by;
+		GLboolean anyKept = GL_FALSE;
+		VPMT_Vec4i blockEqu;
+
+		if (context->depthPlaneMode) {
+			memset(kept, 0, sizeof(kept));
+		}
+
+		for (row = startRow; row < endRow; ++row) {
+			spans[row][0] = spans[row][1] = 0;
+			left[row] = RowLeft(&vars, by + row);
+		}
+
+		VPMT_Vec4Copy(blockEqu, rowEqu);
+
+		for (bx = startX; bx < maxX; bx += BLOCK_SIZE) {
+			GLuint coverage = ClassifyBlock(&edges, blockEqu);
+			GLuint *farthest = NULL;
+
+			if (coverage != BLOCK_EMPTY && hiZMode) {
+				farthest = VPMT_HiZBlock(context->writeSurface, bx, by);
+
+				if (VPMT_HiZReject(hiZMode,
+								   VPMT_HiZDepth(PlaneMinDepth(&origin, slack, bx, by,
+															   BLOCK_SIZE, BLOCK_SIZE)),
+								   *farthest)) {
+					coverage = BLOCK_EMPTY;
+				}
 			}
 
-			RasterTriangleScanLine(context, &interpolation, &fb, width, stipple);
-			VPMT_FrameBufferRestore(&fb);
-			InterpolationRestore(&interpolation, rasterInterpolants);
+			if (coverage != BLOCK_EMPTY) {
+				/* restrict the block to the columns inside the clip rectangle */
+				GLuint clipMask =
+					((1u << (VPMT_MIN(maxX - bx, BLOCK_SIZE))) - 1) &
+					(~0u << VPMT_MAX(minX - bx, 0));
+				GLboolean whole = coverage == BLOCK_FULL && clipMask == (1u << BLOCK_SIZE) - 1 &&
+					startRow == 0 && endRow == BLOCK_SIZE;
+				VPMT_DepthPlane *plane =
+					depthPlanes ? VPMT_ZPlaneBlock(context->writeSurface, bx, by) : NULL;
+				VPMT_Vec4i equ;
+
+				if (plane && plane->compressed) {
+					if (context->depthPlaneMode && whole &&
+						PlaneMaxDepth(&origin, slack, bx, by, BLOCK_SIZE, BLOCK_SIZE) <
+						BlockMinDepth(plane, slack, bx, by)) {
+						anyKept = GL_TRUE;
+						kept[bx >> (BLOCK_BITS + 5)] |= 1u << ((bx >> BLOCK_BITS) & 31);
+						plane->depth = origin.current.depth;
+						plane->dx = origin.dx.depth;
+						plane->dy = origin.dy.depth;
+
+						for (row = 0; row < BLOCK_SIZE; ++row) {
+							plane->start[row] =
+								(GLubyte) (bx - VPMT_MAX(bx & ~(VPMT_TILE_SIZE - 1), left[row]));
+						}
+					} else {
+						VPMT_ZPlaneDecompress(context->writeSurface, bx, by);
+						plane = NULL;
+					}
+				} else {
+					plane = NULL;
+				}
+
+				VPMT_Vec4ScaleAdd(equ, edges.dy, startRow, blockEqu);
+
+				for (row = startRow; row < endRow; ++row) {
+					GLuint mask = clipMask;
+
+					if (coverage == BLOCK_PARTIAL) {
+						mask &= BlockRowMask(&edges, equ);
+						VPMT_Vec4Add(equ, equ, edges.dy);
+					}
+
+					BlockRowSpans(context, &origin, &fb, spans[row], bx, by + row, left[row],
+								  mask, anyKept ? kept : NULL);
+					VPMT_FrameBufferStepY(&fb);
+				}
+
+				VPMT_FrameBufferMove(&fb, 0, startRow - endRow);
+
+				/* every pixel of the block is written or keeps a nearer value */
+				if ((hiZMode & VPMT_HIZ_UPDATE) && whole) {
+					GLfloat minDepth =
+						PlaneMinDepth(&origin, slack, bx, by, BLOCK_SIZE, BLOCK_SIZE);
+					GLuint maxDepth =
+						VPMT_HiZDepth(PlaneMaxDepth(&origin, slack, bx, by, BLOCK_SIZE,
+													BLOCK_SIZE));
+
+					if (minDepth >= 0.0f && maxDepth < farthest[0]) {
+						farthest[0] = maxDepth;
+					}
+				}
+			}
+
+			VPMT_Vec4Add(blockEqu, blockEqu, edges.stepX);
 		}
 
-		left.x += left.delta;
-		right.x += right.delta;
+		/* rasterize the spans still pending at the end of the block row */
+		for (row = startRow; row < endRow; ++row) {
+			if (spans[row][1] > spans[row][0]) {
+				RasterTriangleSpan(context, &origin, &fb, spans[row][0], spans[row][1], by + row,
+								   left[row], anyKept ? kept : NULL);
+			}
 
-		/* y is incremented here! */
-		if (++y == endY) {
-			return;
+			VPMT_FrameBufferStepY(&fb);
 		}
 
-		VPMT_FrameBufferStepY(&fb);
-		InterpolationStepY(&interpolation, rasterInterpolants);
+		VPMT_Vec4Add(rowEqu, rowEqu, edges.stepY);
 	}
 }
 
 void VPMT_RasterPrepareTriangle(VPMT_Context * context)
 {
+	GLboolean hasEnabledColor =
+		(context->redBits && context->colorWriteMask[0]) ||
+		(context->greenBits && context->colorWriteMask[1]) ||
+		(context->blueBits && context->colorWriteMask[2]) ||
+		(context->alphaBits && context->colorWriteMask[3]);
+
 	VPMT_RasterPrepareInterpolants(context);
-	//context->rasterTriangle = RasterTriangle;
-	context->rasterTriangle = RasterTriangleScan;
+
+	/*
+	** Without color writes the fragment color is only needed for the alpha
+	** test; otherwise, only depth is interpolated and fragments are never shaded.
+	*/
+	context->rasterDepthOnly = !hasEnabledColor && !context->alphaTestEnabled;
+
+	if (context->rasterDepthOnly) {
+		context->rasterInterpolants &= VPMT_RasterInterpolateDepth;
+	}
+
+	context->rasterSpan = VPMT_SpanGetFunction(context);
+
+	context->rasterTriangle = RasterTriangleBlock;
 }
 
 static VPMT_INLINE GLboolean Inside3(const VPMT_Vec3i values)
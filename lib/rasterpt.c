@@ -33,6 +33,9 @@ static void RasterPointAliased(VPMT_Context * context, const VPMT_RasterVertex *
 	GLuint size = context->integerPointSize;
 	GLuint depth = (GLuint) a->depth;
 	VPMT_FrameBuffer fb;
+	VPMT_Color4ub colors[VPMT_FRAGMENT_SPAN_SIZE];
+	GLuint depths[VPMT_FRAGMENT_SPAN_SIZE];
+	GLsizei count;
 
 	/* 1. determine the center, xmin, max, ymin, ymax */
 	if (size & 1) {
@@ -77,13 +80,19 @@ static void RasterPointAliased(VPMT_Context * context, const VPMT_RasterVertex *
 	VPMT_FrameBufferInit(&fb, context->writeSurface);
 	VPMT_FrameBufferMove(&fb, xmin, ymin);
 
+	for (x = 0; x < VPMT_FRAGMENT_SPAN_SIZE; ++x) {
+		colors[x] = rgba;
+		depths[x] = depth;
+	}
+
 	/* 3. Generate fragment for each (xmin, ymin) <= (x, y) < (xmax, ymax) */
 	for (y = ymin; y < ymax; ++y) {
 		VPMT_FrameBufferSave(&fb);
 
-		for (x = xmin; x < xmax; ++x) {
-			VPMT_Fragment(context, &fb, rgba, depth);
-			VPMT_FrameBufferStepX(&fb);
+		for (x = xmin; x < xmax; x += count) {
+			count = VPMT_MIN(xmax - x, VPMT_FRAGMENT_SPAN_SIZE);
+			VPMT_FragmentSpan(context, &fb, count, colors, depths, ~0u);
+			VPMT_FrameBufferMove(&fb, count, 0);
 		}
 
 		VPMT_FrameBufferRestore(&fb);
@@ -118,6 +127,9 @@ static void RasterPointAA(VPMT_Context * context, const VPMT_RasterVertex * a)
 	GLubyte alpha;
 	GLuint depth = (GLuint) a->depth;
 	VPMT_FrameBuffer fb;
+	VPMT_Color4ub colors[VPMT_FRAGMENT_SPAN_SIZE];
+	GLuint depths[VPMT_FRAGMENT_SPAN_SIZE];
+	GLsizei count, index;
 
 	/* 1. determine the center, xmin, max, ymin, ymax */
 	xctr = a->screenCoords[0];
@@ -153,20 +165,32 @@ static void RasterPointAA(VPMT_Context * context, const VPMT_RasterVertex * a)
 	VPMT_FrameBufferInit(&fb, context->writeSurface);
 	VPMT_FrameBufferMove(&fb, xmin, ymin);
 
+	for (x = 0; x < VPMT_FRAGMENT_SPAN_SIZE; ++x) {
+		colors[x] = rgba;
+		depths[x] = depth;
+	}
+
 	/* 3. Generate fragment for each (xmin, ymin) <= (x, y) < (xmax, ymax) */
 	for (y = ymin; y < ymax; ++y, ybase += ONE) {
 		VPMT_FrameBufferSave(&fb);
 		xbase1 = xbase0;
 
-		for (x = xmin; x < xmax; ++x, xbase1 += ONE) {
-			GLuint coverage = PointCoverage(xbase1, ybase, sqrPointSize);
+		for (x = xmin; x < xmax; x += count) {
+			GLuint mask = 0;
+
+			count = VPMT_MIN(xmax - x, VPMT_FRAGMENT_SPAN_SIZE);
+
+			for (index = 0; index < count; ++index, xbase1 += ONE) {
+				GLuint coverage = PointCoverage(xbase1, ybase, sqrPointSize);
 
-			if (coverage > 0.0f) {
-				rgba.alpha = (coverage * alpha) >> 8;
-				VPMT_Fragment(context, &fb, rgba, depth);
+				if (coverage > 0.0f) {
+					colors[index].alpha = (coverage * alpha) >> 8;
+					mask |= 1u << index;
+				}
 			}
 
-			VPMT_FrameBufferStepX(&fb);
+			VPMT_FragmentSpan(context, &fb, count, colors, depths, mask);
+			VPMT_FrameBufferMove(&fb, count, 0);
 		}
 
 		VPMT_FrameBufferRestore(&fb);
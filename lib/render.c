@@ -14,6 +14,11 @@
 #include "GL/gl.h"
 #include "context.h"
 #include "raster.h"
+#include "tile.h"
+#include "clear.h"
+#include "hiz.h"
+#include "zplane.h"
+#include "vertex.h"
 
 /*
 ** -------------------------------------------------------------------------
@@ -118,6 +123,17 @@ void VPMT_ExecBegin(VPMT_Context * context, GLenum mode)
 
 	SetTransform(context);
 
+	/* vertices are transformed in batches, see VPMT_VertexBatchFlush */
+	context->transformFunction = VPMT_VertexBatchFetch;
+	context->vertexBatch.count = 0;
+	context->vertexBatch.coordScale = 1.0f;
+	context->vertexBatch.normalScale = 1.0f;
+
+	for (index = 0; index < VPMT_MAX_TEX_UNITS; ++index) {
+		context->vertexBatch.texCoordScale[index] = 1.0f;
+		context->vertexBatch.texCoordBias[index] = 0.0f;
+	}
+
 	for (index = 0; index < VPMT_MAX_TEX_UNITS; ++index) {
 		if (context->texture2DEnabledMask & (1u << index)) {
 			VPMT_Texture2DValidate(context->texUnits[index].boundTexture);
@@ -134,6 +150,10 @@ void VPMT_ExecBegin(VPMT_Context * context, GLenum mode)
 
 	if (prepareRasterizer) {
 		prepareRasterizer(context);
+		VPMT_TilePrepare(context);
+		VPMT_ClearPrepare(context);
+		VPMT_HiZPrepare(context);
+		VPMT_ZPlanePrepare(context);
 	}
 }
 
@@ -200,6 +220,8 @@ void VPMT_ExecEnd(VPMT_Context * context)
 		return;
 	}
 
+	VPMT_VertexBatchFlush(context);
+
 	if (context->endFunction) {
 		context->endFunction(context);
 	}
@@ -210,6 +232,9 @@ void VPMT_ExecEnd(VPMT_Context * context)
 	context->vertexFunction = NULL;
 	context->primitiveType = -1;
 
+	/* binned primitives need to be rasterized while the surface is still locked */
+	VPMT_TileFlush(context);
+
 	if (context->writeSurface) {
 		context->writeSurface->vtbl->unlock(context, context->writeSurface);
 	}
@@ -217,12 +242,12 @@ void VPMT_ExecEnd(VPMT_Context * context)
 
 void VPMT_ExecFinish(VPMT_Context * context)
 {
-	/* NOP */
+	VPMT_TileFlush(context);
 }
 
 void VPMT_ExecFlush(VPMT_Context * context)
 {
-	/* NOP */
+	VPMT_TileFlush(context);
 }
 
 void VPMT_ExecFrontFace(VPMT_Context * context, GLenum mode)
@@ -308,7 +333,7 @@ void VPMT_ExecVertex2f(VPMT_Context * context, GLfloat x, GLfloat y)
 		context->vertex[1] = y;
 		context->vertex[2] = 0.0f;
 
-		context->vertexFunction(context);
+		VPMT_VertexBatchAdd(context);
 	}
 }
 
@@ -324,7 +349,7 @@ void VPMT_ExecVertex2fv(VPMT_Context * context, const GLfloat * v)
 		context->vertex[1] = v[1];
 		context->vertex[2] = 0.0f;
 
-		context->vertexFunction(context);
+		VPMT_VertexBatchAdd(context);
 	}
 }
 
@@ -335,7 +360,7 @@ void VPMT_ExecVertex3f(VPMT_Context * context, GLfloat x, GLfloat y, GLfloat z)
 		context->vertex[1] = y;
 		context->vertex[2] = z;
 
-		context->vertexFunction(context);
+		VPMT_VertexBatchAdd(context);
 	}
 }
 
@@ -348,7 +373,7 @@ void VPMT_ExecVertex3fv(VPMT_Context * context, const GLfloat * v)
 
 	if (context->renderMode != GL_INVALID_MODE) {
 		VPMT_Vec3Copy(context->vertex, v);
-		context->vertexFunction(context);
+		VPMT_VertexBatchAdd(context);
 	}
 }
 
@@ -539,6 +564,129 @@ static void VertexTriangleFan(VPMT_Context * context)
 	}
 }
 
+/*
+** Vertex n of a primitive assembled from an array of transformed vertices.
+*/
+static VPMT_INLINE VPMT_Vertex *ElementVertex(VPMT_Vertex * vertices, GLenum type,
+											  const GLvoid * indices, GLuint base, GLsizei n)
+{
+	if (!indices) {
+		return vertices + n;
+	}
+
+	switch (type) {
+	case GL_UNSIGNED_BYTE:
+		return vertices + (((const GLubyte *) indices)[n] - base);
+
+	case GL_UNSIGNED_SHORT:
+		return vertices + (((const GLushort *) indices)[n] - base);
+
+	default:
+		return vertices + (((const GLuint *) indices)[n] - base);
+	}
+}
+
+/*
+** Assemble the primitives of the current begin/end block from count
+** transformed vertices, bypassing the vertex queue. If indices is NULL, the
+** vertices are used in order, otherwise indices of the given type select
+** vertices[index - base].
+*/
+void VPMT_RenderVertices(VPMT_Context * context, VPMT_Vertex * vertices, GLsizei count,
+						 GLenum type, const GLvoid * indices, GLuint base)
+{
+	GLsizei n;
+
+	switch (context->renderMode) {
+	case GL_POINTS:
+		for (n = 0; n < count; ++n) {
+			DrawPoint(context, ElementVertex(vertices, type, indices, base, n));
+		}
+
+		break;
+
+	case GL_LINES:
+		for (n = 1; n < count; n += 2) {
+			VPMT_LineStippleReset(context);
+			DrawLine(context, ElementVertex(vertices, type, indices, base, n - 1),
+					 ElementVertex(vertices, type, indices, base, n));
+		}
+
+		break;
+
+	case GL_LINE_STRIP:
+	case GL_LINE_LOOP:
+		for (n = 1; n < count; ++n) {
+			DrawLine(context, ElementVertex(vertices, type, indices, base, n - 1),
+					 ElementVertex(vertices, type, indices, base, n));
+		}
+
+		if (context->renderMode == GL_LINE_LOOP && count >= 3) {
+			DrawLine(context, ElementVertex(vertices, type, indices, base, count - 1),
+					 ElementVertex(vertices, type, indices, base, 0));
+		}
+
+		break;
+
+	case GL_TRIANGLES:
+		for (n = 2; n < count; n += 3) {
+			DrawTriangle(context, ElementVertex(vertices, type, indices, base, n - 2),
+						 ElementVertex(vertices, type, indices, base, n - 1),
+						 ElementVertex(vertices, type, indices, base, n));
+		}
+
+		break;
+
+	case GL_TRIANGLE_STRIP:
+		for (n = 2; n < count; ++n) {
+			/* orientation alternates between even and odd triangles */
+			VPMT_Vertex *a = ElementVertex(vertices, type, indices, base, n - 2);
+			VPMT_Vertex *b = ElementVertex(vertices, type, indices, base, n - 1);
+
+			if (n & 1) {
+				DrawTriangle(context, b, a, ElementVertex(vertices, type, indices, base, n));
+			} else {
+				DrawTriangle(context, a, b, ElementVertex(vertices, type, indices, base, n));
+			}
+		}
+
+		break;
+
+	case GL_TRIANGLE_FAN:
+		for (n = 2; n < count; ++n) {
+			DrawTriangle(context, ElementVertex(vertices, type, indices, base, 0),
+						 ElementVertex(vertices, type, indices, base, n - 1),
+						 ElementVertex(vertices, type, indices, base, n));
+		}
+
+		break;
+
+	default:
+		assert(GL_FALSE);
+	}
+}
+
+/*
+** Complete the primitive in progress and start a new one of the same mode,
+** as if the current begin/end block were ended and begun again, but keeping
+** the surface locked and the rasterizer prepared.
+*/
+void VPMT_RenderRestart(VPMT_Context * context)
+{
+	VPMT_VertexBatchFlush(context);
+
+	if (context->endFunction) {
+		context->endFunction(context);
+	}
+
+	context->primitiveState = 0;
+	context->nextIndex = 0;
+
+	if (context->primitiveType == GL_LINES) {
+		VPMT_LineStippleReset(context);
+	}
+}
+
 /*
 ** --------------------------------------------------------------------------
 ** Rendring functions
@@ -0,0 +1,518 @@
+/*
+** -------------------------------------------------------------------------
+** Vincent SC 1.0 Rendering Library
+**
+** Specialized span functions
+**
+** Copyright (C) 2008 Vincent Pervasive Media Technologies, LLC. 
+**
+** Licensed under the Artistic License 2.0.
+** -------------------------------------------------------------------------
+*/
+
+#include "common.h"
+#include "GL/gl.h"
+#include "context.h"
+#include "raster.h"
+#include "frame.h"
+#include "span.h"
+
+/*
+** -------------------------------------------------------------------------
+** State dimensions covered by the specialized span functions. Each function
+** is an instance of the generic span loop below with all state parameters
+** being compile-time constants, so that the compiler can remove the state
+** dependent branches and inline the framebuffer access.
+** -------------------------------------------------------------------------
+*/
+
+enum {
+	ShadeNone,												   /* no color write */
+	ShadeGouraud,											   /* interpolated color */
+	ShadeFlat,												   /* constant color */
+	ShadeModulate,											   /* unit 0 GL_MODULATE */
+	ShadeReplace											   /* unit 0 GL_REPLACE, RGBA texture */
+};
+
+enum {
+	DepthNone,												   /* no depth test or write */
+	Depth16,												   /* GL_LEQUAL, VPMT_DEPTH_16 */
+	Depth24Stencil8,										   /* GL_LEQUAL, VPMT_DEPTH_24_STENCIL_8 */
+	Depth32													   /* GL_LEQUAL, VPMT_DEPTH_32 */
+};
+
+enum {
+	BlendNone,												   /* GL_ONE, GL_ZERO */
+	BlendSrcAlpha											   /* GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA */
+};
+
+enum {
+	ColorNone,
+	Color565,
+	Color5551,
+	Color4444,
+	Color8888,
+	Color8888_REV
+};
+
+#define SPAN_KEY(shade, depth, blend, color) \
+	((shade) << 12 | (depth) << 8 | (blend) << 4 | (color))
+
+/*
+** Depth test GL_LEQUAL and depth write. The stencil bits of a combined
+** depth/stencil buffer are preserved.
+*/
+static VPMT_INLINE GLboolean DepthTest(GLubyte * ptr, GLuint depth, GLuint format)
+{
+	GLuint value;
+
+	switch (format) {
+	case Depth16:
+		if (depth <= *(GLushort *) ptr) {
+			*(GLushort *) ptr = (GLushort) depth;
+			return GL_TRUE;
+		}
+
+		return GL_FALSE;
+
+	case Depth24Stencil8:
+		value = *(GLuint *) ptr;
+
+		if (depth <= value >> 8) {
+			*(GLuint *) ptr = (value & 0xff) | (depth << 8);
+			return GL_TRUE;
+		}
+
+		return GL_FALSE;
+
+	case Depth32:
+		if (depth <= *(GLuint *) ptr) {
+			*(GLuint *) ptr = depth;
+			return GL_TRUE;
+		}
+
+		return GL_FALSE;
+
+	default:
+		return GL_TRUE;
+	}
+}
+
+static VPMT_INLINE VPMT_Color4ub ReadColor(const GLubyte * ptr, GLuint format)
+{
+	switch (format) {
+	case Color565:
+		return VPMT_FrameUnpackColor565(*(const GLushort *) ptr);
+	case Color5551:
+		return VPMT_FrameUnpackColor5551(*(const GLushort *) ptr);
+	case Color4444:
+		return VPMT_FrameUnpackColor4444(*(const GLushort *) ptr);
+	case Color8888:
+		return VPMT_FrameUnpackColor8888(*(const GLuint *) ptr);
+	default:
+		return VPMT_FrameUnpackColor8888_REV(*(const GLuint *) ptr);
+	}
+}
+
+static VPMT_INLINE GLuint PackColor(VPMT_Color4ub color, GLuint format)
+{
+	switch (format) {
+	case Color565:
+		return VPMT_FramePackColor565(color);
+	case Color5551:
+		return VPMT_FramePackColor5551(color);
+	case Color4444:
+		return VPMT_FramePackColor4444(color);
+	case Color8888:
+		return VPMT_FramePackColor8888(color);
+	default:
+		return VPMT_FramePackColor8888_REV(color);
+	}
+}
+
+static VPMT_INLINE void WritePacked(GLubyte * ptr, GLuint value, GLuint format)
+{
+	if (format >= Color8888) {
+		*(GLuint *) ptr = value;
+	} else {
+		*(GLushort *) ptr = (GLushort) value;
+	}
+}
+
+static VPMT_INLINE void WriteColor(GLubyte * ptr, VPMT_Color4ub color, GLuint format)
+{
+	WritePacked(ptr, PackColor(color, format), format);
+}
+
+static VPMT_INLINE VPMT_Color4ub Shade(const VPMT_TexImageUnit * unit, const GLfloat * rgba,
+									   const GLfloat * texCoords, GLfloat rho, GLuint shade)
+{
+	VPMT_Color4us color, texColor;
+
+	if (shade == ShadeGouraud || shade == ShadeFlat) {
+		return VPMT_ConvertColor4usToColor4ub(VPMT_ConvertVec4ToColor4us(rgba));
+	}
+
+	texColor = unit->sampler2D(unit, texCoords, rho);
+
+	if (shade == ShadeModulate) {
+		color = VPMT_ConvertVec4ToColor4us(rgba);
+		color.red = VPMT_UShortMul(color.red, texColor.red);
+		color.green = VPMT_UShortMul(color.green, texColor.green);
+		color.blue = VPMT_UShortMul(color.blue, texColor.blue);
+		color.alpha = VPMT_UShortMul(color.alpha, texColor.alpha);
+	} else {
+		color = texColor;
+	}
+
+	return VPMT_ConvertColor4usToColor4ub(color);
+}
+
+static VPMT_INLINE VPMT_Color4ub Blend(VPMT_Color4ub oldColor, VPMT_Color4ub newColor)
+{
+	GLuint alpha256 = VPMT_Color255To256(newColor.alpha);
+
+	newColor.red = VPMT_UByteLerp(oldColor.red, newColor.red, alpha256);
+	newColor.green = VPMT_UByteLerp(oldColor.green, newColor.green, alpha256);
+	newColor.blue = VPMT_UByteLerp(oldColor.blue, newColor.blue, alpha256);
+	newColor.alpha = VPMT_UByteLerp(oldColor.alpha, newColor.alpha, alpha256);
+
+	return newColor;
+}
+
+/*
+** Perspective correct texture coordinates and rho at the start of a segment of
+** count pixels, and their increments for linear interpolation towards the
+** exact values at its end. This matches AffineSegmentInit in rasterpg.c.
+*/
+static VPMT_INLINE void SegmentInit(const VPMT_Span * span, GLfloat invW,
+									const GLfloat * texCoordsOverW, GLfloat rhoOverW2,
+									GLsizei count, GLfloat * texCoords, GLfloat * texCoordsDx,
+									GLfloat * rho, GLfloat * rhoDx)
+{
+	GLfloat W = 1.0f / invW, W2 = W * W, scale = 1.0f / count, delta = (GLfloat) count;
+	VPMT_Vec2 endTexCoordsOverW, endTexCoords;
+	GLfloat endRho;
+
+	VPMT_Vec2Scale(texCoords, texCoordsOverW, W);
+	*rho = rhoOverW2 * W2;
+
+	VPMT_Vec2ScaleAdd(endTexCoordsOverW, span->texCoordsDx, delta, texCoordsOverW);
+	W = 1.0f / (span->invWDx * delta + invW);
+	W2 = W * W;
+	VPMT_Vec2Scale(endTexCoords, endTexCoordsOverW, W);
+	endRho = (span->rhoDx * delta + rhoOverW2) * W2;
+
+	VPMT_Vec2Sub(endTexCoords, endTexCoords, texCoords);
+	VPMT_Vec2Scale(texCoordsDx, endTexCoords, scale);
+	*rhoDx = (endRho - *rho) * scale;
+}
+
+/*
+** The generic span loop. It produces the same fragments as the C
+** rasterizer with early depth test for the state described by the
+** parameters.
+*/
+static VPMT_INLINE void Span(const VPMT_Span * span, GLuint shade, GLuint depth, GLuint blend,
+							 GLuint color)
+{
+	GLubyte *colorPtr = span->color;
+	GLubyte *depthPtr = span->depthStencil;
+	GLsizei colorSize = color >= Color8888 ? 4 : 2;
+	GLsizei depthSize = depth == Depth16 ? 2 : 4;
+	GLboolean textured = shade == ShadeModulate || shade == ShadeReplace;
+	GLboolean gouraud = shade == ShadeGouraud || shade == ShadeModulate;
+	GLboolean affine = textured && span->perspectiveSpan > 1;
+	GLfloat z = span->depth, invW = span->invW, rho = span->rho;
+	GLfloat lod = 0.0f, lodDx = 0.0f, W, W2;
+	GLint x = span->x, end = span->x + span->length;
+	VPMT_Vec4 rgba;
+	VPMT_Vec2 texCoords, coords, coordsDx;
+	GLsizei count, remaining = 0;
+	GLuint packed = 0;
+
+	VPMT_Vec4Copy(rgba, span->rgba);
+	VPMT_Vec2Copy(texCoords, span->texCoords);
+
+	/* only set up per segment on the affine path */
+	coords[0] = coords[1] = 0.0f;
+	coordsDx[0] = coordsDx[1] = 0.0f;
+
+	if (shade == ShadeFlat) {
+		/* the color is constant across the span, so convert it only once */
+		packed = PackColor(Shade(span->unit, rgba, texCoords, rho, shade), color);
+
+		if (depth == DepthNone) {
+			if (colorSize == 4) {
+				VPMT_FrameFill32((GLuint *) colorPtr, span->length, packed);
+			} else {
+				VPMT_FrameFill16((GLushort *) colorPtr, span->length, (GLushort) packed);
+			}
+
+			return;
+		}
+	}
+
+	for (count = span->length; count > 0; --count) {
+		if (affine && !remaining) {
+			remaining = VPMT_MIN((x | (span->perspectiveSpan - 1)) + 1, end) - x;
+			SegmentInit(span, invW, texCoords, rho, remaining, coords, coordsDx, &lod, &lodDx);
+		}
+
+		if (shade == ShadeFlat) {
+			if (DepthTest(depthPtr, (GLuint) z, depth)) {
+				WritePacked(colorPtr, packed, color);
+			}
+		} else if (DepthTest(depthPtr, (GLuint) z, depth) && shade != ShadeNone) {
+			VPMT_Color4ub newColor;
+
+			if (textured && !affine) {
+				W = 1.0f / invW;
+				W2 = W * W;
+				VPMT_Vec2Scale(coords, texCoords, W);
+				lod = rho * W2;
+			}
+
+			newColor = Shade(span->unit, rgba, coords, lod, shade);
+
+			if (blend == BlendSrcAlpha) {
+				newColor = Blend(ReadColor(colorPtr, color), newColor);
+			}
+
+			WriteColor(colorPtr, newColor, color);
+		}
+
+		if (depth != DepthNone) {
+			z += span->depthDx;
+			depthPtr += depthSize;
+		}
+
+		if (gouraud) {
+			VPMT_Vec4Add(rgba, rgba, span->rgbaDx);
+		}
+
+		if (textured) {
+			invW += span->invWDx;
+			VPMT_Vec2Add(texCoords, texCoords, span->texCoordsDx);
+			rho += span->rhoDx;
+		}
+
+		if (affine) {
+			VPMT_Vec2Add(coords, coords, coordsDx);
+			lod += lodDx;
+			--remaining;
+			++x;
+		}
+
+		if (shade != ShadeNone) {
+			colorPtr += colorSize;
+		}
+	}
+}
+
+/*
+** -------------------------------------------------------------------------
+** Instantiation of the specialized span functions
+** -------------------------------------------------------------------------
+*/
+
+#define FOR_EACH_COLOR(F, shade, depth, blend) \
+	F(shade, depth, blend, Color565) \
+	F(shade, depth, blend, Color5551) \
+	F(shade, depth, blend, Color4444) \
+	F(shade, depth, blend, Color8888) \
+	F(shade, depth, blend, Color8888_REV)
+
+#define FOR_EACH_DEPTH_COLOR(F, shade, blend) \
+	FOR_EACH_COLOR(F, shade, Depth16, blend) \
+	FOR_EACH_COLOR(F, shade, Depth24Stencil8, blend) \
+	FOR_EACH_COLOR(F, shade, Depth32, blend)
+
+#define SPAN_FUNCTIONS(F) \
+	FOR_EACH_DEPTH_COLOR(F, ShadeGouraud, BlendNone) \
+	FOR_EACH_COLOR(F, ShadeGouraud, DepthNone, BlendNone) \
+	FOR_EACH_DEPTH_COLOR(F, ShadeFlat, BlendNone) \
+	FOR_EACH_COLOR(F, ShadeFlat, DepthNone, BlendNone) \
+	FOR_EACH_DEPTH_COLOR(F, ShadeModulate, BlendNone) \
+	FOR_EACH_COLOR(F, ShadeModulate, DepthNone, BlendNone) \
+	FOR_EACH_COLOR(F, ShadeReplace, DepthNone, BlendSrcAlpha) \
+	F(ShadeNone, Depth16, BlendNone, ColorNone) \
+	F(ShadeNone, Depth24Stencil8, BlendNone, ColorNone) \
+	F(ShadeNone, Depth32, BlendNone, ColorNone)
+
+#define SPAN_DEFINE(shade, depth, blend, color) \
+	static void Span##shade##depth##blend##color(const VPMT_Span * span) \
+	{ \
+		Span(span, shade, depth, blend, color); \
+	}
+
+#define SPAN_ENTRY(shade, depth, blend, color) \
+	{ SPAN_KEY(shade, depth, blend, color), Span##shade##depth##blend##color },
+
+SPAN_FUNCTIONS(SPAN_DEFINE)
+
+typedef struct SpanFunction {
+	GLuint key;
+	VPMT_RasterSpanFunc function;
+} SpanFunction;
+
+static const SpanFunction SpanFunctions[] = {
+	SPAN_FUNCTIONS(SPAN_ENTRY)
+};
+
+/*
+** -------------------------------------------------------------------------
+** Exported Functions
+** -------------------------------------------------------------------------
+*/
+
+static GLuint GetDepth(const VPMT_Context * context, GLboolean depthTest)
+{
+	if (!depthTest || !(context->rasterInterpolants & VPMT_RasterInterpolateDepth)) {
+		return DepthNone;
+	}
+
+	if (!context->depthTestEnabled || context->depthFunc != GL_LEQUAL ||
+		!context->depthWriteMask || !context->depthBits) {
+		return ~0u;
+	}
+
+	switch (context->writeSurface->depthStencilFormat->type) {
+	case VPMT_DEPTH_16:
+		return Depth16;
+	case VPMT_DEPTH_24_STENCIL_8:
+		return Depth24Stencil8;
+	case VPMT_DEPTH_32:
+		return Depth32;
+	default:
+		return ~0u;
+	}
+}
+
+static GLuint GetColor(const VPMT_Context * context)
+{
+	switch (context->writeSurface->image.pixelFormat->type) {
+	case GL_UNSIGNED_SHORT_5_6_5:
+		return Color565;
+	case GL_UNSIGNED_SHORT_5_5_5_1:
+		return Color5551;
+	case GL_UNSIGNED_SHORT_4_4_4_4:
+		return Color4444;
+#if (!VPMT_LITTLE_ENDIAN)
+	case GL_UNSIGNED_BYTE:
+#endif
+	case GL_UNSIGNED_INT_8_8_8_8:
+		return Color8888;
+#if (VPMT_LITTLE_ENDIAN)
+	case GL_UNSIGNED_BYTE:
+#endif
+	case GL_UNSIGNED_INT_8_8_8_8_REV:
+		return Color8888_REV;
+	default:
+		return ~0u;
+	}
+}
+
+static GLuint GetShade(const VPMT_Context * context)
+{
+	const VPMT_TexImageUnit *unit = context->texUnits;
+	GLenum baseFormat;
+
+	if (!unit->enabled) {
+		return context->shadeModel == GL_FLAT ? ShadeFlat : ShadeGouraud;
+	}
+
+	if (!(context->rasterInterpolants & VPMT_RasterInterpolateTexCoord0)) {
+		return ~0u;
+	}
+
+	baseFormat = unit->boundTexture->mipmaps[0]->pixelFormat->baseFormat;
+
+	if (unit->envMode == GL_MODULATE && baseFormat != GL_ALPHA && baseFormat != GL_COLOR_INDEX) {
+		return ShadeModulate;
+	} else if (unit->envMode == GL_REPLACE &&
+			   (baseFormat == GL_RGBA || baseFormat == GL_LUMINANCE_ALPHA)) {
+		return ShadeReplace;
+	} else {
+		return ~0u;
+	}
+}
+
+static VPMT_RasterSpanFunc GetFunction(const VPMT_Context * context, GLboolean depthTest)
+{
+	GLuint shade, depth, blend, color, key;
+	GLboolean hasEnabledColor, hasMaskedColor;
+	GLsizei index;
+
+	if (!context->writeSurface || context->stencilTestEnabled || context->alphaTestEnabled ||
+		context->polygonStippleEnabled) {
+		return NULL;
+	}
+
+	hasEnabledColor =
+		(context->redBits && context->colorWriteMask[0]) ||
+		(context->greenBits && context->colorWriteMask[1]) ||
+		(context->blueBits && context->colorWriteMask[2]) ||
+		(context->alphaBits && context->colorWriteMask[3]);
+
+	hasMaskedColor =
+		(context->redBits && !context->colorWriteMask[0]) ||
+		(context->greenBits && !context->colorWriteMask[1]) ||
+		(context->blueBits && !context->colorWriteMask[2]) ||
+		(context->alphaBits && !context->colorWriteMask[3]);
+
+	depth = GetDepth(context, depthTest);
+
+	if (!hasEnabledColor) {
+		shade = ShadeNone;
+		blend = BlendNone;
+		color = ColorNone;
+	} else if (hasMaskedColor) {
+		return NULL;
+	} else {
+		for (index = 1; index < VPMT_MAX_TEX_UNITS; ++index) {
+			if (context->texUnits[index].enabled) {
+				return NULL;
+			}
+		}
+
+		shade = GetShade(context);
+		color = GetColor(context);
+
+		if (!context->blendEnabled || context->blendSrcFactor == GL_ONE) {
+			blend = BlendNone;
+		} else if (context->blendSrcFactor == GL_SRC_ALPHA &&
+				   context->blendDstFactor == GL_ONE_MINUS_SRC_ALPHA) {
+			blend = BlendSrcAlpha;
+		} else {
+			return NULL;
+		}
+	}
+
+	if (shade == ~0u || depth == ~0u || color == ~0u) {
+		return NULL;
+	}
+
+	key = SPAN_KEY(shade, depth, blend, color);
+
+	for (index = 0; index < (GLsizei) (sizeof(SpanFunctions) / sizeof(SpanFunctions[0]));
+		 ++index) {
+		if (SpanFunctions[index].key == key) {
+			return SpanFunctions[index].function;
+		}
+	}
+
+	return NULL;
+}
+
+VPMT_RasterSpanFunc VPMT_SpanGetFunction(const VPMT_Context * context)
+{
+	return GetFunction(context, GL_TRUE);
+}
+
+VPMT_RasterSpanFunc VPMT_SpanGetColorFunction(const VPMT_Context * context)
+{
+	return GetFunction(context, GL_FALSE);
+}
+
+/* $Id: span.c 74 2008-11-23 07:25:12Z hmwill $ */
@@ -0,0 +1,51 @@
+/*
+** -------------------------------------------------------------------------
+** Vincent SC 1.0 Rendering Library
+**
+** Specialized span functions
+**
+** Copyright (C) 2008 Vincent Pervasive Media Technologies, LLC. 
+**
+** Licensed under the Artistic License 2.0.
+** -------------------------------------------------------------------------
+*/
+
+#ifndef VPMT_SPAN_H
+#define VPMT_SPAN_H
+
+#include "context.h"
+
+/*
+** Arguments passed to a span function. The span starts at the buffer
+** addresses given and extends length pixels in positive x.
+*/
+typedef struct VPMT_Span {
+	GLubyte *color;											   /* color buffer address */
+	GLubyte *depthStencil;									   /* depth/stencil buffer address */
+	GLsizei length;											   /* number of pixels */
+	GLfloat depth, depthDx;									   /* depth value and x increment */
+	VPMT_Vec4 rgba, rgbaDx;									   /* color value and x increment */
+	GLfloat invW, invWDx;									   /* 1/w and x increment */
+	VPMT_Vec2 texCoords, texCoordsDx;						   /* unit 0 coordinates over w */
+	GLfloat rho, rhoDx;										   /* unit 0 rho over w^2 */
+	const VPMT_TexImageUnit *unit;							   /* texture unit 0 */
+	GLint x;												   /* window x of the first pixel */
+	GLsizei perspectiveSpan;								   /* pixels per perspective division */
+} VPMT_Span;
+
+/*
+** Return the precompiled span function specialized for the current
+** rendering state. Returns NULL if there is no function for the state, in
+** which case the C rasterizer needs to be used.
+*/
+VPMT_RasterSpanFunc VPMT_SpanGetFunction(const VPMT_Context * context);
+
+/*
+** Return the precompiled span function for fragments that are known to
+** pass the depth test. The function writes the color buffer only.
+*/
+VPMT_RasterSpanFunc VPMT_SpanGetColorFunction(const VPMT_Context * context);
+
+#endif
+
+/* $Id: span.h 74 2008-11-23 07:25:12Z hmwill $ */
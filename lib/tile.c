@@ -0,0 +1,526 @@
+/*
+** -------------------------------------------------------------------------
+** Vincent SC 1.0 Rendering Library
+**
+** Tile-binned multi-threaded rasterizer
+**
+** Copyright (C) 2008 Vincent Pervasive Media Technologies, LLC. 
+**
+** Licensed under the Artistic License 2.0.
+** -------------------------------------------------------------------------
+*/
+
+#include "common.h"
+#include "GL/gl.h"
+#include "context.h"
+#include "raster.h"
+#include "tile.h"
+
+#if VPMT_RASTER_THREADS
+
+/*
+** -------------------------------------------------------------------------
+** Data structures
+**
+** Primitives are recorded in submission order into a single buffer. Each
+** screen tile keeps the list of indices of the primitives touching it, so
+** a tile replays its primitives in the same order as the serial path. As
+** tiles do not share pixels, and as the underlying rasterizers generate
+** the same fragments regardless of the clip rectangle, the result is
+** identical to rendering on the calling thread.
+** -------------------------------------------------------------------------
+*/
+
+typedef enum TilePrimitiveType {
+	TilePrimitivePoint,
+	TilePrimitiveLine,
+	TilePrimitiveTriangle
+} TilePrimitiveType;
+
+typedef struct TilePrimitive {
+	TilePrimitiveType type;
+	VPMT_RasterVertex vertices[3];
+} TilePrimitive;
+
+typedef struct TileBin {
+	GLuint *primitives;										   /* indices into primitive buffer */
+	GLsizei count;
+	GLsizei allocated;
+} TileBin;
+
+typedef struct TileWorker {
+	VPMT_Tiler *tiler;
+	VPMT_Thread thread;										   /* NULL for the calling thread */
+	VPMT_Context context;									   /* private copy of rendering state */
+} TileWorker;
+
+struct VPMT_Tiler {
+	/* rasterizer functions selected by VPMT_RasterPrepare* */
+	VPMT_RasterPointFunc rasterPoint;
+	VPMT_RasterLineFunc rasterLine;
+	VPMT_RasterTriangleFunc rasterTriangle;
+
+	/* primitives binned since the last flush */
+	TilePrimitive *primitives;
+	GLsizei numPrimitives;
+	GLsizei allocatedPrimitives;
+
+	/* tile grid covering the write surface */
+	TileBin *bins;
+	GLsizei tilesX, tilesY;
+	GLsizei allocatedBins;
+	VPMT_Rect rect;											   /* active surface rect at flush */
+
+	/* worker pool; worker 0 is executed on the calling thread */
+	TileWorker *workers;
+	GLsizei numWorkers;
+	VPMT_Mutex mutex;
+	VPMT_Semaphore start;
+	VPMT_Semaphore done;
+	GLsizei nextTile;										   /* next tile to hand out */
+	GLboolean terminate;
+};
+
+/*
+** -------------------------------------------------------------------------
+** Tile execution
+** -------------------------------------------------------------------------
+*/
+
+static void ExecuteTile(TileWorker * worker, GLsizei tile)
+{
+	VPMT_Tiler *tiler = worker->tiler;
+	VPMT_Context *context = &worker->context;
+	const TileBin *bin = tiler->bins + tile;
+	GLint minX = (tile % tiler->tilesX) * VPMT_TILE_SIZE;
+	GLint minY = (tile / tiler->tilesX) * VPMT_TILE_SIZE;
+	GLint maxX = minX + VPMT_TILE_SIZE;
+	GLint maxY = minY + VPMT_TILE_SIZE;
+	GLsizei index;
+
+	/* restrict pixel ownership to the intersection of tile and active surface rect */
+	minX = VPMT_MAX(minX, tiler->rect.origin[0]);
+	minY = VPMT_MAX(minY, tiler->rect.origin[1]);
+	maxX = VPMT_MIN(maxX, tiler->rect.origin[0] + tiler->rect.size.width);
+	maxY = VPMT_MIN(maxY, tiler->rect.origin[1] + tiler->rect.size.height);
+
+	if (minX >= maxX || minY >= maxY) {
+		return;
+	}
+
+	context->activeSurfaceRect.origin[0] = minX;
+	context->activeSurfaceRect.origin[1] = minY;
+	context->activeSurfaceRect.size.width = maxX - minX;
+	context->activeSurfaceRect.size.height = maxY - minY;
+
+	for (index = 0; index < bin->count; ++index) {
+		const TilePrimitive *primitive = tiler->primitives + bin->primitives[index];
+
+		switch (primitive->type) {
+		case TilePrimitivePoint:
+			tiler->rasterPoint(context, primitive->vertices);
+			break;
+
+		case TilePrimitiveLine:
+			tiler->rasterLine(context, primitive->vertices, primitive->vertices + 1);
+			break;
+
+		case TilePrimitiveTriangle:
+			tiler->rasterTriangle(context, primitive->vertices, primitive->vertices + 1,
+								  primitive->vertices + 2);
+			break;
+		}
+	}
+}
+
+static void ExecuteTiles(TileWorker * worker)
+{
+	VPMT_Tiler *tiler = worker->tiler;
+	GLsizei numTiles = tiler->tilesX * tiler->tilesY;
+	GLsizei tile;
+
+	for (;;) {
+		VPMT_MutexLock(tiler->mutex);
+		tile = tiler->nextTile++;
+		VPMT_MutexUnlock(tiler->mutex);
+
+		if (tile >= numTiles) {
+			break;
+		}
+
+		if (tiler->bins[tile].count) {
+			ExecuteTile(worker, tile);
+		}
+	}
+}
+
+static void WorkerMain(void *arg)
+{
+	TileWorker *worker = (TileWorker *) arg;
+	VPMT_Tiler *tiler = worker->tiler;
+
+	for (;;) {
+		VPMT_SemaphoreWait(tiler->start);
+
+		if (tiler->terminate) {
+			break;
+		}
+
+		ExecuteTiles(worker);
+		VPMT_SemaphorePost(tiler->done, 1);
+	}
+}
+
+/*
+** -------------------------------------------------------------------------
+** Binning
+** -------------------------------------------------------------------------
+*/
+
+static GLboolean ReserveBin(TileBin * bin)
+{
+	if (bin->count == bin->allocated) {
+		GLsizei allocated = bin->allocated ? bin->allocated * 2 : VPMT_TILE_BIN_SIZE_INIT;
+		GLuint *primitives = VPMT_REALLOC(bin->primitives, allocated * sizeof(GLuint));
+
+		if (!primitives) {
+			return GL_FALSE;
+		}
+
+		bin->primitives = primitives;
+		bin->allocated = allocated;
+	}
+
+	return GL_TRUE;
+}
+
+static GLboolean ReservePrimitive(VPMT_Tiler * tiler)
+{
+	if (tiler->numPrimitives == tiler->allocatedPrimitives) {
+		GLsizei allocated = tiler->allocatedPrimitives ?
+			tiler->allocatedPrimitives * 2 : VPMT_TILE_PRIMITIVES_INIT;
+		TilePrimitive *primitives =
+			VPMT_REALLOC(tiler->primitives, allocated * sizeof(TilePrimitive));
+
+		if (!primitives) {
+			return GL_FALSE;
+		}
+
+		tiler->primitives = primitives;
+		tiler->allocatedPrimitives = allocated;
+	}
+
+	return GL_TRUE;
+}
+
+static void RasterDirect(VPMT_Context * context, TilePrimitiveType type,
+						 const VPMT_RasterVertex * a, const VPMT_RasterVertex * b,
+						 const VPMT_RasterVertex * c)
+{
+	VPMT_Tiler *tiler = context->tiler;
+
+	switch (type) {
+	case TilePrimitivePoint:
+		tiler->rasterPoint(context, a);
+		break;
+
+	case TilePrimitiveLine:
+		tiler->rasterLine(context, a, b);
+		break;
+
+	case TilePrimitiveTriangle:
+		tiler->rasterTriangle(context, a, b, c);
+		break;
+	}
+}
+
+/*
+** Record a primitive covering the pixel rectangle bounds in all tiles it
+** overlaps.
+*/
+static void Bin(VPMT_Context * context, TilePrimitiveType type,
+				const VPMT_RasterVertex * a, const VPMT_RasterVertex * b,
+				const VPMT_RasterVertex * c, const VPMT_Rect * bounds)
+{
+	VPMT_Tiler *tiler = context->tiler;
+	const VPMT_Rect *rect = &context->activeSurfaceRect;
+	TilePrimitive *primitive;
+	GLint minX, minY, maxX, maxY;
+	GLint tileX, tileY, tileMinX, tileMinY, tileMaxX, tileMaxY;
+
+	minX = VPMT_MAX(bounds->origin[0], rect->origin[0]);
+	minY = VPMT_MAX(bounds->origin[1], rect->origin[1]);
+	maxX = VPMT_MIN(bounds->origin[0] + bounds->size.width, rect->origin[0] + rect->size.width);
+	maxY = VPMT_MIN(bounds->origin[1] + bounds->size.height, rect->origin[1] + rect->size.height);
+
+	if (minX >= maxX || minY >= maxY) {
+		/* no pixels owned */
+		return;
+	}
+
+	tileMinX = minX / VPMT_TILE_SIZE;
+	tileMinY = minY / VPMT_TILE_SIZE;
+	tileMaxX = (maxX - 1) / VPMT_TILE_SIZE;
+	tileMaxY = (maxY - 1) / VPMT_TILE_SIZE;
+
+	/* reserve all storage first so that a primitive is either binned completely or not at all */
+	if (!ReservePrimitive(tiler)) {
+		goto direct;
+	}
+
+	for (tileY = tileMinY; tileY <= tileMaxY; ++tileY) {
+		for (tileX = tileMinX; tileX <= tileMaxX; ++tileX) {
+			if (!ReserveBin(tiler->bins + tileY * tiler->tilesX + tileX)) {
+				goto direct;
+			}
+		}
+	}
+
+	primitive = tiler->primitives + tiler->numPrimitives;
+	primitive->type = type;
+	primitive->vertices[0] = *a;
+
+	if (b) {
+		primitive->vertices[1] = *b;
+	}
+
+	if (c) {
+		primitive->vertices[2] = *c;
+	}
+
+	for (tileY = tileMinY; tileY <= tileMaxY; ++tileY) {
+		for (tileX = tileMinX; tileX <= tileMaxX; ++tileX) {
+			TileBin *bin = tiler->bins + tileY * tiler->tilesX + tileX;
+			bin->primitives[bin->count++] = tiler->numPrimitives;
+		}
+	}
+
+	++tiler->numPrimitives;
+	return;
+
+  direct:
+	/* out of memory; fall back to rasterizing in order on the calling thread */
+	VPMT_TileFlush(context);
+	RasterDirect(context, type, a, b, c);
+}
+
+static void TileRasterPoint(VPMT_Context * context, const VPMT_RasterVertex * a)
+{
+	VPMT_Rect bounds;
+
+	VPMT_RasterPointBounds(context, a, &bounds);
+	Bin(context, TilePrimitivePoint, a, NULL, NULL, &bounds);
+}
+
+static void TileRasterLine(VPMT_Context * context, const VPMT_RasterVertex * a,
+						   const VPMT_RasterVertex * b)
+{
+	VPMT_Rect bounds;
+
+	VPMT_RasterLineBounds(context, a, b, &bounds);
+	Bin(context, TilePrimitiveLine, a, b, NULL, &bounds);
+}
+
+static void TileRasterTriangle(VPMT_Context * context, const VPMT_RasterVertex * a,
+							   const VPMT_RasterVertex * b, const VPMT_RasterVertex * c)
+{
+	VPMT_Rect bounds;
+
+	VPMT_RasterTriangleBounds(context, a, b, c, &bounds);
+	Bin(context, TilePrimitiveTriangle, a, b, c, &bounds);
+}
+
+/*
+** -------------------------------------------------------------------------
+** Exported functions
+** -------------------------------------------------------------------------
+*/
+
+VPMT_Tiler *VPMT_TilerAllocate(GLsizei numThreads)
+{
+	VPMT_Tiler *tiler = VPMT_MALLOC(sizeof(VPMT_Tiler));
+	GLsizei index;
+
+	if (!tiler) {
+		return NULL;
+	}
+
+	memset(tiler, 0, sizeof(VPMT_Tiler));
+
+	tiler->workers = VPMT_MALLOC(numThreads * sizeof(TileWorker));
+	tiler->mutex = VPMT_MutexCreate();
+	tiler->start = VPMT_SemaphoreCreate(0);
+	tiler->done = VPMT_SemaphoreCreate(0);
+
+	if (!tiler->workers || !tiler->mutex || !tiler->start || !tiler->done) {
+		goto cleanup;
+	}
+
+	for (index = 0; index < numThreads; ++index) {
+		TileWorker *worker = tiler->workers + index;
+
+		worker->tiler = tiler;
+		worker->thread = NULL;
+
+		if (index) {
+			worker->thread = VPMT_ThreadCreate(WorkerMain, worker);
+
+			if (!worker->thread) {
+				goto cleanup;
+			}
+		}
+
+		tiler->numWorkers = index + 1;
+	}
+
+	return tiler;
+
+  cleanup:
+	VPMT_TilerDeallocate(tiler);
+	return NULL;
+}
+
+void VPMT_TilerDeallocate(VPMT_Tiler * tiler)
+{
+	GLsizei index;
+
+	if (!tiler) {
+		return;
+	}
+
+	if (tiler->numWorkers > 1) {
+		tiler->terminate = GL_TRUE;
+		VPMT_SemaphorePost(tiler->start, tiler->numWorkers - 1);
+
+		for (index = 1; index < tiler->numWorkers; ++index) {
+			VPMT_ThreadJoin(tiler->workers[index].thread);
+		}
+	}
+
+	for (index = 0; index < tiler->allocatedBins; ++index) {
+		if (tiler->bins[index].primitives) {
+			VPMT_FREE(tiler->bins[index].primitives);
+		}
+	}
+
+	if (tiler->bins) {
+		VPMT_FREE(tiler->bins);
+	}
+
+	if (tiler->primitives) {
+		VPMT_FREE(tiler->primitives);
+	}
+
+	if (tiler->done) {
+		VPMT_SemaphoreDestroy(tiler->done);
+	}
+
+	if (tiler->start) {
+		VPMT_SemaphoreDestroy(tiler->start);
+	}
+
+	if (tiler->mutex) {
+		VPMT_MutexDestroy(tiler->mutex);
+	}
+
+	if (tiler->workers) {
+		VPMT_FREE(tiler->workers);
+	}
+
+	VPMT_FREE(tiler);
+}
+
+void VPMT_TilePrepare(VPMT_Context * context)
+{
+	VPMT_Tiler *tiler = context->tiler;
+	GLsizei tilesX, tilesY;
+
+	if (!tiler || tiler->numWorkers < 2 || !context->writeSurface) {
+		return;
+	}
+
+	tilesX = (context->writeSurface->image.size.width + VPMT_TILE_SIZE - 1) / VPMT_TILE_SIZE;
+	tilesY = (context->writeSurface->image.size.height + VPMT_TILE_SIZE - 1) / VPMT_TILE_SIZE;
+
+	if (tilesX * tilesY < 2) {
+		/* nothing to distribute */
+		return;
+	}
+
+	if (tilesX * tilesY > tiler->allocatedBins) {
+		TileBin *bins = VPMT_REALLOC(tiler->bins, tilesX * tilesY * sizeof(TileBin));
+
+		if (!bins) {
+			/* stay with the serial rasterizer */
+			return;
+		}
+
+		memset(bins + tiler->allocatedBins, 0,
+			   (tilesX * tilesY - tiler->allocatedBins) * sizeof(TileBin));
+		tiler->bins = bins;
+		tiler->allocatedBins = tilesX * tilesY;
+	}
+
+	tiler->tilesX = tilesX;
+	tiler->tilesY = tilesY;
+
+	switch (context->primitiveType) {
+	case GL_POINTS:
+		tiler->rasterPoint = context->rasterPoint;
+		context->rasterPoint = TileRasterPoint;
+		break;
+
+	case GL_LINES:
+		/*
+		 * Stippled lines carry the pattern position from one segment to the
+		 * next, and anti-aliased lines depend on the clip rectangle.
+		 */
+		if (!context->lineStippleEnabled && !context->lineSmoothEnabled) {
+			tiler->rasterLine = context->rasterLine;
+			context->rasterLine = TileRasterLine;
+		}
+
+		break;
+
+	case GL_TRIANGLES:
+		tiler->rasterTriangle = context->rasterTriangle;
+		context->rasterTriangle = TileRasterTriangle;
+		break;
+	}
+}
+
+void VPMT_TileFlush(VPMT_Context * context)
+{
+	VPMT_Tiler *tiler = context->tiler;
+	GLsizei index;
+
+	if (!tiler || !tiler->numPrimitives) {
+		return;
+	}
+
+	tiler->rect = context->activeSurfaceRect;
+
+	for (index = 0; index < tiler->numWorkers; ++index) {
+		memcpy(&tiler->workers[index].context, context, sizeof(VPMT_Context));
+	}
+
+	tiler->nextTile = 0;
+	VPMT_SemaphorePost(tiler->start, tiler->numWorkers - 1);
+
+	/* the calling thread participates as worker 0 */
+	ExecuteTiles(tiler->workers);
+
+	for (index = 1; index < tiler->numWorkers; ++index) {
+		VPMT_SemaphoreWait(tiler->done);
+	}
+
+	for (index = 0; index < tiler->tilesX * tiler->tilesY; ++index) {
+		tiler->bins[index].count = 0;
+	}
+
+	tiler->numPrimitives = 0;
+}
+
+#endif
+
+/* $Id: tile.c 74 2008-11-23 07:25:12Z hmwill $ */
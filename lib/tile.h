@@ -0,0 +1,49 @@
+/*
+** -------------------------------------------------------------------------
+** Vincent SC 1.0 Rendering Library
+**
+** Tile-binned multi-threaded rasterizer
+**
+** Copyright (C) 2008 Vincent Pervasive Media Technologies, LLC. 
+**
+** Licensed under the Artistic License 2.0.
+** -------------------------------------------------------------------------
+*/
+
+#ifndef VPMT_TILE_H
+#define VPMT_TILE_H
+
+#include "context.h"
+
+typedef struct VPMT_Tiler VPMT_Tiler;
+
+#if VPMT_RASTER_THREADS
+
+VPMT_Tiler *VPMT_TilerAllocate(GLsizei numThreads);
+void VPMT_TilerDeallocate(VPMT_Tiler * tiler);
+
+/*
+** Install the binning rasterizer functions in front of the rasterizer
+** selected for the current primitive type. Needs to be called after
+** the regular VPMT_RasterPrepare* function.
+*/
+void VPMT_TilePrepare(VPMT_Context * context);
+
+/*
+** Rasterize all primitives binned so far and wait for completion.
+*/
+void VPMT_TileFlush(VPMT_Context * context);
+
+#else
+
+/* without raster threads, primitives are always rasterized directly */
+#define VPMT_TilerAllocate(numThreads)	NULL
+#define VPMT_TilerDeallocate(tiler)
+#define VPMT_TilePrepare(context)
+#define VPMT_TileFlush(context)
+
+#endif
+
+#endif
+
+/* $Id: tile.h 74 2008-11-23 07:25:12Z hmwill $ */
@@ -234,6 +234,14 @@ static VPMT_INLINE GLubyte VPMT_UByteMul256(GLubyte a, GLuint b)
 	return ((a * b) + 0x80u) >> 8;
 }
 
+static VPMT_INLINE GLubyte VPMT_UByteLerp(GLubyte first, GLubyte second, GLuint lerp)
+{
+	GLint diff = (GLint) second - (GLint) first;
+	GLint scaledDiff = (diff * (GLint) lerp) >> 8;
+
+	return (GLubyte) ((GLint) first + scaledDiff);
+}
+
 static VPMT_INLINE VPMT_Color4ub VPMT_ConvertVec4ToColor4ub(const GLfloat * rgba)
 {
 	VPMT_Color4ub retval;
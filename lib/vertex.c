@@ -0,0 +1,396 @@
+/*
+** -------------------------------------------------------------------------
+** Vincent SC 1.0 Rendering Library
+**
+** Batched vertex transformation and lighting
+**
+** Copyright (C) 2008 Vincent Pervasive Media Technologies, LLC. 
+**
+** Licensed under the Artistic License 2.0.
+** -------------------------------------------------------------------------
+*/
+
+#include "common.h"
+#include "GL/gl.h"
+#include "context.h"
+#include "vertex.h"
+
+/*
+** -------------------------------------------------------------------------
+** Vertices are processed LANES at a time, one vertex per SIMD lane. The
+** arithmetic is performed in the same order as in the per-vertex functions
+** in render.c and light.c, so that both yield the same results; only the
+** reciprocal square root used to normalize normals is approximated.
+** -------------------------------------------------------------------------
+*/
+
+#if defined(VPMT_AVX)
+#	include <immintrin.h>
+
+#	define LANES					8
+
+typedef __m256 Lane;
+
+#	define LaneLoad(p)				_mm256_loadu_ps(p)
+#	define LaneStore(p, a)			_mm256_storeu_ps(p, a)
+#	define LaneSet(a)				_mm256_set1_ps(a)
+#	define LaneAdd(a, b)			_mm256_add_ps(a, b)
+#	define LaneSub(a, b)			_mm256_sub_ps(a, b)
+#	define LaneMul(a, b)			_mm256_mul_ps(a, b)
+#	define LaneMin(a, b)			_mm256_min_ps(a, b)
+#	define LaneMax(a, b)			_mm256_max_ps(a, b)
+#	define LaneLess(a, b)			_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LT_OQ))
+
+static VPMT_INLINE Lane LaneRsqrt(Lane a)
+{
+	/* one Newton-Raphson step on top of the hardware estimate */
+	Lane y = _mm256_rsqrt_ps(a);
+	Lane ayy = _mm256_mul_ps(_mm256_mul_ps(a, y), y);
+
+	return _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), y),
+						 _mm256_sub_ps(_mm256_set1_ps(3.0f), ayy));
+}
+
+#elif defined(VPMT_SSE2)
+#	include <emmintrin.h>
+
+#	define LANES					4
+
+typedef __m128 Lane;
+
+#	define LaneLoad(p)				_mm_loadu_ps(p)
+#	define LaneStore(p, a)			_mm_storeu_ps(p, a)
+#	define LaneSet(a)				_mm_set1_ps(a)
+#	define LaneAdd(a, b)			_mm_add_ps(a, b)
+#	define LaneSub(a, b)			_mm_sub_ps(a, b)
+#	define LaneMul(a, b)			_mm_mul_ps(a, b)
+#	define LaneMin(a, b)			_mm_min_ps(a, b)
+#	define LaneMax(a, b)			_mm_max_ps(a, b)
+#	define LaneLess(a, b)			_mm_movemask_ps(_mm_cmplt_ps(a, b))
+
+static VPMT_INLINE Lane LaneRsqrt(Lane a)
+{
+	/* one Newton-Raphson step on top of the hardware estimate */
+	Lane y = _mm_rsqrt_ps(a);
+	Lane ayy = _mm_mul_ps(_mm_mul_ps(a, y), y);
+
+	return _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), y), _mm_sub_ps(_mm_set1_ps(3.0f), ayy));
+}
+
+#else
+
+#	define LANES					1
+
+typedef GLfloat Lane;
+
+#	define LaneLoad(p)				(*(p))
+#	define LaneStore(p, a)			(*(p) = (a))
+#	define LaneSet(a)				(a)
+#	define LaneAdd(a, b)			((a) + (b))
+#	define LaneSub(a, b)			((a) - (b))
+#	define LaneMul(a, b)			((a) * (b))
+#	define LaneMin(a, b)			VPMT_MIN(a, b)
+#	define LaneMax(a, b)			VPMT_MAX(a, b)
+#	define LaneLess(a, b)			((a) < (b))
+#	define LaneRsqrt(a)				(1.0f / sqrtf(a))
+
+#endif
+
+#define LaneClamp(a)	LaneMin(LaneMax(a, LaneSet(0.0f)), LaneSet(1.0f))
+
+/*
+** Lanes of m[row] * x + m[row + 4] * y + m[row + 8] * z for a 4x4 matrix m
+*/
+static VPMT_INLINE Lane RowLanes(const GLfloat * m, GLsizei row, Lane x, Lane y, Lane z)
+{
+	return LaneAdd(LaneAdd(LaneMul(LaneSet(m[row]), x), LaneMul(LaneSet(m[row + 4]), y)),
+				   LaneMul(LaneSet(m[row + 8]), z));
+}
+
+static VPMT_INLINE Lane DotLanes(const GLfloat * v, const Lane * n)
+{
+	return LaneAdd(LaneAdd(LaneMul(LaneSet(v[0]), n[0]), LaneMul(LaneSet(v[1]), n[1])),
+				   LaneMul(LaneSet(v[2]), n[2]));
+}
+
+/*
+** Lit colors of the vertices first to first + LANES - 1 of the batch, which
+** is VPMT_LightVertex for directional lights. Specular exponentiation is
+** done per lane, and only for those lanes facing the light.
+*/
+static void LightLanes(VPMT_Context * context, const VPMT_VertexBatch * batch, GLsizei first,
+					   Lane * rgba, const Lane * normal)
+{
+	Lane ambientMaterial[4], diffuseMaterial[4];
+	GLsizei index, component;
+
+	for (component = 0; component < 4; ++component) {
+		if (context->colorMaterialEnabled) {
+			ambientMaterial[component] = LaneLoad(batch->colors[component] + first);
+			diffuseMaterial[component] = ambientMaterial[component];
+		} else {
+			ambientMaterial[component] = LaneSet(context->materialAmbient[component]);
+			diffuseMaterial[component] = LaneSet(context->materialDiffuse[component]);
+		}
+	}
+
+	/* alpha is always determined by alpha of diffuse material color */
+	rgba[3] = diffuseMaterial[3];
+
+	for (component = 0; component < 3; ++component) {
+		rgba[component] =
+			LaneAdd(LaneMul(ambientMaterial[component],
+							LaneSet(context->lightModelAmbient[component])),
+					LaneSet(context->materialEmission[component]));
+	}
+
+	for (index = 0; index < VPMT_MAX_LIGHTS; ++index) {
+		Lane dotProduct, highlight;
+		GLuint facing;
+
+		if (!context->lightEnabled[index]) {
+			continue;
+		}
+
+		dotProduct = DotLanes(context->lightDirection[index], normal);
+		facing = LaneLess(LaneSet(0.0f), dotProduct);
+
+		/* back facing lanes add a diffuse term of zero */
+		dotProduct = LaneMax(dotProduct, LaneSet(0.0f));
+
+		for (component = 0; component < 3; ++component) {
+			rgba[component] =
+				LaneAdd(LaneMul(ambientMaterial[component],
+								LaneSet(context->lightAmbient[index][component])), rgba[component]);
+			rgba[component] =
+				LaneAdd(LaneMul(LaneSet(context->lightDiffuse[index][component]),
+								LaneMul(diffuseMaterial[component], dotProduct)), rgba[component]);
+		}
+
+		highlight = DotLanes(context->lightHighlightDirection[index], normal);
+		facing &= LaneLess(LaneSet(0.0f), highlight);
+
+		if (facing) {
+			GLfloat factors[LANES];
+			GLsizei lane;
+			Lane factor;
+
+			LaneStore(factors, highlight);
+
+			for (lane = 0; lane < LANES; ++lane) {
+				factors[lane] = (facing & (1u << lane)) ?
+					VPMT_POWF(factors[lane], context->materialShininess) : 0.0f;
+			}
+
+			factor = LaneLoad(factors);
+
+			for (component = 0; component < 3; ++component) {
+				rgba[component] =
+					LaneAdd(LaneMul(LaneSet(context->lightSpecular[index][component]),
+									LaneMul(LaneSet(context->materialSpecular[component]),
+											factor)), rgba[component]);
+			}
+		}
+	}
+}
+
+/*
+** -------------------------------------------------------------------------
+** Exported functions
+** -------------------------------------------------------------------------
+*/
+
+void VPMT_VertexBatchTransform(VPMT_Context * context, const VPMT_VertexBatch * batch,
+							   VPMT_Vertex * vertices)
+{
+	const GLfloat *modelview =
+		context->modelviewMatrixStack.base[context->modelviewMatrixStack.current - 1];
+	const GLfloat *projection =
+		context->projectionMatrixStack.base[context->projectionMatrixStack.current - 1];
+	const GLfloat *inverseModelView = context->inverseModelView;
+	VPMT_Matrix scaledModelView, scaledInverseModelView;
+	GLboolean dequantizeTexCoords = GL_FALSE;
+	GLsizei first, component;
+
+	/* fold the dequantization of compact array formats into the matrices */
+	if (batch->coordScale != 1.0f) {
+		for (component = 0; component < 16; ++component) {
+			scaledModelView[component] =
+				component < 12 ? modelview[component] * batch->coordScale : modelview[component];
+		}
+
+		modelview = scaledModelView;
+	}
+
+	if (batch->normalScale != 1.0f && context->lightingEnabled) {
+		for (component = 0; component < 16; ++component) {
+			scaledInverseModelView[component] = inverseModelView[component] * batch->normalScale;
+		}
+
+		inverseModelView = scaledInverseModelView;
+	}
+
+	for (component = 0; component < VPMT_MAX_TEX_UNITS; ++component) {
+		dequantizeTexCoords |=
+			batch->texCoordScale[component] != 1.0f || batch->texCoordBias[component] != 0.0f;
+	}
+
+	for (first = 0; first < batch->count; first += LANES) {
+		Lane x = LaneLoad(batch->coords[0] + first);
+		Lane y = LaneLoad(batch->coords[1] + first);
+		Lane z = LaneLoad(batch->coords[2] + first);
+		Lane eyeCoords[4], clipCoords[4], rgba[4];
+		Lane negW;
+		GLfloat results[8][LANES];
+		GLuint cc[6];
+		GLsizei lane, count;
+
+		for (component = 0; component < 4; ++component) {
+			eyeCoords[component] =
+				LaneAdd(RowLanes(modelview, component, x, y, z),
+						LaneSet(modelview[component + 12]));
+		}
+
+		for (component = 0; component < 4; ++component) {
+			clipCoords[component] =
+				LaneAdd(RowLanes(projection, component, eyeCoords[0], eyeCoords[1], eyeCoords[2]),
+						LaneMul(LaneSet(projection[component + 12]), eyeCoords[3]));
+		}
+
+		if (context->lightingEnabled) {
+			Lane normal[3];
+
+			for (component = 0; component < 3; ++component) {
+				normal[component] =
+					RowLanes(inverseModelView, component,
+							 LaneLoad(batch->normals[0] + first),
+							 LaneLoad(batch->normals[1] + first),
+							 LaneLoad(batch->normals[2] + first));
+			}
+
+			if (context->normalizeEnabled || context->rescaleNormalEnabled) {
+				/* zero length normals are left unchanged */
+				Lane sqrLength = LaneAdd(LaneAdd(LaneMul(normal[0], normal[0]),
+												 LaneMul(normal[1], normal[1])),
+										 LaneMul(normal[2], normal[2]));
+				Lane factor = LaneRsqrt(LaneMax(sqrLength, LaneSet(FLT_MIN)));
+
+				normal[0] = LaneMul(normal[0], factor);
+				normal[1] = LaneMul(normal[1], factor);
+				normal[2] = LaneMul(normal[2], factor);
+			}
+
+			LightLanes(context, batch, first, rgba, normal);
+		} else {
+			for (component = 0; component < 4; ++component) {
+				rgba[component] = LaneLoad(batch->colors[component] + first);
+			}
+		}
+
+		/* clip codes, see CalcCC in render.c */
+		negW = LaneSub(LaneSet(0.0f), clipCoords[3]);
+
+		cc[0] = LaneLess(clipCoords[0], negW);
+		cc[1] = LaneLess(clipCoords[3], clipCoords[0]);
+		cc[2] = LaneLess(clipCoords[1], negW);
+		cc[3] = LaneLess(clipCoords[3], clipCoords[1]);
+		cc[4] = LaneLess(clipCoords[2], negW);
+		cc[5] = LaneLess(clipCoords[3], clipCoords[2]);
+
+		for (component = 0; component < 4; ++component) {
+			LaneStore(results[component], clipCoords[component]);
+			LaneStore(results[component + 4], LaneClamp(rgba[component]));
+		}
+
+		count = VPMT_MIN(LANES, batch->count - first);
+
+		for (lane = 0; lane < count; ++lane) {
+			VPMT_Vertex *vertex = vertices + first + lane;
+			GLsizei index;
+
+			for (component = 0; component < 4; ++component) {
+				vertex->vertex[component] = results[component][lane];
+				vertex->rgba[component] = results[component + 4][lane];
+			}
+
+			for (index = 0; index < VPMT_MAX_TEX_UNITS; ++index) {
+				vertex->texCoords[index][0] = batch->texCoords[index][0][first + lane];
+				vertex->texCoords[index][1] = batch->texCoords[index][1][first + lane];
+			}
+
+			if (dequantizeTexCoords) {
+				/* there is no texture matrix to fold scale and bias into */
+				for (index = 0; index < VPMT_MAX_TEX_UNITS; ++index) {
+					GLfloat scale = batch->texCoordScale[index], bias = batch->texCoordBias[index];
+
+					vertex->texCoords[index][0] = vertex->texCoords[index][0] * scale + bias;
+					vertex->texCoords[index][1] = vertex->texCoords[index][1] * scale + bias;
+				}
+			}
+
+			vertex->cc = 0;
+
+			for (index = 0; index < 6; ++index) {
+				vertex->cc |= ((cc[index] >> lane) & 1) << index;
+			}
+		}
+	}
+}
+
+void VPMT_VertexBatchAdd(VPMT_Context * context)
+{
+	VPMT_VertexBatch *batch = &context->vertexBatch;
+	GLsizei index = batch->count++, unit;
+
+	batch->coords[0][index] = context->vertex[0];
+	batch->coords[1][index] = context->vertex[1];
+	batch->coords[2][index] = context->vertex[2];
+
+	if (context->lightingEnabled) {
+		batch->normals[0][index] = context->normal[0];
+		batch->normals[1][index] = context->normal[1];
+		batch->normals[2][index] = context->normal[2];
+	}
+
+	batch->colors[0][index] = context->color[0];
+	batch->colors[1][index] = context->color[1];
+	batch->colors[2][index] = context->color[2];
+	batch->colors[3][index] = context->color[3];
+
+	for (unit = 0; unit < VPMT_MAX_TEX_UNITS; ++unit) {
+		batch->texCoords[unit][0][index] = context->texCoords[unit][0];
+		batch->texCoords[unit][1][index] = context->texCoords[unit][1];
+	}
+
+	if (batch->count == VPMT_VERTEX_BATCH) {
+		VPMT_VertexBatchFlush(context);
+	}
+}
+
+void VPMT_VertexBatchFlush(VPMT_Context * context)
+{
+	VPMT_VertexBatch *batch = &context->vertexBatch;
+
+	GLsizei index;
+
+	VPMT_VertexBatchTransform(context, batch, batch->vertices);
+
+	for (index = 0; index < batch->count; ++index) {
+		VPMT_VertexAssemble(context, batch->vertices + index);
+	}
+
+	batch->count = 0;
+}
+
+void VPMT_VertexAssemble(VPMT_Context * context, const VPMT_Vertex * vertex)
+{
+	context->vertexBatch.current = vertex;
+	context->vertexFunction(context);
+}
+
+void VPMT_VertexBatchFetch(VPMT_Context * context, VPMT_Vertex * vertex)
+{
+	*vertex = *context->vertexBatch.current;
+}
+
+/* $Id: vertex.c 74 2008-11-23 07:25:12Z hmwill $ */
@@ -0,0 +1,52 @@
+/*
+** -------------------------------------------------------------------------
+** Vincent SC 1.0 Rendering Library
+**
+** Batched vertex transformation and lighting
+**
+** Copyright (C) 2008 Vincent Pervasive Media Technologies, LLC. 
+**
+** Licensed under the Artistic License 2.0.
+** -------------------------------------------------------------------------
+*/
+
+#ifndef VPMT_VERTEX_H
+#define VPMT_VERTEX_H
+
+#include "context.h"
+
+/*
+** Append the current vertex and its attributes to the vertex batch of the
+** context, flushing the batch once it is full.
+*/
+void VPMT_VertexBatchAdd(VPMT_Context * context);
+
+/*
+** Transform, light and determine the clip codes of all vertices collected
+** in the vertex batch, and pass them on to primitive assembly in order.
+** Needs to be called before the end of a primitive, and before any state
+** affecting vertex processing changes between begin and end.
+*/
+void VPMT_VertexBatchFlush(VPMT_Context * context);
+
+/*
+** Transform, light and determine the clip codes of the vertices collected
+** in batch, storing the results in the array vertices.
+*/
+void VPMT_VertexBatchTransform(VPMT_Context * context, const VPMT_VertexBatch * batch,
+							   VPMT_Vertex * vertices);
+
+/*
+** Pass an already transformed vertex on to primitive assembly.
+*/
+void VPMT_VertexAssemble(VPMT_Context * context, const VPMT_Vertex * vertex);
+
+/*
+** Transformation function used between begin and end; it hands out the
+** vertex currently passed on to primitive assembly.
+*/
+void VPMT_VertexBatchFetch(VPMT_Context * context, VPMT_Vertex * vertex);
+
+#endif
+
+/* $Id: vertex.h 74 2008-11-23 07:25:12Z hmwill $ */
@@ -14,6 +14,11 @@
 #include "GL/gl.h"
 #include "context.h"
 #include "exec.h"
+#include "tile.h"
+#include "clear.h"
+#include "hiz.h"
+#include "zplane.h"
+#include "frame.h"
 #include "GL/vgl.h"
 #include <SDL.h>
 
@@ -38,10 +43,16 @@ static void ReleaseSurface(struct VPMT_Surface *surface)
 			SDL_FreeSurface(wrapper->sdlSurface);
 		}
 
+		if (wrapper->surface.colorBuffer) {
+			VPMT_FREE(wrapper->surface.colorBuffer);
+		}
+
 		if (wrapper->surface.depthStencilBuffer) {
 			VPMT_FREE(wrapper->surface.depthStencilBuffer);
 		}
 
+		VPMT_HiZDeinit(&wrapper->surface);
+		VPMT_ZPlaneDeinit(&wrapper->surface);
 		VPMT_FREE(wrapper);
 	}
 }
@@ -123,7 +134,10 @@ vglCreateSurface(GLsizei width, GLsizei height, GLenum format, GLenum type, GLen
 
 		wrapper->surface.vtbl = &Vtbl;
 		wrapper->sdlSurface = NULL;
+		wrapper->surface.colorBuffer = NULL;
 		wrapper->surface.depthStencilBuffer = NULL;
+		wrapper->surface.hiZ.blocks = NULL;
+		wrapper->surface.depthPlanes.blocks = NULL;
 
 		wrapper->sdlSurface =
 			SDL_CreateRGBSurface(0, width, height, pixelFormat->bits,
@@ -143,14 +157,30 @@ vglCreateSurface(GLsizei width, GLsizei height, GLenum format, GLenum type, GLen
 		VPMT_Image2DInit(&wrapper->surface.image, pixelFormat,
 						 -(GLsizei) wrapper->sdlSurface->pitch, width, height, baseAddr);
 
+#if VPMT_TILED_SURFACE
+		/* rendering uses a tiled copy of the color buffer, see frame.h */
+		wrapper->surface.colorBuffer =
+			VPMT_MALLOC(VPMT_FrameBufferBytes(width, height, pixelFormat->size));
+
+		if (!wrapper->surface.colorBuffer) {
+			goto error;
+		}
+#endif
+
 		wrapper->surface.depthStencilFormat = depthStencilFormat;
 		wrapper->surface.depthStencilBuffer =
-			VPMT_MALLOC(height * width * (depthStencilFormat->bits / VPMT_BITS_PER_BYTE));
+			VPMT_MALLOC(VPMT_FrameBufferBytes(width, height,
+											  depthStencilFormat->bits / VPMT_BITS_PER_BYTE));
 
 		if (!wrapper->surface.depthStencilBuffer) {
 			goto error;
 		}
 
+		if (!VPMT_HiZInit(&wrapper->surface) || !VPMT_ZPlaneInit(&wrapper->surface)) {
+			goto error;
+		}
+
+		VPMT_ClearInit(&wrapper->surface);
 		wrapper->surface.refcount = 1;
 
 		return (VGL_Surface) & wrapper->surface;
@@ -162,10 +192,16 @@ vglCreateSurface(GLsizei width, GLsizei height, GLenum format, GLenum type, GLen
 			SDL_FreeSurface(wrapper->sdlSurface);
 		}
 
+		if (wrapper->surface.colorBuffer) {
+			VPMT_FREE(wrapper->surface.colorBuffer);
+		}
+
 		if (wrapper->surface.depthStencilBuffer) {
 			VPMT_FREE(wrapper->surface.depthStencilBuffer);
 		}
 
+		VPMT_HiZDeinit(&wrapper->surface);
+		VPMT_ZPlaneDeinit(&wrapper->surface);
 		VPMT_FREE(wrapper);
 	}
 
@@ -175,6 +211,16 @@ vglCreateSurface(GLsizei width, GLsizei height, GLenum format, GLenum type, GLen
 GLAPI GLboolean APIENTRY vglSwapBuffers(SDL_Surface * display, VGL_Surface surface)
 {
 	SdlSurfaceWrapper *wrapper = (SdlSurfaceWrapper *) surface;
+	VPMT_Context *context = VPMT_CONTEXT();
+
+	VPMT_TileFlush(context);
+
+	if (VPMT_ClearPending(&wrapper->surface) || wrapper->surface.colorBuffer) {
+		LockSurface(context, &wrapper->surface);
+		VPMT_ClearResolve(&wrapper->surface, NULL);
+		VPMT_FrameUpdateImage(&wrapper->surface, NULL);
+		UnlockSurface(context, &wrapper->surface);
+	}
 
 	if (!SDL_BlitSurface(wrapper->sdlSurface, NULL, display, NULL) && !SDL_Flip(display)) {
 		return GL_TRUE;
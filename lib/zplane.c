@@ -0,0 +1,268 @@
+/*
+** -------------------------------------------------------------------------
+** Vincent SC 1.0 Rendering Library
+**
+** Plane compressed depth buffer blocks
+**
+** Copyright (C) 2008 Vincent Pervasive Media Technologies, LLC. 
+**
+** Licensed under the Artistic License 2.0.
+** -------------------------------------------------------------------------
+*/
+
+#include "common.h"
+#include "GL/gl.h"
+#include "context.h"
+#include "raster.h"
+#include "frame.h"
+#include "span.h"
+#include "clear.h"
+#include "zplane.h"
+
+/*
+** -------------------------------------------------------------------------
+** The depth buffer uses the blocks of the hierarchical depth buffer. A
+** compressed block is described by the plane equation of the triangle
+** that has written it last, and the depth buffer memory of the block is
+** not accessed. Clearing the depth buffer compresses all blocks inside of
+** the cleared area. A triangle that covers a compressed block completely
+** and is nearer than the block everywhere replaces the plane of the block,
+** any other access to the block decompresses it first. Decompression
+** repeats the depth interpolation of the rasterizer, so the depth values
+** are the same as if the block had never been compressed.
+** -------------------------------------------------------------------------
+*/
+
+/*
+** Intersection of a block and the surface area
+*/
+static void BlockRect(const VPMT_Surface * surface, GLint blockX, GLint blockY, VPMT_Rect * rect)
+{
+	rect->origin[0] = blockX << VPMT_HIZ_BLOCK_BITS;
+	rect->origin[1] = blockY << VPMT_HIZ_BLOCK_BITS;
+	rect->size.width = VPMT_MIN(VPMT_HIZ_BLOCK_SIZE, surface->image.size.width - rect->origin[0]);
+	rect->size.height =
+		VPMT_MIN(VPMT_HIZ_BLOCK_SIZE, surface->image.size.height - rect->origin[1]);
+}
+
+static GLboolean ContainsRect(const VPMT_Rect * outer, const VPMT_Rect * inner)
+{
+	return
+		inner->origin[0] >= outer->origin[0] &&
+		inner->origin[1] >= outer->origin[1] &&
+		inner->origin[0] + inner->size.width <= outer->origin[0] + outer->size.width &&
+		inner->origin[1] + inner->size.height <= outer->origin[1] + outer->size.height;
+}
+
+/*
+** Intersection of rect and the surface area. Returns GL_FALSE if empty.
+*/
+static GLboolean ClipRect(const VPMT_Surface * surface, const VPMT_Rect * rect,
+						  VPMT_Rect * result)
+{
+	VPMT_Rect surfaceRect;
+
+	surfaceRect.origin[0] = 0;
+	surfaceRect.origin[1] = 0;
+	surfaceRect.size = surface->image.size;
+
+	if (rect) {
+		VPMT_IntersectRect(result, rect, &surfaceRect);
+	} else {
+		*result = surfaceRect;
+	}
+
+	return result->size.width > 0 && result->size.height > 0;
+}
+
+/*
+** Write the depth values of a compressed block. The framebuffer is
+** positioned at the origin of the surface.
+*/
+static void DecompressBlock(VPMT_Surface * surface, VPMT_FrameBuffer * fb,
+							VPMT_DepthPlane * plane, GLint blockX, GLint blockY)
+{
+	VPMT_Rect rect;
+	GLint x, row;
+
+	BlockRect(surface, blockX, blockY, &rect);
+	VPMT_FrameBufferMove(fb, rect.origin[0], rect.origin[1]);
+
+	for (row = 0; row < rect.size.height; ++row) {
+		GLint start = rect.origin[0] - plane->start[row];
+		GLfloat depth = plane->depth;
+
+		/* same sequence of operations as RowDepth */
+		depth += plane->dx * (GLfloat) start + plane->dy * (GLfloat) (rect.origin[1] + row);
+
+		for (x = start; x < rect.origin[0]; ++x) {
+			depth += plane->dx;
+		}
+
+		VPMT_FrameBufferSave(fb);
+
+		for (x = 0; x < rect.size.width; ++x) {
+			fb->writeDepth(fb, (GLuint) depth);
+			depth += plane->dx;
+			VPMT_FrameBufferStepX(fb);
+		}
+
+		VPMT_FrameBufferRestore(fb);
+		VPMT_FrameBufferStepY(fb);
+	}
+
+	VPMT_FrameBufferMove(fb, -rect.origin[0], -(rect.origin[1] + rect.size.height));
+	plane->compressed = GL_FALSE;
+}
+
+/*
+** -------------------------------------------------------------------------
+** Exported functions
+** -------------------------------------------------------------------------
+*/
+
+GLboolean VPMT_ZPlaneInit(VPMT_Surface * surface)
+{
+	VPMT_DepthPlaneState *state = &surface->depthPlanes;
+	GLsizei index;
+
+	state->width = (surface->image.size.width + VPMT_HIZ_BLOCK_SIZE - 1) >> VPMT_HIZ_BLOCK_BITS;
+	state->height = (surface->image.size.height + VPMT_HIZ_BLOCK_SIZE - 1) >> VPMT_HIZ_BLOCK_BITS;
+	state->blocks = NULL;
+
+	/* the block rasterizer marks the blocks of a row in a fixed size bit mask */
+	if (!VPMT_DEPTH_PLANES || surface->image.size.width > VPMT_MAX_VIEWPORT_WIDTH) {
+		return GL_TRUE;
+	}
+
+	state->blocks = VPMT_MALLOC(state->width * state->height * sizeof(VPMT_DepthPlane));
+
+	if (!state->blocks) {
+		return GL_FALSE;
+	}
+
+	for (index = 0; index < state->width * state->height; ++index) {
+		state->blocks[index].compressed = GL_FALSE;
+	}
+
+	return GL_TRUE;
+}
+
+void VPMT_ZPlaneDeinit(VPMT_Surface * surface)
+{
+	if (surface->depthPlanes.blocks) {
+		VPMT_FREE(surface->depthPlanes.blocks);
+		surface->depthPlanes.blocks = NULL;
+	}
+}
+
+void VPMT_ZPlaneClear(VPMT_Surface * surface, const VPMT_Rect * rect, GLuint depth)
+{
+	VPMT_DepthPlaneState *state = &surface->depthPlanes;
+	GLint blockX, blockY, blockMinX, blockMinY, blockMaxX, blockMaxY;
+	VPMT_Rect blockRect;
+	VPMT_FrameBuffer fb;
+
+	if (!state->blocks || rect->size.width <= 0 || rect->size.height <= 0) {
+		return;
+	}
+
+	VPMT_FrameBufferInit(&fb, surface);
+
+	blockMinX = rect->origin[0] >> VPMT_HIZ_BLOCK_BITS;
+	blockMinY = rect->origin[1] >> VPMT_HIZ_BLOCK_BITS;
+	blockMaxX = (rect->origin[0] + rect->size.width - 1) >> VPMT_HIZ_BLOCK_BITS;
+	blockMaxY = (rect->origin[1] + rect->size.height - 1) >> VPMT_HIZ_BLOCK_BITS;
+
+	for (blockY = blockMinY; blockY <= blockMaxY; ++blockY) {
+		VPMT_DepthPlane *plane = state->blocks + blockY * state->width + blockMinX;
+
+		for (blockX = blockMinX; blockX <= blockMaxX; ++blockX, ++plane) {
+			BlockRect(surface, blockX, blockY, &blockRect);
+
+			if (ContainsRect(rect, &blockRect)) {
+				plane->depth = (GLfloat) depth;
+				plane->dx = plane->dy = 0.0f;
+				memset(plane->start, 0, sizeof(plane->start));
+				plane->compressed = GL_TRUE;
+			} else if (plane->compressed) {
+				/* the pixels outside of rect keep their depth values */
+				VPMT_ClearResolve(surface, &blockRect);
+				DecompressBlock(surface, &fb, plane, blockX, blockY);
+			}
+		}
+	}
+}
+
+void VPMT_ZPlaneResolve(VPMT_Surface * surface, const VPMT_Rect * rect)
+{
+	VPMT_DepthPlaneState *state = &surface->depthPlanes;
+	GLint blockX, blockY, blockMinX, blockMinY, blockMaxX, blockMaxY;
+	VPMT_FrameBuffer fb;
+	VPMT_Rect clipped;
+
+	if (!state->blocks || !ClipRect(surface, rect, &clipped)) {
+		return;
+	}
+
+	/* decompressed values must not be overwritten by a pending clear */
+	VPMT_ClearResolve(surface, &clipped);
+	VPMT_FrameBufferInit(&fb, surface);
+
+	blockMinX = clipped.origin[0] >> VPMT_HIZ_BLOCK_BITS;
+	blockMinY = clipped.origin[1] >> VPMT_HIZ_BLOCK_BITS;
+	blockMaxX = (clipped.origin[0] + clipped.size.width - 1) >> VPMT_HIZ_BLOCK_BITS;
+	blockMaxY = (clipped.origin[1] + clipped.size.height - 1) >> VPMT_HIZ_BLOCK_BITS;
+
+	for (blockY = blockMinY; blockY <= blockMaxY; ++blockY) {
+		VPMT_DepthPlane *plane = state->blocks + blockY * state->width + blockMinX;
+
+		for (blockX = blockMinX; blockX <= blockMaxX; ++blockX, ++plane) {
+			if (plane->compressed) {
+				DecompressBlock(surface, &fb, plane, blockX, blockY);
+			}
+		}
+	}
+}
+
+void VPMT_ZPlaneDecompress(VPMT_Surface * surface, GLint x, GLint y)
+{
+	VPMT_FrameBuffer fb;
+
+	VPMT_FrameBufferInit(&fb, surface);
+	DecompressBlock(surface, &fb, VPMT_ZPlaneBlock(surface, x, y),
+					x >> VPMT_HIZ_BLOCK_BITS, y >> VPMT_HIZ_BLOCK_BITS);
+}
+
+void VPMT_ZPlanePrepare(VPMT_Context * context)
+{
+	VPMT_Surface *surface = context->writeSurface;
+
+	context->depthPlaneMode = GL_FALSE;
+	context->rasterColorSpan = NULL;
+
+	if (!surface || !surface->depthPlanes.blocks) {
+		return;
+	}
+
+	if (context->primitiveType != GL_TRIANGLES) {
+		VPMT_ZPlaneResolve(surface, &context->activeSurfaceRect);
+		return;
+	}
+
+	/* a replaced plane must describe every pixel of the block */
+	if (!context->depthTestEnabled || !context->depthWriteMask || context->stencilTestEnabled ||
+		context->alphaTestEnabled || context->polygonStippleEnabled ||
+		!(context->rasterInterpolants & VPMT_RasterInterpolateDepth) ||
+		(context->depthFunc != GL_LESS && context->depthFunc != GL_LEQUAL)) {
+		return;
+	}
+
+	context->depthPlaneMode = GL_TRUE;
+
+	if (context->rasterSpan) {
+		context->rasterColorSpan = VPMT_SpanGetColorFunction(context);
+	}
+}
+
+/* $Id: zplane.c 74 2008-11-23 07:25:12Z hmwill $ */
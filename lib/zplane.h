@@ -0,0 +1,75 @@
+/*
+** -------------------------------------------------------------------------
+** Vincent SC 1.0 Rendering Library
+**
+** Plane compressed depth buffer blocks
+**
+** Copyright (C) 2008 Vincent Pervasive Media Technologies, LLC. 
+**
+** Licensed under the Artistic License 2.0.
+** -------------------------------------------------------------------------
+*/
+
+#ifndef VPMT_ZPLANE_H
+#define VPMT_ZPLANE_H
+
+#include "context.h"
+
+/*
+** Allocate the depth planes of a newly created surface. Initially, all
+** blocks are stored uncompressed.
+*/
+GLboolean VPMT_ZPlaneInit(VPMT_Surface * surface);
+
+/*
+** Release the depth planes of a surface.
+*/
+void VPMT_ZPlaneDeinit(VPMT_Surface * surface);
+
+/*
+** Update the depth planes of the locked surface for a clear of the depth
+** buffer within rect. Blocks inside of rect are compressed, blocks
+** intersecting the border of rect are decompressed. Needs to be called
+** before the depth buffer memory within rect is written.
+*/
+void VPMT_ZPlaneClear(VPMT_Surface * surface, const VPMT_Rect * rect, GLuint depth);
+
+/*
+** Write the depth values of all compressed blocks of the locked surface
+** that intersect rect, or of all compressed blocks if rect is NULL. Needs
+** to be called before the depth values within rect are accessed.
+*/
+void VPMT_ZPlaneResolve(VPMT_Surface * surface, const VPMT_Rect * rect);
+
+/*
+** Write the depth values of a compressed block, given by the coordinates
+** of its top-left pixel. Pending clears of the block need to be resolved
+** already.
+*/
+void VPMT_ZPlaneDecompress(VPMT_Surface * surface, GLint x, GLint y);
+
+/*
+** Select whether triangles that cover a compressed block completely can
+** replace its plane, and resolve the active surface rect for other types
+** of primitives. Needs to be called after VPMT_RasterPrepare*.
+*/
+void VPMT_ZPlanePrepare(VPMT_Context * context);
+
+/*
+** Depth plane of the block containing pixel (x, y), or NULL if the surface
+** does not use depth planes
+*/
+static VPMT_INLINE VPMT_DepthPlane *VPMT_ZPlaneBlock(const VPMT_Surface * surface, GLint x,
+													  GLint y)
+{
+	if (!surface->depthPlanes.blocks) {
+		return NULL;
+	}
+
+	return surface->depthPlanes.blocks +
+		(y >> VPMT_HIZ_BLOCK_BITS) * surface->depthPlanes.width + (x >> VPMT_HIZ_BLOCK_BITS);
+}
+
+#endif
+
+/* $Id: zplane.h 74 2008-11-23 07:25:12Z hmwill $ */
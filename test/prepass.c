@@ -0,0 +1,319 @@
+/*
+** -------------------------------------------------------------------------
+** Vincent SC 1.0 Rendering Library
+**
+** Depth prepass test
+**
+** Renders a scene of overlapping triangles into the depth buffer only, and
+** then again with color writes and depth function GL_LEQUAL. Every pixel
+** covered by the scene needs to be drawn by the second pass, which requires
+** all rasterization paths to generate identical depth values for a
+** fragment, independent of the blocks culled by the hierarchical depth
+** test. The flat shaded scene is also rendered through a grid of scissor
+** rectangles that are not aligned to the blocks of the rasterizer, which
+** needs to reproduce the image rendered in one go. The prepass project of
+** the solution builds the test like the demo and runs it after linking; the
+** program returns EXIT_FAILURE if pixels are missing or differ.
+**
+** Copyright (C) 2008 Vincent Pervasive Media Technologies, LLC.
+**
+** Licensed under the Artistic License 2.0.
+** -------------------------------------------------------------------------
+*/
+
+#include <SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "GL/gl.h"
+#include "GL/vgl.h"
+
+#define WIDTH			517
+#define HEIGHT			301
+#define GRID			16
+#define TRIANGLES		300
+#define MAX_VERTICES	(GRID * GRID * 6 + TRIANGLES * 3)
+#define CELL_WIDTH		61
+#define CELL_HEIGHT		37
+
+static GLfloat vertices[MAX_VERTICES * 3];
+static GLfloat colors[MAX_VERTICES * 4];
+static GLfloat texCoords[MAX_VERTICES * 2];
+static GLsizei numVertices;
+static GLubyte pixels[WIDTH * HEIGHT * 4];
+static GLubyte reference[WIDTH * HEIGHT * 4];
+
+static unsigned seed;
+
+static GLfloat Random(void)
+{
+	seed = seed * 1103515245u + 12345u;
+	return ((seed >> 8) & 0xffff) * (1.0f / 65535.0f);
+}
+
+static void AddVertex(GLfloat x, GLfloat y, GLfloat z, GLfloat s, GLfloat t)
+{
+	GLfloat *vertex = vertices + numVertices * 3;
+	GLfloat *color = colors + numVertices * 4;
+	GLfloat *texCoord = texCoords + numVertices * 2;
+
+	vertex[0] = x;
+	vertex[1] = y;
+	vertex[2] = z;
+
+	/* never black, so that every pixel drawn can be counted */
+	color[0] = 0.2f + 0.8f * Random();
+	color[1] = 0.2f + 0.8f * Random();
+	color[2] = 0.2f + 0.8f * Random();
+	color[3] = 1.0f;
+
+	texCoord[0] = s;
+	texCoord[1] = t;
+
+	++numVertices;
+}
+
+/*
+** A ground grid in perspective, and randomly placed triangles intersecting
+** each other and the ground.
+*/
+static void CreateScene(void)
+{
+	static const GLfloat corners[6][2] = {
+		{0, 0}, {1, 0}, {0, 1}, {1, 0}, {1, 1}, {0, 1}
+	};
+
+	GLint x, z, index;
+
+	seed = 7;
+	numVertices = 0;
+
+	for (z = 0; z < GRID; ++z) {
+		for (x = 0; x < GRID; ++x) {
+			for (index = 0; index < 6; ++index) {
+				GLfloat vx = x - GRID / 2 + corners[index][0];
+				GLfloat vz = -1.5f * (z + corners[index][1]);
+				GLfloat vy = -1.5f + 0.3f * (GLfloat) sin(vx * 0.7f + z + corners[index][1]);
+
+				AddVertex(vx, vy, vz, vx * 0.37f, vz * 0.29f);
+			}
+		}
+	}
+
+	for (index = 0; index < TRIANGLES; ++index) {
+		GLfloat cx = Random() * 16.0f - 8.0f;
+		GLfloat cy = Random() * 5.0f - 2.0f;
+		GLfloat cz = -1.5f - Random() * 20.0f;
+		GLint corner;
+
+		for (corner = 0; corner < 3; ++corner) {
+			GLfloat vx = cx + Random() * 3.0f - 1.5f;
+			GLfloat vy = cy + Random() * 3.0f - 1.5f;
+			GLfloat vz = cz + Random() * 4.0f - 2.0f;
+
+			AddVertex(vx, vy, vz, Random() * 4.0f, Random() * 4.0f);
+		}
+	}
+}
+
+static void CreateTexture(void)
+{
+	static GLubyte texels[64 * 64 * 4];
+	GLuint name;
+	GLint index, level, size;
+
+	for (index = 0; index < 64 * 64; ++index) {
+		texels[index * 4 + 0] = (GLubyte) (64 + (index * 37) % 192);
+		texels[index * 4 + 1] = (GLubyte) (64 + (index * 91) % 192);
+		texels[index * 4 + 2] = (GLubyte) (64 + (index * 13) % 192);
+		texels[index * 4 + 3] = 255;
+	}
+
+	glGenTextures(1, &name);
+	glBindTexture(GL_TEXTURE_2D, name);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+
+	for (level = 0, size = 64; size; ++level, size >>= 1) {
+		glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+					 texels);
+	}
+}
+
+static void DrawScene(GLboolean textured)
+{
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(3, GL_FLOAT, 0, vertices);
+	glColorPointer(4, GL_FLOAT, 0, colors);
+
+	if (textured) {
+		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		glTexCoordPointer(2, GL_FLOAT, 0, texCoords);
+		glEnable(GL_TEXTURE_2D);
+	}
+
+	glDrawArrays(GL_TRIANGLES, 0, numVertices);
+
+	glDisable(GL_TEXTURE_2D);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+}
+
+static GLsizei CountDrawnPixels(void)
+{
+	GLsizei index, count = 0;
+
+	glReadPixels(0, 0, WIDTH, HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+	for (index = 0; index < WIDTH * HEIGHT; ++index) {
+		if (pixels[index * 4] | pixels[index * 4 + 1] | pixels[index * 4 + 2]) {
+			++count;
+		}
+	}
+
+	return count;
+}
+
+/*
+** Render the scene, either in a single pass without depth test, or as depth
+** prepass followed by a GL_LEQUAL color pass, and count the pixels drawn.
+** With cells set, the scene is rendered once per scissor rectangle of a grid
+** covering the surface.
+*/
+static GLsizei Render(GLboolean prepass, GLboolean textured, GLenum hint, GLboolean cells)
+{
+	GLsizei width = cells ? CELL_WIDTH : WIDTH, height = cells ? CELL_HEIGHT : HEIGHT;
+	GLint x, y;
+
+	glHint(GL_PERSPECTIVE_CORRECTION_HINT, hint);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	if (cells) {
+		glEnable(GL_SCISSOR_TEST);
+	}
+
+	for (y = 0; y < HEIGHT; y += height) {
+		for (x = 0; x < WIDTH; x += width) {
+			glScissor(x, y, width, height);
+
+			if (prepass) {
+				glEnable(GL_DEPTH_TEST);
+				glDepthFunc(GL_LESS);
+				glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+				DrawScene(GL_FALSE);
+
+				glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+				glDepthFunc(GL_LEQUAL);
+				glDepthMask(GL_FALSE);
+				DrawScene(textured);
+
+				glDepthMask(GL_TRUE);
+				glDisable(GL_DEPTH_TEST);
+			} else {
+				DrawScene(textured);
+			}
+		}
+	}
+
+	glDisable(GL_SCISSOR_TEST);
+
+	return CountDrawnPixels();
+}
+
+/*
+** Number of pixels that differ from the reference image
+*/
+static GLsizei CountChangedPixels(void)
+{
+	GLsizei index, count = 0;
+
+	for (index = 0; index < WIDTH * HEIGHT; ++index) {
+		if (memcmp(pixels + index * 4, reference + index * 4, 3)) {
+			++count;
+		}
+	}
+
+	return count;
+}
+
+int main(int argc, char *argv[])
+{
+	static const GLenum hints[] = { GL_DONT_CARE, GL_NICEST, GL_FASTEST };
+	static const char *depthNames[] = { "16", "24/8", "32" };
+
+	GLint depthType, textured, hint;
+	int result = EXIT_SUCCESS;
+
+	vglInitialize();
+	CreateScene();
+	CreateTexture();
+
+	/* depth/stencil types 16, 24 + 8 stencil and 32 bits */
+	for (depthType = 0; depthType < 3; ++depthType) {
+		VGL_Surface surface =
+			vglCreateSurface(WIDTH, HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, depthType);
+		GLsizei changed;
+
+		if (!surface) {
+			fprintf(stderr, "cannot create surface\n");
+			return EXIT_FAILURE;
+		}
+
+		vglMakeCurrent(surface, surface);
+
+		glViewport(0, 0, WIDTH, HEIGHT);
+		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+		glMatrixMode(GL_PROJECTION);
+		glLoadIdentity();
+		glFrustumf(-0.8f, 0.8f, -0.5f, 0.5f, 1.0f, 30.0f);
+		glMatrixMode(GL_MODELVIEW);
+		glLoadIdentity();
+		glRotatef(8.0f, 1.0f, 0.0f, 0.0f);
+
+		for (textured = 0; textured < 2; ++textured) {
+			for (hint = 0; hint < 3; ++hint) {
+				GLsizei covered = Render(GL_FALSE, (GLboolean) textured, hints[hint], GL_FALSE);
+				GLsizei drawn = Render(GL_TRUE, (GLboolean) textured, hints[hint], GL_FALSE);
+
+				if (drawn != covered || !covered) {
+					fprintf(stderr, "depth %s, %s, hint 0x%x: %d of %d pixels drawn\n",
+							depthNames[depthType], textured ? "textured" : "untextured",
+							hints[hint], (int) drawn, (int) covered);
+					result = EXIT_FAILURE;
+				}
+			}
+		}
+
+		/*
+		 * colors and texture coordinates are interpolated from the scissor
+		 * edges; with flat shading, only the triangle visible at a pixel counts
+		 */
+		glShadeModel(GL_FLAT);
+		Render(GL_TRUE, GL_FALSE, GL_DONT_CARE, GL_FALSE);
+		memcpy(reference, pixels, sizeof(pixels));
+		Render(GL_TRUE, GL_FALSE, GL_DONT_CARE, GL_TRUE);
+		changed = CountChangedPixels();
+		glShadeModel(GL_SMOOTH);
+
+		if (changed) {
+			fprintf(stderr, "depth %s: %d pixels differ with scissor\n",
+					depthNames[depthType], (int) changed);
+			result = EXIT_FAILURE;
+		}
+
+		vglMakeCurrent(NULL, NULL);
+		vglDestroySurface(surface);
+	}
+
+	vglTerminate();
+
+	if (result == EXIT_SUCCESS) {
+		printf("prepass: all covered pixels drawn, scissored images identical\n");
+	}
+
+	return result;
+}
+
+/* $Id: prepass.c 74 2008-11-23 07:25:12Z hmwill $ */